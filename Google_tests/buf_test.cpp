@@ -25,12 +25,21 @@
  * For more information, please refer to <http://unlicense.org/>
  */
 
+#include <map>
+#include <thread>
+#include <vector>
 #include "gtest/gtest.h"
 #include "../buf_macros.h"
 #include "test_data.h"
 
 makeBufOfTypeApi(Vec3, struct Vec3_T)
 makeBufOfTypeImpl(Vec3, struct Vec3_T);
+makeChunkedBufOfTypeApi(Vec3, struct Vec3_T)
+makeChunkedBufOfTypeImpl(Vec3, struct Vec3_T)
+makeSlotMapApi(Vec3, struct Vec3_T)
+makeSlotMapImpl(Vec3, struct Vec3_T, alignof(struct Vec3_T))
+makeFrameRingApi(Vec3, struct Vec3_T)
+makeFrameRingImpl(Vec3, struct Vec3_T, 3)
 
 TEST(buf_test, create_buf) {
     buf_Vec3 buf = buf_Vec3_new(CACHE_LINE_SIZE);
@@ -151,4 +160,304 @@ TEST(buf_test, emplace_back) {
     EXPECT_EQ(3, buf_Vec3_lim(buf));
 
     buf_Vec3_free(buf);
-}
\ No newline at end of file
+}
+static col_error_t buf_normalize(buf_Vec3 v, size_t i, void *pUserData) {
+    Vec3 e = nullptr;
+    col_error_t err = buf_Vec3_get(v, i, &e);
+    if (err == COL_OK) {
+        e->a = (float) i;
+        e->b = 1.0f;
+        e->c = -1.0f;
+    }
+    return err;
+}
+
+static col_error_t buf_sum_a(buf_Vec3 v, size_t first, size_t last, void *pPartial, void *pUserData) {
+    Vec3 e = nullptr;
+    for (size_t i = first; i < last; ++i) {
+        buf_Vec3_get(v, i, &e);
+        *((double *) pPartial) += e->a + e->b + e->c;
+    }
+    return COL_OK;
+}
+
+static void buf_sum_combine(void *pResult, const void *pPartial, void *pUserData) {
+    *((double *) pResult) += *((const double *) pPartial);
+}
+
+TEST(buf_test, parallel_each_and_reduce) {
+    buf_Vec3 buf = buf_Vec3_new(CACHE_LINE_SIZE);
+    ice_thread_pool pool = ice_thread_pool_new(3);
+    const size_t n = 10000;
+
+    EXPECT_EQ(COL_OK, buf_Vec3_reserve(buf, n));
+    buf_Vec3_set_lim(buf, n);
+    EXPECT_EQ(COL_OK, buf_Vec3_parallel_each(buf, pool, 7, buf_normalize, nullptr));
+
+    double sum = 0.0;
+    EXPECT_EQ(COL_OK, buf_Vec3_parallel_reduce(buf, pool, 7, &sum, sizeof(sum), buf_sum_a, buf_sum_combine, nullptr));
+    EXPECT_EQ((double) n * (n - 1) / 2, sum);
+
+    ice_thread_pool_free(pool);
+    buf_Vec3_free(buf);
+}
+
+TEST(buf_test, bulk_copy_and_pack) {
+    buf_Vec3 buf = buf_Vec3_new(16);
+    struct Vec3_T src[5];
+    for (int i = 0; i < 5; ++i) {
+        src[i].a = (float) i;
+        src[i].b = (float) (i * 2);
+        src[i].c = (float) (i * 3);
+    }
+
+    EXPECT_EQ(COL_OK, buf_Vec3_copy_from(buf, src, 5));
+    EXPECT_EQ(5, buf_Vec3_lim(buf));
+    Vec3 e = nullptr;
+    EXPECT_EQ(COL_OK, buf_Vec3_get(buf, 4, &e));
+    EXPECT_EQ(buf->data + 4 * 16, (char *) e);
+    EXPECT_EQ(12.0f, e->c);
+
+    Vec3 first = nullptr;
+    EXPECT_EQ(COL_OK, buf_Vec3_emplace_n(buf, 3, &first));
+    EXPECT_EQ(8, buf_Vec3_lim(buf));
+    EXPECT_EQ(buf->data + 5 * 16, (char *) first);
+    for (int i = 0; i < 3; ++i) {
+        Vec3 f = (Vec3) ((char *) first + i * buf->alignedSize);
+        f->a = f->b = f->c = -1.0f;
+    }
+
+    struct Vec3_T packed[8];
+    EXPECT_EQ(8 * sizeof(struct Vec3_T), buf_Vec3_pack_into(buf, packed));
+    EXPECT_EQ(0, memcmp(src, packed, sizeof(src)));
+    EXPECT_EQ(-1.0f, packed[7].b);
+
+    EXPECT_EQ(COL_OK, buf_Vec3_resize(buf, 2));
+    EXPECT_EQ(2, buf_Vec3_lim(buf));
+    EXPECT_EQ(COL_OK, buf_Vec3_resize(buf, 4));
+    EXPECT_EQ(COL_OK, buf_Vec3_get(buf, 3, &e));
+    EXPECT_EQ(0.0f, e->a);
+    EXPECT_EQ(0.0f, e->c);
+
+    buf_Vec3_free(buf);
+}
+
+TEST(buf_test, memset_range_and_secure_zero) {
+    buf_Vec3 buf = buf_Vec3_new(16);
+    EXPECT_EQ(COL_OK, buf_Vec3_resize(buf, 10));
+    EXPECT_EQ(COL_OK, buf_Vec3_memset_range(buf, 2, 8, 0xff));
+    EXPECT_EQ(COL_ERR_OVERFLOW, buf_Vec3_memset_range(buf, 3, 8, 0));
+    EXPECT_EQ(COL_ERR_OVERFLOW, buf_Vec3_memset_range(buf, 11, 0, 0));
+    EXPECT_EQ((char) 0, buf->data[2 * 16 - 1]);
+    EXPECT_EQ((char) 0xff, buf->data[2 * 16]);
+    EXPECT_EQ((char) 0xff, buf->data[10 * 16 - 1]);
+
+    buf_Vec3_secure_zero(buf);
+    EXPECT_EQ(10, buf_Vec3_lim(buf));
+    for (size_t i = 0; i < buf->cap * buf->alignedSize; ++i) {
+        ASSERT_EQ(0, buf->data[i]);
+    }
+
+    buf_Vec3_free(buf);
+}
+
+TEST(cbuf_test, stable_addresses) {
+    cbuf_Vec3 buf = cbuf_Vec3_new(CACHE_LINE_SIZE, 100);
+    EXPECT_EQ(128, cbuf_Vec3_block_len(buf));
+    EXPECT_EQ(CACHE_LINE_SIZE, buf->alignedSize);
+
+    Vec3 e = nullptr;
+    EXPECT_EQ(COL_ERR_UNDERFLOW, cbuf_Vec3_back(buf, &e));
+    EXPECT_EQ(COL_ERR_OVERFLOW, cbuf_Vec3_get(buf, 0, &e));
+
+    std::vector<Vec3> handed_out;
+    for (int i = 0; i < 10000; ++i) {
+        EXPECT_EQ(COL_OK, cbuf_Vec3_emplace_back(buf, &e));
+        EXPECT_TRUE(ice_is_aligned(e, CACHE_LINE_SIZE));
+        e->a = (float) i;
+        handed_out.push_back(e);
+    }
+    EXPECT_EQ(10000, cbuf_Vec3_lim(buf));
+    EXPECT_EQ(79 * 128, buf->cap);
+
+    // growing never moved an entry
+    for (int i = 0; i < 10000; ++i) {
+        EXPECT_EQ(COL_OK, cbuf_Vec3_get(buf, i, &e));
+        ASSERT_EQ(handed_out[i], e);
+        ASSERT_EQ((float) i, e->a);
+        ASSERT_EQ(e, cbuf_Vec3_at(buf, i));
+    }
+    EXPECT_EQ(COL_OK, cbuf_Vec3_back(buf, &e));
+    EXPECT_EQ(handed_out.back(), e);
+
+    // clear keeps the blocks, entries are reused in place
+    cbuf_Vec3_clear(buf);
+    EXPECT_TRUE(cbuf_Vec3_empty(buf));
+    EXPECT_EQ(COL_OK, cbuf_Vec3_emplace_back(buf, &e));
+    EXPECT_EQ(handed_out[0], e);
+    cbuf_Vec3_set_lim(buf, 100000);
+    EXPECT_EQ(buf->cap, cbuf_Vec3_lim(buf));
+
+    cbuf_Vec3_free(buf);
+
+    // default block size
+    buf = cbuf_Vec3_new(alignof(struct Vec3_T), 0);
+    EXPECT_EQ(512, cbuf_Vec3_block_len(buf));
+    cbuf_Vec3_free(buf);
+}
+
+TEST(slotmap_test, insert_remove_lookup) {
+    slotmap_Vec3 m = slotmap_Vec3_new();
+    std::map<ice_slot_handle, float> live;
+    std::vector<ice_slot_handle> removed;
+    ice_slot_handle handle = ICE_SLOT_NULL;
+    Vec3 e = nullptr;
+
+    EXPECT_FALSE(slotmap_Vec3_contains(m, ICE_SLOT_NULL));
+    EXPECT_EQ(COL_ERR_ILLEGAL_ARGUMENT, slotmap_Vec3_get(m, ICE_SLOT_NULL, &e));
+
+    srand(17);
+    for (int i = 0; i < 20000; ++i) {
+        if (live.empty() || rand() % 3 != 0) {
+            EXPECT_EQ(COL_OK, slotmap_Vec3_insert(m, &e, &handle));
+            EXPECT_NE(ICE_SLOT_NULL, handle);
+            e->a = (float) i;
+            ASSERT_EQ(0, live.count(handle));
+            live[handle] = (float) i;
+        } else {
+            auto it = live.begin();
+            std::advance(it, rand() % live.size());
+            EXPECT_EQ(COL_OK, slotmap_Vec3_remove(m, it->first));
+            removed.push_back(it->first);
+            live.erase(it);
+        }
+        ASSERT_EQ(live.size(), slotmap_Vec3_len(m));
+    }
+
+    for (auto &l: live) {
+        EXPECT_EQ(COL_OK, slotmap_Vec3_get(m, l.first, &e));
+        EXPECT_EQ(l.second, e->a);
+    }
+    // stale handles are rejected even though their slots were reused
+    for (auto h: removed) {
+        EXPECT_FALSE(slotmap_Vec3_contains(m, h));
+        EXPECT_EQ(COL_ERR_ILLEGAL_ARGUMENT, slotmap_Vec3_remove(m, h));
+    }
+    // dense iteration visits every live entry once
+    double sum = 0.0, expected = 0.0;
+    for (size_t i = 0; i < slotmap_Vec3_len(m); ++i) {
+        sum += slotmap_Vec3_at(m, i)->a;
+        EXPECT_EQ(1, live.count(slotmap_Vec3_handle_at(m, i)));
+    }
+    for (auto &l: live) {
+        expected += l.second;
+    }
+    EXPECT_EQ(expected, sum);
+
+    // no allocation in steady state
+    const size_t cap = m->slots_cap;
+    struct ice_slot *slots = m->slots;
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(COL_OK, slotmap_Vec3_remove(m, slotmap_Vec3_handle_at(m, 0)));
+        EXPECT_EQ(COL_OK, slotmap_Vec3_insert(m, &e, &handle));
+    }
+    EXPECT_EQ(cap, m->slots_cap);
+    EXPECT_EQ(slots, m->slots);
+
+    slotmap_Vec3_clear(m);
+    EXPECT_TRUE(slotmap_Vec3_empty(m));
+    for (auto &l: live) {
+        EXPECT_FALSE(slotmap_Vec3_contains(m, l.first));
+    }
+
+    slotmap_Vec3_free(m);
+}
+
+TEST(fring_test, frames_and_retire) {
+    fring_Vec3 r = fring_Vec3_new(16, 4);
+    ASSERT_NE(nullptr, r);
+    EXPECT_EQ(3, fring_Vec3_frames(r));
+    EXPECT_EQ(0, fring_Vec3_frame(r));
+
+    Vec3 a = nullptr, b = nullptr;
+    EXPECT_EQ(COL_OK, fring_Vec3_alloc(r, 3, &a));
+    EXPECT_EQ(COL_OK, fring_Vec3_alloc(r, 1, &b));
+    EXPECT_EQ((char *) a + 3 * 16, (char *) b);
+    EXPECT_EQ(COL_ERR_OVERFLOW, fring_Vec3_alloc(r, 1, &b));
+    size_t len = 0;
+    EXPECT_EQ(a, fring_Vec3_region(r, &len));
+    EXPECT_EQ(4, len);
+    EXPECT_EQ(0, fring_Vec3_offset(r, a));
+    Vec3 frame0 = a;
+
+    uint64_t frame = 0;
+    EXPECT_EQ(COL_ERR_ILLEGAL_ARGUMENT, fring_Vec3_retire(r, 0));
+    EXPECT_EQ(COL_OK, fring_Vec3_begin_frame(r, &frame));
+    EXPECT_EQ(1, frame);
+    EXPECT_EQ(0, fring_Vec3_used(r));
+    EXPECT_EQ(COL_OK, fring_Vec3_alloc(r, 1, &a));
+    EXPECT_NE(frame0, a);
+    EXPECT_TRUE(ice_is_aligned(a, CACHE_LINE_SIZE));
+    EXPECT_EQ(COL_OK, fring_Vec3_begin_frame(r, &frame));
+    EXPECT_EQ(2, frame);
+
+    /* frame 3 would reuse the region of frame 0 which is still in flight */
+    EXPECT_EQ(COL_ERR_OVERFLOW, fring_Vec3_begin_frame(r, &frame));
+    EXPECT_EQ(COL_OK, fring_Vec3_retire(r, 0));
+    EXPECT_EQ(COL_OK, fring_Vec3_begin_frame(r, &frame));
+    EXPECT_EQ(3, frame);
+    EXPECT_EQ(COL_OK, fring_Vec3_alloc(r, 2, &a));
+    EXPECT_EQ(frame0, a);
+
+    /* retiring frame 2 retires frame 1 as well */
+    EXPECT_EQ(COL_OK, fring_Vec3_retire(r, 2));
+    EXPECT_EQ(COL_OK, fring_Vec3_begin_frame(r, &frame));
+    EXPECT_EQ(COL_OK, fring_Vec3_begin_frame(r, &frame));
+    EXPECT_EQ(5, frame);
+    EXPECT_EQ(COL_ERR_OVERFLOW, fring_Vec3_begin_frame(r, &frame));
+
+    fring_Vec3_free(r);
+}
+
+TEST(fring_test, concurrent_alloc) {
+    const size_t threads = 4;
+    const size_t per_thread = 1000;
+    fring_Vec3 r = fring_Vec3_new(alignof(struct Vec3_T), threads * per_thread);
+    ASSERT_NE(nullptr, r);
+
+    for (int round = 0; round < 5; ++round) {
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([r, t, per_thread]() {
+                for (size_t i = 0; i < per_thread; ++i) {
+                    Vec3 e = nullptr;
+                    ASSERT_EQ(COL_OK, fring_Vec3_alloc(r, 1, &e));
+                    e->a = (float) t;
+                    e->b = (float) i;
+                }
+            });
+        }
+        for (auto &w: workers) {
+            w.join();
+        }
+
+        size_t len = 0;
+        Vec3 region = fring_Vec3_region(r, &len);
+        EXPECT_EQ(threads * per_thread, len);
+        std::map<size_t, size_t> counts;
+        for (size_t i = 0; i < len; ++i) {
+            counts[(size_t) region[i].a]++;
+        }
+        for (size_t t = 0; t < threads; ++t) {
+            EXPECT_EQ(per_thread, counts[t]);
+        }
+
+        uint64_t frame = 0;
+        EXPECT_EQ(COL_OK, fring_Vec3_begin_frame(r, &frame));
+        if (frame >= 2) {
+            EXPECT_EQ(COL_OK, fring_Vec3_retire(r, frame - 2));
+        }
+    }
+
+    fring_Vec3_free(r);
+}
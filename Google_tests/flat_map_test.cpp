@@ -0,0 +1,119 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
+#include <map>
+#include "gtest/gtest.h"
+#include "../ice_flat_map_macros.h"
+
+#define int_less(a, b) ((a) < (b))
+
+makeFlatMapApi(int_int, int, int)
+makeFlatMapImpl(int_int, int, int, int_less)
+
+static col_error_t sum_each(int key, int val, void *pUserData) {
+    *((long *) pUserData) += key * 1000 + val;
+    return COL_OK;
+}
+
+TEST(fmap, BuildAndGet) {
+    fmap_int_int m = fmap_int_int_new();
+    int val = 0;
+
+    EXPECT_EQ(COL_OK, fmap_int_int_build(m));
+    EXPECT_EQ(0, fmap_int_int_len(m));
+    EXPECT_EQ(COL_ERR_ILLEGAL_ARGUMENT, fmap_int_int_get(m, 1, &val));
+
+    std::map<int, int> expected;
+    srand(3);
+    for (int i = 0; i < 1000; ++i) {
+        int k = rand() % 300;
+        EXPECT_EQ(COL_OK, fmap_int_int_add(m, k, i));
+        expected[k] = i;
+    }
+    EXPECT_EQ(COL_OK, fmap_int_int_build(m));
+    EXPECT_EQ(expected.size(), fmap_int_int_len(m));
+
+    // last added value wins for duplicate keys
+    size_t i = 0;
+    for (auto &e: expected) {
+        EXPECT_EQ(e.first, fmap_int_int_keys(m)[i]);
+        EXPECT_EQ(e.second, fmap_int_int_values(m)[i]);
+        i++;
+    }
+    for (int k = -1; k <= 301; ++k) {
+        auto it = expected.find(k);
+        EXPECT_EQ(it != expected.end(), fmap_int_int_contains(m, k));
+        if (it != expected.end()) {
+            EXPECT_EQ(COL_OK, fmap_int_int_get(m, k, &val));
+            EXPECT_EQ(it->second, val);
+        } else {
+            EXPECT_EQ(COL_ERR_ILLEGAL_ARGUMENT, fmap_int_int_get(m, k, &val));
+        }
+    }
+
+    long sum = 0, expected_sum = 0;
+    for (auto &e: expected) {
+        expected_sum += e.first * 1000 + e.second;
+    }
+    EXPECT_EQ(COL_OK, fmap_int_int_each(m, sum_each, &sum));
+    EXPECT_EQ(expected_sum, sum);
+
+    fmap_int_int_free(m);
+}
+
+TEST(fmap, PutAndErase) {
+    fmap_int_int m = fmap_int_int_new();
+    int val = 0;
+
+    EXPECT_EQ(COL_OK, fmap_int_int_put(m, 5, 50));
+    EXPECT_EQ(COL_OK, fmap_int_int_put(m, 1, 10));
+    EXPECT_EQ(COL_OK, fmap_int_int_put(m, 3, 30));
+    EXPECT_EQ(COL_OK, fmap_int_int_put(m, 3, 31));
+    EXPECT_EQ(3, fmap_int_int_len(m));
+    EXPECT_EQ(1, fmap_int_int_keys(m)[0]);
+    EXPECT_EQ(3, fmap_int_int_keys(m)[1]);
+    EXPECT_EQ(5, fmap_int_int_keys(m)[2]);
+    EXPECT_EQ(COL_OK, fmap_int_int_get(m, 3, &val));
+    EXPECT_EQ(31, val);
+
+    EXPECT_EQ(COL_ERR_ILLEGAL_ARGUMENT, fmap_int_int_erase(m, 4));
+    EXPECT_EQ(COL_OK, fmap_int_int_erase(m, 1));
+    EXPECT_EQ(2, fmap_int_int_len(m));
+    EXPECT_FALSE(fmap_int_int_contains(m, 1));
+    EXPECT_EQ(COL_OK, fmap_int_int_get(m, 5, &val));
+    EXPECT_EQ(50, val);
+
+    // already sorted adds don't need a rebuild
+    fmap_int_int_clear(m);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(COL_OK, fmap_int_int_add(m, i, -i));
+    }
+    EXPECT_TRUE(fmap_int_int_contains(m, 99));
+    EXPECT_EQ(COL_OK, fmap_int_int_put(m, 200, 1));
+    EXPECT_EQ(101, fmap_int_int_len(m));
+
+    fmap_int_int_free(m);
+}
@@ -214,4 +214,4 @@ TEST(Hashtable, BetterHashTest) {
     EXPECT_EQ(0, ht_better_int_len(ht));
 
     ht_better_int_free(ht);
-}
\ No newline at end of file
+}
@@ -0,0 +1,140 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
+#include <atomic>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../ice_thread_pool.h"
+
+struct ChunkLog {
+    std::vector<std::atomic<int>> hits;
+    std::atomic<size_t> chunks;
+    size_t grain;
+
+    ChunkLog(size_t n, size_t grain) : hits(n), chunks(0), grain(grain) {}
+};
+
+static col_error_t log_chunk(size_t first, size_t last, size_t chunk, void *pUserData) {
+    auto *log = (ChunkLog *) pUserData;
+    EXPECT_EQ(chunk * log->grain, first);
+    for (size_t i = first; i < last; ++i) {
+        log->hits[i]++;
+    }
+    log->chunks++;
+    return COL_OK;
+}
+
+TEST(ice_thread_pool, ParallelFor) {
+    ice_thread_pool pool = ice_thread_pool_new(4);
+    ASSERT_NE(nullptr, pool);
+    EXPECT_EQ(4, ice_thread_pool_size(pool));
+
+    EXPECT_EQ(COL_OK, ice_thread_pool_parallel_for(pool, 0, 16, log_chunk, nullptr));
+
+    for (size_t n: {1, 15, 16, 17, 1000, 100003}) {
+        for (int rounds = 0; rounds < 3; ++rounds) {
+            ChunkLog log(n, 16);
+            EXPECT_EQ(COL_OK, ice_thread_pool_parallel_for(pool, n, 16, log_chunk, &log));
+            EXPECT_EQ((n + 15) / 16, log.chunks);
+            for (size_t i = 0; i < n; ++i) {
+                ASSERT_EQ(1, log.hits[i]) << "n=" << n << ", i=" << i;
+            }
+        }
+    }
+
+    ice_thread_pool_free(pool);
+}
+
+TEST(ice_thread_pool, DefaultPool) {
+    ice_thread_pool pool = ice_thread_pool_default();
+    ASSERT_NE(nullptr, pool);
+    EXPECT_EQ(pool, ice_thread_pool_default());
+
+    ChunkLog log(10000, 100);
+    EXPECT_EQ(COL_OK, ice_thread_pool_parallel_for(nullptr, 10000, 100, log_chunk, &log));
+    EXPECT_EQ(100, log.chunks);
+}
+
+static col_error_t fail_chunk(size_t first, size_t last, size_t chunk, void *pUserData) {
+    return chunk == 7 ? COL_ERR_ILLEGAL_ARGUMENT : COL_OK;
+}
+
+static col_error_t nested_chunk(size_t first, size_t last, size_t chunk, void *pUserData) {
+    auto *pool = (ice_thread_pool) pUserData;
+    ChunkLog log(100, 10);
+    col_error_t err = ice_thread_pool_parallel_for(pool, 100, 10, log_chunk, &log);
+    return err == COL_OK && log.chunks == 10 ? COL_OK : COL_ERR_ILLEGAL_ARGUMENT;
+}
+
+TEST(ice_thread_pool, ErrorsAndNesting) {
+    ice_thread_pool pool = ice_thread_pool_new(3);
+
+    EXPECT_EQ(COL_ERR_ILLEGAL_ARGUMENT, ice_thread_pool_parallel_for(pool, 1000, 10, fail_chunk, nullptr));
+    EXPECT_EQ(COL_OK, ice_thread_pool_parallel_for(pool, 1000, 100, nested_chunk, pool));
+
+    ice_thread_pool_free(pool);
+}
+
+static col_error_t sum_chunk(size_t first, size_t last, void *pPartial, void *pUserData) {
+    auto *values = (const double *) pUserData;
+    for (size_t i = first; i < last; ++i) {
+        *((double *) pPartial) += values[i];
+    }
+    return COL_OK;
+}
+
+static void sum_combine(void *pResult, const void *pPartial, void *pUserData) {
+    *((double *) pResult) += *((const double *) pPartial);
+}
+
+TEST(ice_thread_pool, ParallelReduceIsDeterministic) {
+    std::vector<double> values(100000);
+    srand(7);
+    for (auto &v: values) {
+        v = (double) rand() / RAND_MAX * 1e6 - 5e5;
+    }
+
+    double expected = 0.0;
+    EXPECT_EQ(COL_OK, ice_thread_pool_parallel_reduce(nullptr, values.size(), 64, &expected, sizeof(double),
+                                                      sum_chunk, sum_combine, values.data()));
+    for (unsigned threads = 1; threads <= 5; ++threads) {
+        ice_thread_pool pool = ice_thread_pool_new(threads);
+        double sum = 0.0;
+        EXPECT_EQ(COL_OK, ice_thread_pool_parallel_reduce(pool, values.size(), 64, &sum, sizeof(double),
+                                                          sum_chunk, sum_combine, values.data()));
+        // bitwise identical, independent of the number of threads
+        EXPECT_EQ(expected, sum);
+        ice_thread_pool_free(pool);
+    }
+}
+
+TEST(ice_thread_pool, Grain) {
+    EXPECT_EQ(ICE_PARALLEL_DEFAULT_GRAIN, ice_parallel_grain(0, 4));
+    EXPECT_EQ(16, ice_parallel_grain(1, 4));
+    EXPECT_EQ(32, ice_parallel_grain(17, 4));
+    EXPECT_EQ(16, ice_parallel_grain(3, 12));
+    EXPECT_EQ(5, ice_parallel_grain(5, 64));
+}
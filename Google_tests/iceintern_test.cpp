@@ -0,0 +1,135 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../iceintern.h"
+
+TEST(iceintern, Intern) {
+    ice_intern pool = ice_intern_new(0);
+    EXPECT_EQ(0, ice_intern_count(pool));
+
+    std::string a = "hello";
+    std::string b = "hello";
+    const char * ia = ice_intern_str(pool, a.c_str());
+    const char * ib = ice_intern_str(pool, b.c_str());
+    EXPECT_STREQ("hello", ia);
+    EXPECT_NE(a.c_str(), ia);
+    EXPECT_EQ(ia, ib);
+    EXPECT_EQ(0, ice_intern_id(ia));
+    EXPECT_EQ(5, ice_intern_size(ia));
+
+    uint32_t id;
+    const char * ic = ice_intern_n(pool, "猫\0x", 5, &id);
+    EXPECT_EQ(1, id);
+    EXPECT_EQ(5, ice_intern_size(ic));
+    EXPECT_EQ(0, memcmp("猫\0x", ic, 6));
+    EXPECT_NE(ic, ice_intern_str(pool, "猫"));
+    EXPECT_EQ(3, ice_intern_count(pool));
+
+    EXPECT_EQ(ia, ice_intern_find(pool, "hello"));
+    EXPECT_EQ(ic, ice_intern_find_n(pool, "猫\0x", 5, &id));
+    EXPECT_EQ(1, id);
+    EXPECT_EQ(nullptr, ice_intern_find_n(pool, "hell", 4, &id));
+    EXPECT_EQ(ICE_INTERN_NONE, id);
+    EXPECT_EQ(nullptr, ice_intern_find(pool, nullptr));
+    EXPECT_EQ(nullptr, ice_intern_str(pool, nullptr));
+
+    EXPECT_EQ(ia, ice_intern_get(pool, 0));
+    EXPECT_EQ(ic, ice_intern_get(pool, 1));
+    EXPECT_EQ(nullptr, ice_intern_get(pool, 3));
+
+    const char * empty = ice_intern_str(pool, "");
+    EXPECT_STREQ("", empty);
+    EXPECT_EQ(empty, ice_intern_n(pool, nullptr, 0, nullptr));
+    EXPECT_EQ(empty, ice_intern_find_n(pool, nullptr, 0, nullptr));
+    const size_t count = ice_intern_count(pool);
+    EXPECT_EQ(nullptr, ice_intern_n(pool, nullptr, 3, &id));
+    EXPECT_EQ(nullptr, ice_intern_find_n(pool, nullptr, 3, &id));
+    EXPECT_EQ(ICE_INTERN_NONE, id);
+    EXPECT_EQ(count, ice_intern_count(pool));
+    ice_intern_free(pool);
+}
+
+TEST(iceintern, GrowAndLargeStrings) {
+    ice_intern pool = ice_intern_new(4);
+    std::vector<const char *> interned;
+    const std::string large(100000, 'x');
+    for (int i = 0; i < 20000; ++i) {
+        const std::string s = i % 1000 == 0 ? large + std::to_string(i) : "id_" + std::to_string(i);
+        interned.push_back(ice_intern_str(pool, s.c_str()));
+        ASSERT_NE(nullptr, interned.back());
+    }
+    EXPECT_EQ(20000, ice_intern_count(pool));
+    for (int i = 0; i < 20000; ++i) {
+        const std::string s = i % 1000 == 0 ? large + std::to_string(i) : "id_" + std::to_string(i);
+        // Addresses are stable while the pool grows
+        EXPECT_STREQ(s.c_str(), interned[i]);
+        EXPECT_EQ(interned[i], ice_intern_str(pool, s.c_str()));
+        EXPECT_EQ(interned[i], ice_intern_get(pool, (uint32_t) i));
+        EXPECT_EQ(i, ice_intern_id(interned[i]));
+        EXPECT_EQ(s.size(), ice_intern_size(interned[i]));
+    }
+    EXPECT_EQ(20000, ice_intern_count(pool));
+    ice_intern_free(pool);
+}
+
+TEST(iceintern, ConcurrentIntern) {
+    ice_intern pool = ice_intern_new(0);
+    const int nthreads = 4;
+    const int nstrings = 5000;
+    std::vector<std::vector<const char *>> results(nthreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < nthreads; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < nstrings; ++i) {
+                // Every thread interns the same strings in a different order
+                const int k = (i * (2 * t + 1)) % nstrings;
+                const std::string s = "key_" + std::to_string(k);
+                const char * found = ice_intern_find(pool, s.c_str());
+                const char * interned = ice_intern_str(pool, s.c_str());
+                if (found != nullptr) {
+                    EXPECT_EQ(found, interned);
+                }
+                results[t].push_back(interned);
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    EXPECT_EQ(nstrings, ice_intern_count(pool));
+    for (int t = 0; t < nthreads; ++t) {
+        for (int i = 0; i < nstrings; ++i) {
+            const int k = (i * (2 * t + 1)) % nstrings;
+            EXPECT_EQ(ice_intern_str(pool, ("key_" + std::to_string(k)).c_str()), results[t][i]);
+        }
+    }
+    ice_intern_free(pool);
+}
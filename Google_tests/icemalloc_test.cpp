@@ -79,4 +79,48 @@ TEST(ice_tests, aligned_realloc_test) {
     EXPECT_STREQ("Hallo Welt", ptr1);
 
     ice_aligned_free(ptr1);
-}
\ No newline at end of file
+}
+
+TEST(ice_tests, aligned_realloc_grow_test) {
+    // Grows through realloc, the data must survive a change of the offset
+    size_t size = 1;
+    auto ptr = (unsigned char *) ice_aligned_malloc(CACHE_LINE_SIZE, size);
+    ptr[0] = 0;
+    while (size < (1 << 22)) {
+        const size_t new_size = size * 3 / 2 + 1;
+        ptr = (unsigned char *) ice_aligned_realloc(ptr, CACHE_LINE_SIZE, size, new_size);
+        ASSERT_NE(nullptr, ptr);
+        ASSERT_EQ(0, ((uintptr_t) ptr) % CACHE_LINE_SIZE);
+        for (size_t i = 0; i < size; ++i) {
+            ASSERT_EQ((unsigned char) i, ptr[i]) << i;
+        }
+        for (size_t i = size; i < new_size; ++i) {
+            ptr[i] = (unsigned char) i;
+        }
+        size = new_size;
+    }
+    ice_aligned_free(ptr);
+}
+
+TEST(ice_tests, aligned_zmalloc_test) {
+    const size_t sizes[] = {1, 100, 4096, 1 << 22};
+    for (size_t size: sizes) {
+        auto ptr = (unsigned char *) ice_aligned_zmalloc(CACHE_LINE_SIZE, size);
+        EXPECT_NE(nullptr, ptr);
+        EXPECT_TRUE(ice_is_aligned(ptr, CACHE_LINE_SIZE));
+        for (size_t i = 0; i < size; ++i) {
+            ASSERT_EQ(0, ptr[i]);
+        }
+        ice_aligned_free(ptr);
+    }
+    EXPECT_EQ(nullptr, ice_aligned_zmalloc(16, SIZE_MAX - 4));
+}
+
+TEST(ice_tests, secure_zero_test) {
+    char secret[] = "Hallo Welt";
+    ice_secure_zero(secret, sizeof(secret));
+    for (char c: secret) {
+        EXPECT_EQ(0, c);
+    }
+    ice_secure_zero(nullptr, 10);
+}
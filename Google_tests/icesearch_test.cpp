@@ -0,0 +1,95 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+#include <random>
+#include <string>
+#include <cstring>
+#include "gtest/gtest.h"
+#include "../icesearch.h"
+#include "../icestring.h"
+
+static size_t search_ref(const std::string &s, const std::string &needle) {
+    const size_t pos = s.find(needle);
+    return pos == std::string::npos ? ICE_SEARCH_NPOS : pos;
+}
+
+TEST(icesearch, Search) {
+    const std::string s = "hello world, hello needle";
+    EXPECT_EQ(0, ice_search(s.data(), s.size(), "", 0));
+    EXPECT_EQ(0, ice_search(s.data(), s.size(), "h", 1));
+    EXPECT_EQ(4, ice_search(s.data(), s.size(), "o", 1));
+    EXPECT_EQ(6, ice_search(s.data(), s.size(), "world", 5));
+    EXPECT_EQ(19, ice_search(s.data(), s.size(), "needle", 6));
+    EXPECT_EQ(ICE_SEARCH_NPOS, ice_search(s.data(), s.size(), "needles", 7));
+    EXPECT_EQ(ICE_SEARCH_NPOS, ice_search(s.data(), 3, "hello", 5));
+    EXPECT_EQ(ICE_SEARCH_NPOS, ice_search("", 0, "a", 1));
+}
+
+TEST(icesearch, SearchRandom) {
+    // A small alphabet gives many partial matches
+    std::mt19937 rng(7);
+    for (int round = 0; round < 3000; ++round) {
+        std::string s;
+        const size_t n = rng() % 300;
+        for (size_t i = 0; i < n; ++i) {
+            s += (char) ('a' + rng() % 3);
+        }
+        std::string needle;
+        const size_t m = 1 + rng() % (round % 3 == 0 ? 80 : 8);
+        if (n > m && (round & 1)) {
+            needle = s.substr(rng() % (n - m), m);
+        } else {
+            for (size_t i = 0; i < m; ++i) {
+                needle += (char) ('a' + rng() % 3);
+            }
+        }
+        ASSERT_EQ(search_ref(s, needle), ice_search(s.data(), s.size(), needle.data(), needle.size()))
+                                    << s << " / " << needle;
+        ice_needle compiled = ice_needle_new(needle.data(), needle.size());
+        ASSERT_EQ(search_ref(s, needle), ice_needle_find(compiled, s.data(), s.size()));
+        ice_needle_free(compiled);
+    }
+}
+
+TEST(icesearch, StrIndexNeedle) {
+    ice_needle needle = ice_needle_new("🍌c", strlen("🍌c"));
+    EXPECT_EQ(2, str_index_needle("a猫🍌c", needle));
+    EXPECT_EQ(-1, str_index_needle("a猫🍌", needle));
+    EXPECT_EQ(-1, str_index_needle(nullptr, needle));
+    EXPECT_EQ(0, strview_find_needle(strview_of("🍌c"), needle));
+    ice_needle_free(needle);
+
+    std::string long_needle;
+    for (int i = 0; i < 10; ++i) {
+        long_needle += "猫🍌";
+    }
+    std::string s = "abc" + long_needle.substr(3) + "x" + long_needle + "y";
+    needle = ice_needle_new(long_needle.data(), long_needle.size());
+    EXPECT_EQ(3 + 19 + 1, str_index_needle(s.c_str(), needle));
+    EXPECT_EQ(3 + 19 + 1, str_index_string(s.c_str(), long_needle.c_str()));
+    ice_needle_free(needle);
+}
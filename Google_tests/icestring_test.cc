@@ -25,8 +25,11 @@
  * For more information, please refer to <http://unlicense.org/>
  */
 
+#include <string>
+#include <vector>
 #include "gtest/gtest.h"
 #include "../icestring.h"
+#include "../iceutf8.h"
 
 TEST(string_builder, StrOfEmpty) {
     char * str = str_of_empty();
@@ -157,4 +160,277 @@ TEST(string_builder, StrSubstring) {
     EXPECT_STREQ("猫🍌", str_substring("猫🍌", 0, 2));
     EXPECT_STREQ("猫", str_substring(str_substring("猫🍌", 0, 2), 0, 1));
     EXPECT_STREQ("🍌", str_substring(str_substring("猫🍌", 1, 2), 0, 1));
-}
\ No newline at end of file
+}
+
+TEST(string_builder, StrBuf) {
+    ice_strbuf sb = ice_strbuf_new(0);
+    ASSERT_NE(nullptr, sb);
+    EXPECT_STREQ("", ice_strbuf_cstr(sb));
+
+    EXPECT_EQ(COL_OK, ice_strbuf_append(sb, "a"));
+    EXPECT_EQ(COL_OK, ice_strbuf_append(sb, nullptr));
+    EXPECT_EQ(COL_OK, ice_strbuf_append_rune(sb, U'猫'));
+    EXPECT_EQ(COL_OK, ice_strbuf_append_rune(sb, U'🍌'));
+    EXPECT_EQ(COL_OK, ice_strbuf_append_rune(sb, 0));
+    EXPECT_EQ(COL_OK, ice_strbuf_append_n(sb, "cde", 1));
+    EXPECT_STREQ("a猫🍌c", ice_strbuf_cstr(sb));
+    EXPECT_EQ(9, ice_strbuf_size(sb));
+
+    EXPECT_EQ(COL_OK, ice_strbuf_appendf(sb, " %d-%s", 42, "x"));
+    EXPECT_STREQ("a猫🍌c 42-x", ice_strbuf_cstr(sb));
+
+    // Doesn't fit into the current capacity
+    std::string longer(100, 'z');
+    EXPECT_EQ(COL_OK, ice_strbuf_appendf(sb, "%s!", longer.c_str()));
+    EXPECT_EQ(14 + 101, ice_strbuf_size(sb));
+    EXPECT_EQ('!', ice_strbuf_cstr(sb)[ice_strbuf_size(sb) - 1]);
+
+    // Appending the buffer to itself while it grows
+    ice_strbuf_clear(sb);
+    EXPECT_EQ(COL_OK, ice_strbuf_append(sb, "ab"));
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_EQ(COL_OK, ice_strbuf_append_n(sb, ice_strbuf_cstr(sb), ice_strbuf_size(sb)));
+    }
+    std::string doubled = "ab";
+    for (int i = 0; i < 8; ++i) {
+        doubled += doubled;
+    }
+    EXPECT_EQ(doubled, ice_strbuf_cstr(sb));
+    EXPECT_EQ(COL_OK, ice_strbuf_append(sb, ice_strbuf_cstr(sb) + 510));
+    EXPECT_STREQ("abab", ice_strbuf_cstr(sb) + 510);
+
+    ice_strbuf_clear(sb);
+    EXPECT_EQ(0, ice_strbuf_size(sb));
+    EXPECT_EQ(COL_OK, ice_strbuf_append(sb, "Hello"));
+
+    char * str = ice_strbuf_finish(sb);
+    EXPECT_STREQ("Hello", str);
+    EXPECT_EQ(5, str_size(str));
+    str = str_append(str, " World");
+    EXPECT_STREQ("Hello World", str);
+    str_free(str);
+}
+
+TEST(string_builder, LStr) {
+    char * str = lstr_of("a猫🍌");
+    EXPECT_STREQ("a猫🍌", str);
+    EXPECT_EQ(8, lstr_size(str));
+    EXPECT_EQ(3, lstr_len(str));
+    EXPECT_EQ(3, str_len(str));
+    EXPECT_EQ(1, str_index_string(str, "猫"));
+
+    str = lstr_append(str, "c");
+    str = lstr_append(str, nullptr);
+    EXPECT_STREQ("a猫🍌c", str);
+    EXPECT_EQ(9, lstr_size(str));
+    EXPECT_EQ(4, lstr_len(str));
+
+    char * sub = lstr_substring(str, 1, 3);
+    EXPECT_STREQ("猫🍌", sub);
+    EXPECT_EQ(2, lstr_len(sub));
+    EXPECT_EQ(7, lstr_size(sub));
+    lstr_free(sub);
+
+    sub = lstr_substring(str, 10, 2);
+    EXPECT_STREQ("🍌c", sub);
+    str_free(sub);
+
+    // str_* functions accept a lstr and return plain strings
+    char * plain = str_append(str, "d");
+    EXPECT_STREQ("a猫🍌cd", plain);
+    str_free(plain);
+
+    str = lstr_nbof("Hello World", 5);
+    EXPECT_EQ(5, lstr_size(str));
+    sub = lstr_substring(str, 1, 3);
+    EXPECT_STREQ("el", sub);
+    lstr_free(sub);
+    lstr_free(str);
+
+    str = lstr_of(nullptr);
+    EXPECT_EQ(0, lstr_size(str));
+    EXPECT_EQ(0, lstr_len(str));
+    str = lstr_append(str, "猫");
+    EXPECT_EQ(1, lstr_len(str));
+    lstr_free(str);
+
+    str = lstr_append(nullptr, "abc");
+    EXPECT_EQ(3, lstr_size(str));
+    // Appending a lstr to itself while it grows
+    str = lstr_append(str, str);
+    EXPECT_STREQ("abcabc", str);
+    str = lstr_append(str, str + 4);
+    EXPECT_STREQ("abcabcbc", str);
+    EXPECT_EQ(8, lstr_len(str));
+    lstr_free(str);
+}
+
+static std::string view_str(ice_strview v) {
+    return std::string(v.ptr, v.nbytes);
+}
+
+TEST(string_builder, StrView) {
+    ice_strview v = strview_of("  a猫🍌c  ");
+    EXPECT_EQ(13, v.nbytes);
+    EXPECT_EQ(8, strview_len(v));
+
+    ice_strview t = strview_trim(v);
+    EXPECT_EQ("a猫🍌c", view_str(t));
+    EXPECT_EQ("a猫🍌c  ", view_str(strview_trim_left(v)));
+    EXPECT_EQ("  a猫🍌c", view_str(strview_trim_right(v)));
+    EXPECT_EQ("", view_str(strview_trim(strview_of(" \t\n"))));
+
+    EXPECT_EQ("猫🍌", view_str(strview_substring(t, 1, 3)));
+    EXPECT_EQ("🍌c", view_str(strview_substring(t, 10, 2)));
+    EXPECT_EQ("", view_str(strview_substring(t, 5, 7)));
+
+    EXPECT_EQ(1, strview_find(t, strview_of("猫")));
+    EXPECT_EQ(4, strview_find(t, strview_of("🍌c")));
+    EXPECT_EQ(0, strview_find(t, strview_of("")));
+    EXPECT_EQ(STRVIEW_NPOS, strview_find(t, strview_of("cc")));
+    EXPECT_EQ(STRVIEW_NPOS, strview_find(strview_of_n("abc", 2), strview_of("c")));
+
+    EXPECT_TRUE(strview_eq(t, strview_of("a猫🍌c")));
+    EXPECT_FALSE(strview_eq(t, strview_of("a猫🍌")));
+    EXPECT_LT(strview_cmp(strview_of("ab"), strview_of("abc")), 0);
+    EXPECT_GT(strview_cmp(strview_of("b"), strview_of("abc")), 0);
+    EXPECT_EQ(0, strview_cmp(strview_of("abc"), strview_of("abc")));
+    EXPECT_TRUE(strview_starts_with(t, strview_of("a猫")));
+    EXPECT_TRUE(strview_ends_with(t, strview_of("c")));
+    EXPECT_FALSE(strview_ends_with(t, strview_of("xa猫🍌c")));
+
+    char * str = str_of_view(strview_substring(t, 1, 2));
+    EXPECT_STREQ("猫", str);
+    str_free(str);
+
+    EXPECT_EQ(0, strview_of(nullptr).nbytes);
+}
+
+TEST(string_builder, StrViewSplit) {
+    std::vector<std::string> tokens;
+    ice_strview tok;
+
+    ice_strview_split split = strview_split(strview_of("a,,b猫,"), strview_of(","));
+    while (strview_split_next(&split, &tok)) {
+        tokens.push_back(view_str(tok));
+    }
+    EXPECT_EQ((std::vector<std::string>{"a", "", "b猫", ""}), tokens);
+
+    tokens.clear();
+    split = strview_split(strview_of("a::b"), strview_of("::"));
+    while (strview_split_next(&split, &tok)) {
+        tokens.push_back(view_str(tok));
+    }
+    EXPECT_EQ((std::vector<std::string>{"a", "b"}), tokens);
+
+    tokens.clear();
+    ice_strview_tok it = strview_tokenize(strview_of("  key = value\t# 猫 "), " \t=");
+    while (strview_tokenize_next(&it, &tok)) {
+        tokens.push_back(view_str(tok));
+    }
+    EXPECT_EQ((std::vector<std::string>{"key", "value", "#", "猫"}), tokens);
+
+    it = strview_tokenize(strview_of("   "), " ");
+    EXPECT_FALSE(strview_tokenize_next(&it, &tok));
+}
+
+TEST(string_builder, StrCpIndex) {
+    std::string text;
+    for (int i = 0; i < 100; ++i) {
+        text += "a猫🍌c";
+    }
+    char * str = str_of(text.c_str());
+    for (size_t stride: {1, 3, 4, 7, 0}) {
+        str_cpindex idx = str_cpindex_new(str, stride);
+        EXPECT_EQ(400, str_cpindex_len(idx));
+        for (size_t k = 0; k <= 401; ++k) {
+            const size_t pos = str_cpindex_offset(idx, k);
+            EXPECT_EQ(ice_utf8_offset(str, text.size(), k), pos) << k;
+            if (k < 400) {
+                EXPECT_EQ(k, str_cpindex_codepoint(idx, pos));
+            }
+        }
+        for (size_t start = 0; start < 400; start += 37) {
+            for (size_t end = start; end <= 410; end += 53) {
+                char * expected = str_substring(str, start, end);
+                char * sub = str_cpindex_substring(idx, end, start);
+                EXPECT_STREQ(expected, sub);
+                str_free(sub);
+                str_free(expected);
+            }
+        }
+        EXPECT_EQ(2, str_cpindex_index_string(idx, "🍌c"));
+        EXPECT_EQ(0, str_cpindex_index_string(idx, ""));
+        EXPECT_EQ(-1, str_cpindex_index_string(idx, "cc"));
+        EXPECT_EQ(-1, str_cpindex_index_string(idx, nullptr));
+        str_cpindex_free(idx);
+    }
+    str_free(str);
+
+    str_cpindex idx = str_cpindex_new(nullptr, 0);
+    EXPECT_EQ(0, str_cpindex_len(idx));
+    EXPECT_EQ(0, str_cpindex_offset(idx, 5));
+    char * sub = str_cpindex_substring(idx, 0, 5);
+    EXPECT_STREQ("", sub);
+    str_free(sub);
+    str_cpindex_free(idx);
+}
+
+TEST(string_builder, SStr) {
+    EXPECT_EQ(24, sizeof(ice_sstr));
+
+    ice_sstr s;
+    EXPECT_EQ(COL_OK, sstr_init(&s, "key"));
+    EXPECT_TRUE(sstr_is_inline(&s));
+    EXPECT_STREQ("key", sstr_cstr(&s));
+    EXPECT_EQ(3, sstr_size(&s));
+
+    // Exactly fills the inline buffer
+    EXPECT_EQ(COL_OK, sstr_append(&s, "_0123456789abcdefgh"));
+    EXPECT_TRUE(sstr_is_inline(&s));
+    EXPECT_EQ(ICE_SSTR_INLINE, sstr_size(&s));
+    EXPECT_STREQ("key_0123456789abcdefgh", sstr_cstr(&s));
+
+    // Spills to the heap and keeps growing there
+    EXPECT_EQ(COL_OK, sstr_append(&s, "猫"));
+    EXPECT_FALSE(sstr_is_inline(&s));
+    EXPECT_EQ(ICE_SSTR_INLINE + 3, sstr_size(&s));
+    EXPECT_STREQ("key_0123456789abcdefgh猫", sstr_cstr(&s));
+    EXPECT_EQ(COL_OK, sstr_append_n(&s, "🍌xyz", 4));
+    EXPECT_EQ(COL_OK, sstr_append(&s, nullptr));
+    EXPECT_STREQ("key_0123456789abcdefgh猫🍌", sstr_cstr(&s));
+    EXPECT_EQ(24, str_len(sstr_cstr(&s)));
+
+    // Conversions to the char * API
+    char * str = str_of_sstr(&s);
+    EXPECT_STREQ(sstr_cstr(&s), str);
+    EXPECT_NE(sstr_cstr(&s), str);
+    str_free(str);
+    EXPECT_EQ(22, str_index_string(sstr_cstr(&s), "猫"));
+
+    ice_sstr t;
+    EXPECT_EQ(COL_OK, sstr_init_n(&t, "key_0123456789abcdefgh猫🍌...", 29));
+    EXPECT_FALSE(sstr_is_inline(&t));
+    EXPECT_TRUE(sstr_eq(&s, &t));
+    EXPECT_EQ(COL_OK, sstr_append(&t, "!"));
+    EXPECT_FALSE(sstr_eq(&s, &t));
+
+    // Appending a spilled string to itself while it grows
+    const std::string spilled = sstr_cstr(&t);
+    EXPECT_EQ(COL_OK, sstr_append(&t, sstr_cstr(&t)));
+    EXPECT_EQ(spilled + spilled, sstr_cstr(&t));
+    EXPECT_EQ(2 * spilled.size(), sstr_size(&t));
+
+    sstr_free(&s);
+    EXPECT_TRUE(sstr_is_inline(&s));
+    EXPECT_EQ(0, sstr_size(&s));
+    EXPECT_STREQ("", sstr_cstr(&s));
+    sstr_free(&t);
+
+    EXPECT_EQ(COL_OK, sstr_init(&s, nullptr));
+    EXPECT_EQ(0, sstr_size(&s));
+    EXPECT_EQ(COL_OK, sstr_init_n(&t, "abc", 0));
+    EXPECT_TRUE(sstr_eq(&s, &t));
+    sstr_free(&s);
+    sstr_free(&t);
+}
@@ -0,0 +1,309 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../iceutf8.h"
+#include "../icestring.h"
+
+// Decoding reference, returns the offset of the first invalid sequence or
+// the length of s
+static size_t utf8_error_offset_ref(const std::string &s) {
+    size_t i = 0;
+    while (i < s.size()) {
+        const auto c = (unsigned char) s[i];
+        size_t n;
+        uint32_t cp;
+        uint32_t min;
+        if (c < 0x80) {
+            i++;
+            continue;
+        } else if ((c & 0xe0) == 0xc0) {
+            n = 2; cp = c & 0x1f; min = 0x80;
+        } else if ((c & 0xf0) == 0xe0) {
+            n = 3; cp = c & 0x0f; min = 0x800;
+        } else if ((c & 0xf8) == 0xf0) {
+            n = 4; cp = c & 0x07; min = 0x10000;
+        } else {
+            return i;
+        }
+        if (i + n > s.size()) {
+            return i;
+        }
+        for (size_t j = 1; j < n; ++j) {
+            const auto cc = (unsigned char) s[i + j];
+            if ((cc & 0xc0) != 0x80) {
+                return i;
+            }
+            cp = (cp << 6) | (cc & 0x3f);
+        }
+        if (cp < min || cp > 0x10ffff || (cp >= 0xd800 && cp <= 0xdfff)) {
+            return i;
+        }
+        i += n;
+    }
+    return s.size();
+}
+
+static size_t utf8_count_ref(const std::string &s) {
+    size_t count = 0;
+    for (char c: s) {
+        count += ((unsigned char) c & 0xc0) != 0x80;
+    }
+    return count;
+}
+
+static size_t utf8_offset_ref(const std::string &s, size_t k) {
+    for (size_t i = 0; i < s.size(); ++i) {
+        if (((unsigned char) s[i] & 0xc0) != 0x80 && k-- == 0) {
+            return i;
+        }
+    }
+    return s.size();
+}
+
+static void expect_valid_matches_ref(const std::string &s) {
+    size_t offset = SIZE_MAX;
+    const size_t ref = utf8_error_offset_ref(s);
+    const bool valid = ice_utf8_valid(s.data(), s.size(), &offset);
+    ASSERT_EQ(ref == s.size(), valid) << "length " << s.size() << ", error at " << ref;
+    if (!valid) {
+        ASSERT_EQ(ref, offset);
+    }
+}
+
+TEST(iceutf8, Count) {
+    EXPECT_EQ(0, ice_utf8_count("", 0));
+    EXPECT_EQ(4, ice_utf8_count("a猫🍌c", 9));
+    EXPECT_EQ(2, ice_utf8_count("a猫🍌c", 4));
+
+    std::string s;
+    for (int i = 0; i < 1000; ++i) {
+        s += "a猫🍌cé";
+        EXPECT_EQ(utf8_count_ref(s), ice_utf8_count(s.data(), s.size()));
+    }
+}
+
+TEST(iceutf8, Offset) {
+    EXPECT_EQ(0, ice_utf8_offset("a猫🍌c", 9, 0));
+    EXPECT_EQ(1, ice_utf8_offset("a猫🍌c", 9, 1));
+    EXPECT_EQ(4, ice_utf8_offset("a猫🍌c", 9, 2));
+    EXPECT_EQ(8, ice_utf8_offset("a猫🍌c", 9, 3));
+    EXPECT_EQ(9, ice_utf8_offset("a猫🍌c", 9, 4));
+    EXPECT_EQ(9, ice_utf8_offset("a猫🍌c", 9, 100));
+    EXPECT_EQ(0, ice_utf8_offset("", 0, 0));
+
+    std::string s;
+    for (int i = 0; i < 50; ++i) {
+        s += "ab猫🍌cé";
+    }
+    for (size_t k = 0; k <= utf8_count_ref(s) + 1; ++k) {
+        ASSERT_EQ(utf8_offset_ref(s, k), ice_utf8_offset(s.data(), s.size(), k)) << k;
+    }
+}
+
+TEST(iceutf8, Valid) {
+    EXPECT_TRUE(ice_utf8_valid("", 0, nullptr));
+    EXPECT_TRUE(ice_utf8_valid("a猫🍌c", 9, nullptr));
+    // Truncated banana
+    EXPECT_FALSE(ice_utf8_valid("a猫🍌c", 7, nullptr));
+
+    const std::string invalid[] = {
+            "\x80",                 // stray continuation
+            "\xc0\x80",             // overlong
+            "\xc1\xbf",             // overlong
+            "\xe0\x9f\xbf",         // overlong
+            "\xf0\x8f\xbf\xbf",     // overlong
+            "\xed\xa0\x80",         // surrogate
+            "\xed\xbf\xbf",         // surrogate
+            "\xf4\x90\x80\x80",     // above U+10FFFF
+            "\xf5\x80\x80\x80",     // invalid lead byte
+            "\xff",                 // invalid lead byte
+            "\xc3",                 // truncated
+            "\xe7\x8c",             // truncated
+            "\xf0\x9f\x8d",         // truncated
+            "\xc3\xa9\xa9",         // too long
+            "\xe7\x8c\xab\x80",     // too long
+            "\xc3" "a",             // too short
+            "\xe7\x8c" "a",         // too short
+    };
+    const std::string valid[] = {
+            "\xc2\x80", "\xdf\xbf", "\xe0\xa0\x80", "\xed\x9f\xbf", "\xee\x80\x80",
+            "\xef\xbf\xbf", "\xf0\x90\x80\x80", "\xf4\x8f\xbf\xbf",
+    };
+    // Move the sequences across the 16 and 32 byte blocks of the kernels
+    for (size_t pad = 0; pad < 70; ++pad) {
+        for (const auto &seq: invalid) {
+            std::string s = std::string(pad, 'x') + seq;
+            expect_valid_matches_ref(s);
+            expect_valid_matches_ref(s + "yz");
+            expect_valid_matches_ref(s + std::string(40, 'y'));
+        }
+        for (const auto &seq: valid) {
+            std::string s = std::string(pad, 'x') + seq;
+            EXPECT_TRUE(ice_utf8_valid(s.data(), s.size(), nullptr));
+            s += "猫" + std::string(pad, 'y');
+            EXPECT_TRUE(ice_utf8_valid(s.data(), s.size(), nullptr));
+        }
+    }
+}
+
+TEST(iceutf8, ValidRandom) {
+    std::mt19937 rng(42);
+    const char * pieces[] = {"a", "z", " ", "é", "猫", "🍌", "\xf4\x8f\xbf\xbf", "\xed\x9f\xbf"};
+    for (int round = 0; round < 5000; ++round) {
+        std::string s;
+        const size_t n = rng() % 60;
+        for (size_t i = 0; i < n; ++i) {
+            s += pieces[rng() % 8];
+        }
+        // Corrupt a byte of every other string
+        if (!s.empty() && (round & 1)) {
+            s[rng() % s.size()] = (char) (rng() & 0xff);
+        }
+        expect_valid_matches_ref(s);
+        ASSERT_EQ(utf8_count_ref(s), ice_utf8_count(s.data(), s.size()));
+    }
+}
+
+TEST(iceutf8, StringFunctions) {
+    std::string s;
+    for (int i = 0; i < 20; ++i) {
+        s += "ab猫🍌cé";
+    }
+    s += "needle";
+    EXPECT_EQ(126, str_len(s.c_str()));
+    EXPECT_EQ(120, str_index_string(s.c_str(), "needle"));
+    char * sub = str_substring(s.c_str(), 119, 122);
+    EXPECT_STREQ("éne", sub);
+    str_free(sub);
+}
+
+TEST(iceutf8, Utf32) {
+    vec_int v = vec_int_new();
+    EXPECT_EQ(COL_OK, str_to_utf32("a猫🍌é", v));
+    EXPECT_EQ((std::vector<int>{'a', 0x732b, 0x1f34c, 0xe9}), std::vector<int>(v->data, v->data + v->len));
+    // Appends
+    EXPECT_EQ(COL_OK, str_to_utf32("b", v));
+    EXPECT_EQ(COL_OK, str_to_utf32(nullptr, v));
+    EXPECT_EQ(5, vec_int_len(v));
+    EXPECT_EQ('b', v->data[4]);
+    EXPECT_EQ(COL_ERR_ILLEGAL_ARGUMENT, str_to_utf32("ok\xed\xa0\x80", v));
+    EXPECT_EQ(5, vec_int_len(v));
+
+    char * str = str_from_utf32((const int32_t *) v->data, v->len);
+    EXPECT_STREQ("a猫🍌éb", str);
+    str_free(str);
+    vec_int_free(v);
+
+    const int32_t invalid[] = {'a', 0xd800};
+    EXPECT_EQ(nullptr, str_from_utf32(invalid, 2));
+    const int32_t too_large[] = {0x110000};
+    EXPECT_EQ(nullptr, str_from_utf32(too_large, 1));
+    const int32_t negative[] = {-1};
+    EXPECT_EQ(nullptr, str_from_utf32(negative, 1));
+    size_t index;
+    EXPECT_FALSE(ice_utf32_utf8_size(invalid, 2, &index, &index));
+    EXPECT_EQ(1, index);
+    str = str_from_utf32(nullptr, 0);
+    EXPECT_STREQ("", str);
+    str_free(str);
+
+    int32_t runes[8];
+    size_t count, offset;
+    EXPECT_FALSE(ice_utf8_to_utf32("ab\xc0\xaf" "cd", 6, runes, &count, &offset));
+    EXPECT_EQ(2, count);
+    EXPECT_EQ(2, offset);
+}
+
+TEST(iceutf8, Utf32Random) {
+    std::mt19937 rng(7);
+    const char * pieces[] = {"a", "z", " ", "é", "猫", "🍌", "\xf4\x8f\xbf\xbf", "\xed\x9f\xbf"};
+    for (int round = 0; round < 5000; ++round) {
+        std::string s;
+        // Long ASCII runs reach the vector loops
+        const size_t n = rng() % 120;
+        for (size_t i = 0; i < n; ++i) {
+            s += pieces[rng() % 3 == 0 ? rng() % 8 : rng() % 3];
+        }
+        if (!s.empty() && (round & 1)) {
+            s[rng() % s.size()] = (char) (rng() & 0xff);
+        }
+        std::vector<int32_t> runes(s.size());
+        size_t count;
+        size_t offset = SIZE_MAX;
+        const size_t error = utf8_error_offset_ref(s);
+        const bool valid = ice_utf8_to_utf32(s.data(), s.size(), runes.data(), &count, &offset);
+        ASSERT_EQ(error == s.size(), valid) << s;
+        if (!valid) {
+            ASSERT_EQ(error, offset);
+            ASSERT_EQ(utf8_count_ref(s.substr(0, error)), count);
+            continue;
+        }
+        ASSERT_EQ(utf8_count_ref(s), count);
+        size_t nb;
+        ASSERT_TRUE(ice_utf32_utf8_size(runes.data(), count, &nb, nullptr));
+        ASSERT_EQ(s.size(), nb);
+        std::string encoded(nb, '\0');
+        ASSERT_EQ(nb, ice_utf32_to_utf8(runes.data(), count, &encoded[0]));
+        ASSERT_EQ(s, encoded);
+    }
+}
+
+static void benchmark_corpus(const char * name, const std::string &piece) {
+    std::string text;
+    while (text.size() < (16 << 20)) {
+        text += piece;
+    }
+    const double mb = (double) text.size() / (1 << 20);
+    const size_t len = ice_utf8_count(text.data(), text.size());
+
+    auto t0 = std::chrono::steady_clock::now();
+    size_t ref = utf8len(text.c_str());
+    auto t1 = std::chrono::steady_clock::now();
+    size_t count = ice_utf8_count(text.data(), text.size());
+    auto t2 = std::chrono::steady_clock::now();
+    bool valid = ice_utf8_valid(text.data(), text.size(), nullptr);
+    auto t3 = std::chrono::steady_clock::now();
+    size_t offset = ice_utf8_offset(text.data(), text.size(), len - 1);
+    auto t4 = std::chrono::steady_clock::now();
+    EXPECT_EQ(ref, count);
+    EXPECT_TRUE(valid);
+    EXPECT_LT(offset, text.size());
+
+    auto mbs = [mb](auto a, auto b) { return mb / std::chrono::duration<double>(b - a).count(); };
+    printf("%-5s utf8len: %8.0f MB/s, count: %8.0f MB/s, valid: %8.0f MB/s, offset: %8.0f MB/s\n",
+           name, mbs(t0, t1), mbs(t1, t2), mbs(t2, t3), mbs(t3, t4));
+}
+
+TEST(iceutf8, DISABLED_Benchmark) {
+    benchmark_corpus("ascii", "The quick brown fox jumps over the lazy dog. Grüße! ");
+    benchmark_corpus("cjk", "敏捷的棕色狐狸跳过了懒狗。素早い茶色の狐がのろまな犬を飛び越える。 ");
+}
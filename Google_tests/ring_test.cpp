@@ -0,0 +1,244 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../ring_uintptr.h"
+#include "../vec_uintptr.h"
+
+TEST(ring_uintptr, PushPop) {
+    for (ice_ring_mode mode: {ICE_RING_SPSC, ICE_RING_MPMC}) {
+        ring_uintptr r = ring_uintptr_new(5, mode);
+        ASSERT_NE(nullptr, r);
+        EXPECT_EQ(8, ring_uintptr_cap(r));
+        EXPECT_TRUE(ring_uintptr_empty(r));
+
+        uintptr_t val = 0;
+        EXPECT_EQ(COL_ERR_UNDERFLOW, ring_uintptr_pop(r, &val));
+
+        // wrap around several times
+        uintptr_t next_push = 0, next_pop = 0;
+        for (int round = 0; round < 10; ++round) {
+            while (ring_uintptr_push(r, next_push) == COL_OK) {
+                next_push++;
+            }
+            EXPECT_EQ(8, ring_uintptr_len(r));
+            EXPECT_EQ(COL_ERR_OVERFLOW, ring_uintptr_push(r, 42));
+            for (int i = 0; i < 5; ++i) {
+                EXPECT_EQ(COL_OK, ring_uintptr_pop(r, &val));
+                EXPECT_EQ(next_pop++, val);
+            }
+            EXPECT_EQ(3, ring_uintptr_len(r));
+        }
+        while (ring_uintptr_pop(r, &val) == COL_OK) {
+            EXPECT_EQ(next_pop++, val);
+        }
+        EXPECT_EQ(next_push, next_pop);
+        EXPECT_TRUE(ring_uintptr_empty(r));
+
+        ring_uintptr_free(r);
+    }
+}
+
+TEST(ring_uintptr, Batches) {
+    for (ice_ring_mode mode: {ICE_RING_SPSC, ICE_RING_MPMC}) {
+        ring_uintptr r = ring_uintptr_new(16, mode);
+        uintptr_t src[40], dst[20];
+        for (uintptr_t i = 0; i < 40; ++i) {
+            src[i] = i;
+        }
+
+        EXPECT_EQ(0, ring_uintptr_pop_n(r, dst, 4));
+        EXPECT_EQ(10, ring_uintptr_push_n(r, src, 10));
+        EXPECT_EQ(7, ring_uintptr_pop_n(r, dst, 7));
+        // 3 left, 13 free, the copy wraps
+        EXPECT_EQ(13, ring_uintptr_push_n(r, src + 10, 20));
+        EXPECT_EQ(16, ring_uintptr_pop_n(r, dst, 20));
+        for (uintptr_t i = 0; i < 16; ++i) {
+            EXPECT_EQ(i + 7, dst[i]);
+        }
+        EXPECT_TRUE(ring_uintptr_empty(r));
+
+        ring_uintptr_free(r);
+    }
+}
+
+static void run_producers_consumers(ring_uintptr r, int producers, int consumers, uintptr_t per_producer,
+                                    size_t batch, std::vector<uintptr_t> &popped) {
+    std::atomic<uintptr_t> total(0);
+    std::vector<std::thread> threads;
+    std::mutex lock;
+    const uintptr_t expected = per_producer * producers;
+
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([=]() {
+            std::vector<uintptr_t> items(batch);
+            uintptr_t i = 0;
+            while (i < per_producer) {
+                size_t n = 0;
+                for (; n < batch && i + n < per_producer; ++n) {
+                    items[n] = (uintptr_t) p * per_producer + i + n;
+                }
+                size_t pushed = ring_uintptr_push_n(r, items.data(), n);
+                i += pushed;
+                if (pushed == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int c = 0; c < consumers; ++c) {
+        threads.emplace_back([&, c]() {
+            std::vector<uintptr_t> items(batch);
+            std::vector<uintptr_t> mine;
+            while (total.load() < expected) {
+                size_t n = ring_uintptr_pop_n(r, items.data(), batch);
+                if (n == 0) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                mine.insert(mine.end(), items.begin(), items.begin() + n);
+                total += n;
+            }
+            std::lock_guard<std::mutex> guard(lock);
+            popped.insert(popped.end(), mine.begin(), mine.end());
+        });
+    }
+    for (auto &t: threads) {
+        t.join();
+    }
+}
+
+TEST(ring_uintptr, Concurrent) {
+    const uintptr_t per_producer = 50000;
+
+    for (size_t batch: {1, 7}) {
+        std::vector<uintptr_t> popped;
+        ring_uintptr r = ring_uintptr_new(64, ICE_RING_SPSC);
+        run_producers_consumers(r, 1, 1, per_producer, batch, popped);
+        ASSERT_EQ(per_producer, popped.size());
+        for (uintptr_t i = 0; i < per_producer; ++i) {
+            ASSERT_EQ(i, popped[i]);
+        }
+        ring_uintptr_free(r);
+
+        popped.clear();
+        r = ring_uintptr_new(64, ICE_RING_MPMC);
+        run_producers_consumers(r, 3, 3, per_producer, batch, popped);
+        ASSERT_EQ(3 * per_producer, popped.size());
+        std::sort(popped.begin(), popped.end());
+        for (uintptr_t i = 0; i < 3 * per_producer; ++i) {
+            ASSERT_EQ(i, popped[i]);
+        }
+        ring_uintptr_free(r);
+    }
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests
+TEST(ring_uintptr, DISABLED_BenchmarkThroughput) {
+    const uintptr_t items = 10000000;
+
+    for (int pairs = 1; pairs <= 4; pairs *= 2) {
+        for (size_t batch: {1, 32}) {
+            std::vector<uintptr_t> popped;
+            popped.reserve(items);
+
+            if (pairs == 1) {
+                ring_uintptr r = ring_uintptr_new(1024, ICE_RING_SPSC);
+                auto t0 = std::chrono::steady_clock::now();
+                run_producers_consumers(r, 1, 1, items, batch, popped);
+                auto t1 = std::chrono::steady_clock::now();
+                printf("spsc %d pair(s), batch %2zu: %8.2f Mitems/s\n", pairs, batch,
+                       items / std::chrono::duration<double, std::micro>(t1 - t0).count());
+                ring_uintptr_free(r);
+                popped.clear();
+            }
+
+            ring_uintptr r = ring_uintptr_new(1024, ICE_RING_MPMC);
+            auto t0 = std::chrono::steady_clock::now();
+            run_producers_consumers(r, pairs, pairs, items / pairs, batch, popped);
+            auto t1 = std::chrono::steady_clock::now();
+            printf("mpmc %d pair(s), batch %2zu: %8.2f Mitems/s\n", pairs, batch,
+                   items / std::chrono::duration<double, std::micro>(t1 - t0).count());
+            ring_uintptr_free(r);
+        }
+
+        // The mutex protected vector with erase(v, 0) this replaces
+        std::mutex lock;
+        vec_uintptr vec = vec_uintptr_new();
+        std::atomic<uintptr_t> total(0);
+        std::vector<std::thread> threads;
+        const uintptr_t per_producer = items / pairs;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int p = 0; p < pairs; ++p) {
+            threads.emplace_back([&]() {
+                for (uintptr_t i = 0; i < per_producer;) {
+                    bool pushed = false;
+                    {
+                        std::lock_guard<std::mutex> guard(lock);
+                        if (vec_uintptr_len(vec) < 1024) {
+                            vec_uintptr_push_back(vec, i++);
+                            pushed = true;
+                        }
+                    }
+                    if (!pushed) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+            threads.emplace_back([&]() {
+                uintptr_t val;
+                while (total.load() < per_producer * pairs) {
+                    bool popped = false;
+                    {
+                        std::lock_guard<std::mutex> guard(lock);
+                        if (vec_uintptr_len(vec) > 0) {
+                            vec_uintptr_get(vec, 0, &val);
+                            vec_uintptr_erase(vec, 0);
+                            total++;
+                            popped = true;
+                        }
+                    }
+                    if (!popped) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (auto &t: threads) {
+            t.join();
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        printf("mutex+vec %d pair(s):     %8.2f Mitems/s\n", pairs,
+               items / std::chrono::duration<double, std::micro>(t1 - t0).count());
+        vec_uintptr_free(vec);
+    }
+}
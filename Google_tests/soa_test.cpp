@@ -0,0 +1,72 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
+#include "gtest/gtest.h"
+#include "../ice_soa_macros.h"
+
+makeSoaBufApi(particle, (x, float), (y, float), (z, float), (mass, double), (id, uint32_t))
+makeSoaBufImpl(particle, (x, float), (y, float), (z, float), (mass, double), (id, uint32_t))
+
+TEST(soa_test, columns) {
+    soa_particle p = soa_particle_new(CACHE_LINE_SIZE);
+    EXPECT_TRUE(soa_particle_empty(p));
+    EXPECT_EQ(nullptr, soa_particle_x(p));
+
+    for (uint32_t i = 0; i < 1000; ++i) {
+        EXPECT_EQ(COL_OK, soa_particle_push_back(p, (float) i, 2.0f * i, -1.0f, 0.5 * i, i));
+    }
+    size_t idx = 0;
+    EXPECT_EQ(COL_OK, soa_particle_emplace_back(p, &idx));
+    EXPECT_EQ(1000, idx);
+    soa_particle_x(p)[idx] = 1000.0f;
+    soa_particle_y(p)[idx] = 2000.0f;
+    soa_particle_z(p)[idx] = -1.0f;
+    soa_particle_mass(p)[idx] = 500.0;
+    soa_particle_id(p)[idx] = 1000;
+    EXPECT_EQ(1001, soa_particle_lim(p));
+
+    // every column is aligned on its own
+    EXPECT_TRUE(ice_is_aligned(soa_particle_x(p), CACHE_LINE_SIZE));
+    EXPECT_TRUE(ice_is_aligned(soa_particle_mass(p), CACHE_LINE_SIZE));
+    EXPECT_TRUE(ice_is_aligned(soa_particle_id(p), CACHE_LINE_SIZE));
+
+    for (uint32_t i = 0; i <= 1000; ++i) {
+        ASSERT_EQ((float) i, soa_particle_x(p)[i]);
+        ASSERT_EQ(2.0f * i, soa_particle_y(p)[i]);
+        ASSERT_EQ(0.5 * i, soa_particle_mass(p)[i]);
+        ASSERT_EQ(i, soa_particle_id(p)[i]);
+    }
+
+    EXPECT_EQ(COL_ERR_ILLEGAL_ARGUMENT, soa_particle_swap_remove(p, 1001));
+    EXPECT_EQ(COL_OK, soa_particle_swap_remove(p, 3));
+    EXPECT_EQ(1000, soa_particle_lim(p));
+    EXPECT_EQ(1000.0f, soa_particle_x(p)[3]);
+    EXPECT_EQ(1000, soa_particle_id(p)[3]);
+
+    soa_particle_clear(p);
+    EXPECT_TRUE(soa_particle_empty(p));
+    soa_particle_free(p);
+}
@@ -0,0 +1,202 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include "gtest/gtest.h"
+#include "../vec_float.h"
+
+TEST(vec_float, AtAndPushBackUnchecked) {
+    vec_float vec = vec_float_new();
+
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(COL_OK, vec_float_push_back_unchecked(vec, (float) i));
+    }
+    EXPECT_EQ(100, vec_float_len(vec));
+    EXPECT_LE(100, vec->cap);
+
+    float value = 0.0f;
+    for (size_t i = 0; i < vec_float_len(vec); ++i) {
+        EXPECT_EQ(COL_OK, vec_float_get(vec, i, &value));
+        EXPECT_EQ(value, vec_float_at(vec, i));
+    }
+
+    // Iterator end is refreshed after an inlined push
+    EXPECT_EQ(vec_float_data(vec) + 100, vec_float_end(vec));
+    EXPECT_EQ(COL_OK, vec_float_push_back_unchecked(vec, 100.0f));
+    EXPECT_EQ(vec_float_data(vec) + 101, vec_float_end(vec));
+
+    vec_float_free(vec);
+}
+
+TEST(vec_float, FindCountMinMaxSumDot) {
+    float res = 0.0f;
+    vec_float a = vec_float_new();
+    vec_float b = vec_float_new();
+
+    EXPECT_EQ(0, vec_float_find(a, 1.0f));
+    EXPECT_EQ(0, vec_float_count(a, 1.0f));
+    EXPECT_EQ(COL_ERR_UNDERFLOW, vec_float_min(a, &res));
+    EXPECT_EQ(COL_ERR_UNDERFLOW, vec_float_max(a, &res));
+    EXPECT_EQ(0.0f, vec_float_sum(a));
+    EXPECT_EQ(COL_OK, vec_float_dot(a, b, &res));
+    EXPECT_EQ(0.0f, res);
+
+    for (int n = 1; n < 70; ++n) {
+        vec_float_clear(a);
+        vec_float_clear(b);
+        for (int i = 0; i < n; ++i) {
+            // Small integers are summed exactly in any order
+            EXPECT_EQ(COL_OK, vec_float_push_back(a, (float) (i - 10)));
+            EXPECT_EQ(COL_OK, vec_float_push_back(b, 2.0f));
+        }
+        EXPECT_EQ(0, vec_float_find(a, -10.0f));
+        EXPECT_EQ(n > 10 ? 10 : n, vec_float_find(a, 0.0f));
+        EXPECT_EQ(n, vec_float_find(a, 0.5f));
+        EXPECT_EQ(n, vec_float_count(b, 2.0f));
+        EXPECT_EQ(COL_OK, vec_float_min(a, &res));
+        EXPECT_EQ(-10.0f, res);
+        EXPECT_EQ(COL_OK, vec_float_max(a, &res));
+        EXPECT_EQ((float) (n - 11), res);
+
+        const float expected_sum = (float) (n * (n - 1) / 2 - 10 * n);
+        EXPECT_EQ(expected_sum, vec_float_sum(a));
+        EXPECT_EQ(COL_OK, vec_float_dot(a, b, &res));
+        EXPECT_EQ(2.0f * expected_sum, res);
+    }
+
+    EXPECT_EQ(COL_OK, vec_float_push_back(b, 1.0f));
+    EXPECT_EQ(COL_ERR_ILLEGAL_ARGUMENT, vec_float_dot(a, b, &res));
+
+    vec_float_free(a);
+    vec_float_free(b);
+}
+
+TEST(vec_float, Sort) {
+    const float inf = std::numeric_limits<float>::infinity();
+    const float values[] = {1.5f, -0.0f, -inf, 3.0f, -2.25f, 0.0f, inf, -1e-30f, 1e30f, -2.25f};
+    const float expected[] = {-inf, -2.25f, -2.25f, -1e-30f, -0.0f, 0.0f, 1.5f, 3.0f, 1e30f, inf};
+    const char payload[] = {'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j'};
+    const char expected_payload[] = {'c', 'e', 'j', 'h', 'b', 'f', 'a', 'd', 'i', 'g'};
+
+    vec_float vec = vec_float_new();
+    EXPECT_EQ(COL_OK, vec_float_append(vec, values, 10));
+    EXPECT_EQ(COL_OK, vec_float_sort(vec));
+    for (size_t i = 0; i < 10; ++i) {
+        EXPECT_EQ(expected[i], vec_float_at(vec, i));
+    }
+    EXPECT_TRUE(std::signbit(vec_float_at(vec, 4)));
+    EXPECT_FALSE(std::signbit(vec_float_at(vec, 5)));
+
+    char permuted[10];
+    memcpy(permuted, payload, sizeof(payload));
+    vec_float_clear(vec);
+    EXPECT_EQ(COL_OK, vec_float_append(vec, values, 10));
+    EXPECT_EQ(COL_OK, vec_float_sort_kv(vec, permuted, sizeof(char)));
+    for (size_t i = 0; i < 10; ++i) {
+        EXPECT_EQ(expected[i], vec_float_at(vec, i));
+        EXPECT_EQ(expected_payload[i], permuted[i]);
+    }
+
+    vec_float_free(vec);
+}
+
+// Micro benchmark, run with --gtest_also_run_disabled_tests
+TEST(vec_float, DISABLED_BenchmarkSumGetVsAt) {
+    const size_t n = 10000000;
+    vec_float vec = vec_float_new();
+    EXPECT_EQ(COL_OK, vec_float_reserve(vec, n));
+    for (size_t i = 0; i < n; ++i) {
+        vec_float_push_back_unchecked(vec, 1.0f);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    float sum_get = 0.0f;
+    float value = 0.0f;
+    for (size_t i = 0; i < vec_float_len(vec); ++i) {
+        vec_float_get(vec, i, &value);
+        sum_get += value;
+    }
+    auto mid = std::chrono::steady_clock::now();
+    float sum_at = 0.0f;
+    for (size_t i = 0; i < vec->len; ++i) {
+        sum_at += vec_float_at(vec, i);
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    EXPECT_EQ(sum_get, sum_at);
+    printf("vec_float sum of %zu elements: get=%.2fms, at=%.2fms\n", n,
+           std::chrono::duration<double, std::milli>(mid - start).count(),
+           std::chrono::duration<double, std::milli>(stop - mid).count());
+
+    vec_float_free(vec);
+}
+
+static col_error_t scale_each(vec_float v, size_t i, void *pUserData) {
+    v->data[i] *= *((float *) pUserData);
+    return COL_OK;
+}
+
+static col_error_t sum_range(vec_float v, size_t first, size_t last, void *pPartial, void *pUserData) {
+    double sum = 0.0;
+    for (size_t i = first; i < last; ++i) {
+        sum += v->data[i];
+    }
+    *((double *) pPartial) += sum;
+    return COL_OK;
+}
+
+static void sum_combine(void *pResult, const void *pPartial, void *pUserData) {
+    *((double *) pResult) += *((const double *) pPartial);
+}
+
+TEST(vec_float, ParallelEachAndReduce) {
+    vec_float vec = vec_float_new();
+    ice_thread_pool pool = ice_thread_pool_new(4);
+    float factor = 2.0f;
+    double sum = 0.0;
+
+    EXPECT_EQ(COL_OK, vec_float_parallel_each(vec, pool, 0, scale_each, &factor));
+    EXPECT_EQ(COL_OK, vec_float_parallel_reduce(vec, pool, 0, &sum, sizeof(sum), sum_range, sum_combine, nullptr));
+    EXPECT_EQ(0.0, sum);
+
+    for (int i = 0; i < 100001; ++i) {
+        EXPECT_EQ(COL_OK, vec_float_push_back(vec, (float) i));
+    }
+    EXPECT_EQ(COL_OK, vec_float_parallel_each(vec, pool, 100, scale_each, &factor));
+    for (int i = 0; i < 100001; ++i) {
+        ASSERT_EQ(2.0f * (float) i, vec_float_at(vec, i));
+    }
+    EXPECT_EQ(COL_OK, vec_float_parallel_reduce(vec, pool, 100, &sum, sizeof(sum), sum_range, sum_combine, nullptr));
+    EXPECT_EQ(100000.0 * 100001.0, sum);
+
+    ice_thread_pool_free(pool);
+    vec_float_free(vec);
+}
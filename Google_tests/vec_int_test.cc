@@ -0,0 +1,524 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <map>
+#include <queue>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../vec_int.h"
+#include "../ice_sort.h"
+
+TEST(vec_int, FindAndCount) {
+    vec_int vec = vec_int_new();
+
+    EXPECT_EQ(0, vec_int_find(vec, 1));
+    EXPECT_EQ(0, vec_int_count(vec, 1));
+
+    // Lengths which exercise the vector loops and the scalar tails
+    for (int n = 1; n < 70; ++n) {
+        vec_int_clear(vec);
+        for (int i = 0; i < n; ++i) {
+            EXPECT_EQ(COL_OK, vec_int_push_back(vec, i % 5));
+        }
+        EXPECT_EQ(0, vec_int_find(vec, 0));
+        EXPECT_EQ(n > 4 ? 4 : n, vec_int_find(vec, 4));
+        EXPECT_EQ(n, vec_int_find(vec, 5));
+        EXPECT_EQ((n + 4) / 5, vec_int_count(vec, 0));
+        EXPECT_EQ(0, vec_int_count(vec, -1));
+
+        EXPECT_EQ(COL_OK, vec_int_set(vec, n - 1, -7));
+        EXPECT_EQ(n - 1, vec_int_find(vec, -7));
+        EXPECT_EQ(1, vec_int_count(vec, -7));
+    }
+
+    vec_int_free(vec);
+}
+
+TEST(vec_int, MinMaxSum) {
+    int res = 0;
+    vec_int vec = vec_int_new();
+
+    EXPECT_EQ(COL_ERR_UNDERFLOW, vec_int_min(vec, &res));
+    EXPECT_EQ(COL_ERR_UNDERFLOW, vec_int_max(vec, &res));
+    EXPECT_EQ(0, vec_int_sum(vec));
+
+    srand(42);
+    for (int n = 1; n < 70; ++n) {
+        vec_int_clear(vec);
+        int expected_min = INT32_MAX;
+        int expected_max = INT32_MIN;
+        int64_t expected_sum = 0;
+        for (int i = 0; i < n; ++i) {
+            int value = rand() - RAND_MAX / 2;
+            expected_min = value < expected_min ? value : expected_min;
+            expected_max = value > expected_max ? value : expected_max;
+            expected_sum += value;
+            EXPECT_EQ(COL_OK, vec_int_push_back(vec, value));
+        }
+        EXPECT_EQ(COL_OK, vec_int_min(vec, &res));
+        EXPECT_EQ(expected_min, res);
+        EXPECT_EQ(COL_OK, vec_int_max(vec, &res));
+        EXPECT_EQ(expected_max, res);
+        EXPECT_EQ(expected_sum, vec_int_sum(vec));
+    }
+
+    // Sum is widened and does not overflow
+    vec_int_clear(vec);
+    EXPECT_EQ(COL_OK, vec_int_resize(vec, 33, INT32_MAX));
+    EXPECT_EQ(33 * (int64_t) INT32_MAX, vec_int_sum(vec));
+
+    vec_int_free(vec);
+}
+
+static int compare_int(const void * a, const void * b) {
+    const int x = *((const int *) a);
+    const int y = *((const int *) b);
+    return (x > y) - (x < y);
+}
+
+TEST(vec_int, Sort) {
+    vec_int vec = vec_int_new();
+    EXPECT_EQ(COL_OK, vec_int_sort(vec));
+
+    const int values[] = {5, -3, INT32_MAX, 0, -3, INT32_MIN, 42, 1, -1};
+    EXPECT_EQ(COL_OK, vec_int_append(vec, values, 9));
+    EXPECT_EQ(COL_OK, vec_int_sort(vec));
+
+    const int expected[] = {INT32_MIN, -3, -3, -1, 0, 1, 5, 42, INT32_MAX};
+    for (size_t i = 0; i < 9; ++i) {
+        EXPECT_EQ(expected[i], vec_int_at(vec, i));
+    }
+
+    vec_int_free(vec);
+}
+
+TEST(vec_int, SortKeyValue) {
+    vec_int keys = vec_int_new();
+    std::vector<size_t> payload;
+
+    srand(7);
+    for (size_t i = 0; i < 1000; ++i) {
+        EXPECT_EQ(COL_OK, vec_int_push_back(keys, rand() % 50 - 25));
+        payload.push_back(i);
+    }
+    std::vector<int> original(vec_int_data(keys), vec_int_data(keys) + 1000);
+
+    EXPECT_EQ(COL_ERR_ILLEGAL_ARGUMENT, vec_int_sort_kv(keys, payload.data(), 0));
+    EXPECT_EQ(COL_OK, vec_int_sort_kv(keys, payload.data(), sizeof(size_t)));
+
+    for (size_t i = 0; i < 1000; ++i) {
+        // Payload moved with its key
+        EXPECT_EQ(original[payload[i]], vec_int_at(keys, i));
+        if (i > 0) {
+            EXPECT_LE(vec_int_at(keys, i - 1), vec_int_at(keys, i));
+            // Stable, equal keys keep the insertion order
+            if (vec_int_at(keys, i - 1) == vec_int_at(keys, i)) {
+                EXPECT_LT(payload[i - 1], payload[i]);
+            }
+        }
+    }
+
+    vec_int_free(keys);
+}
+
+TEST(vec_int, SortParallel) {
+    const size_t n = ICE_SORT_PARALLEL_THRESHOLD + 1234;
+    vec_int keys = vec_int_new();
+    std::vector<uint32_t> payload(n);
+
+    srand(11);
+    for (size_t i = 0; i < n; ++i) {
+        EXPECT_EQ(COL_OK, vec_int_push_back_unchecked(keys, rand() - RAND_MAX / 2));
+        payload[i] = (uint32_t) i;
+    }
+    std::vector<int> expected(vec_int_data(keys), vec_int_data(keys) + n);
+    std::stable_sort(expected.begin(), expected.end());
+    std::vector<int> original(vec_int_data(keys), vec_int_data(keys) + n);
+
+    EXPECT_EQ(COL_OK, vec_int_sort_kv(keys, payload.data(), sizeof(uint32_t)));
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < n; ++i) {
+        mismatches += expected[i] != vec_int_at(keys, i);
+        mismatches += original[payload[i]] != vec_int_at(keys, i);
+    }
+    EXPECT_EQ(0, mismatches);
+
+    vec_int_free(keys);
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests
+TEST(vec_int, DISABLED_BenchmarkSort) {
+    for (size_t n = 1000; n <= 100000000; n *= 10) {
+        vec_int vec = vec_int_new();
+        EXPECT_EQ(COL_OK, vec_int_reserve(vec, n));
+        srand(1);
+        for (size_t i = 0; i < n; ++i) {
+            vec_int_push_back_unchecked(vec, rand() - RAND_MAX / 2);
+        }
+        std::vector<int> q(vec_int_data(vec), vec_int_data(vec) + n);
+        std::vector<int> s(q);
+
+        auto t0 = std::chrono::steady_clock::now();
+        EXPECT_EQ(COL_OK, vec_int_sort(vec));
+        auto t1 = std::chrono::steady_clock::now();
+        qsort(q.data(), n, sizeof(int), compare_int);
+        auto t2 = std::chrono::steady_clock::now();
+        std::sort(s.begin(), s.end());
+        auto t3 = std::chrono::steady_clock::now();
+
+        EXPECT_TRUE(std::equal(s.begin(), s.end(), vec_int_data(vec)));
+        printf("sort %9zu ints: vec_int_sort=%9.2fms, qsort=%9.2fms, std::sort=%9.2fms\n", n,
+               std::chrono::duration<double, std::milli>(t1 - t0).count(),
+               std::chrono::duration<double, std::milli>(t2 - t1).count(),
+               std::chrono::duration<double, std::milli>(t3 - t2).count());
+
+        vec_int_free(vec);
+    }
+}
+
+TEST(vec_int, BinarySearch) {
+    vec_int vec = vec_int_new();
+    size_t idx = 42;
+
+    EXPECT_EQ(0, vec_int_lower_bound(vec, 1));
+    EXPECT_EQ(0, vec_int_upper_bound(vec, 1));
+    EXPECT_FALSE(vec_int_binary_search(vec, 1, &idx));
+    EXPECT_EQ(0, idx);
+
+    // 0, 2, 2, 4, 4, 6, ...
+    for (int n = 1; n < 100; ++n) {
+        vec_int_clear(vec);
+        for (int i = 0; i < n; ++i) {
+            EXPECT_EQ(COL_OK, vec_int_push_back(vec, (i + 1) / 2 * 2));
+        }
+        for (int val = -1; val <= n + 2; ++val) {
+            const int *data = vec_int_data(vec);
+            size_t lb = std::lower_bound(data, data + n, val) - data;
+            size_t ub = std::upper_bound(data, data + n, val) - data;
+            EXPECT_EQ(lb, vec_int_lower_bound(vec, val));
+            EXPECT_EQ(ub, vec_int_upper_bound(vec, val));
+            EXPECT_EQ(lb != ub, vec_int_binary_search(vec, val, &idx));
+            EXPECT_EQ(lb, idx);
+        }
+    }
+
+    vec_int_free(vec);
+}
+
+TEST(vec_int, Eytzinger) {
+    vec_int vec = vec_int_new();
+    vec_int eytz = vec_int_new();
+
+    EXPECT_EQ(COL_ERR_ILLEGAL_ARGUMENT, vec_int_eytzinger(vec, vec));
+    EXPECT_EQ(COL_OK, vec_int_eytzinger(vec, eytz));
+    EXPECT_EQ(0, vec_int_eytzinger_lower_bound(eytz, 1));
+
+    for (int n = 1; n < 100; ++n) {
+        vec_int_clear(vec);
+        for (int i = 0; i < n; ++i) {
+            EXPECT_EQ(COL_OK, vec_int_push_back(vec, i * 2));
+        }
+        EXPECT_EQ(COL_OK, vec_int_eytzinger(vec, eytz));
+        EXPECT_EQ(n, vec_int_len(eytz));
+        for (int val = -1; val <= 2 * n + 1; ++val) {
+            size_t lb = vec_int_lower_bound(vec, val);
+            size_t k = vec_int_eytzinger_lower_bound(eytz, val);
+            if (lb == (size_t) n) {
+                EXPECT_EQ(n, k);
+            } else {
+                ASSERT_LT(k, (size_t) n);
+                EXPECT_EQ(vec_int_at(vec, lb), vec_int_at(eytz, k));
+            }
+        }
+    }
+
+    vec_int_free(eytz);
+    vec_int_free(vec);
+}
+
+TEST(deque_int, PushPopBothEnds) {
+    deque_int d = deque_int_new();
+    std::deque<int> expected;
+    int val = 0;
+
+    EXPECT_EQ(COL_ERR_UNDERFLOW, deque_int_pop_front(d, &val));
+    EXPECT_EQ(COL_ERR_UNDERFLOW, deque_int_pop_back(d, &val));
+    EXPECT_EQ(COL_ERR_UNDERFLOW, deque_int_front(d, &val));
+    EXPECT_EQ(deque_int_begin(d), deque_int_end(d));
+
+    srand(5);
+    for (int i = 0; i < 20000; ++i) {
+        switch (rand() % 5) {
+            case 0:
+            case 1:
+                EXPECT_EQ(COL_OK, deque_int_push_back(d, i));
+                expected.push_back(i);
+                break;
+            case 2:
+                EXPECT_EQ(COL_OK, deque_int_push_front(d, i));
+                expected.push_front(i);
+                break;
+            case 3:
+                if (!expected.empty()) {
+                    EXPECT_EQ(COL_OK, deque_int_pop_front(d, &val));
+                    EXPECT_EQ(expected.front(), val);
+                    expected.pop_front();
+                }
+                break;
+            default:
+                if (!expected.empty()) {
+                    EXPECT_EQ(COL_OK, deque_int_pop_back(d, &val));
+                    EXPECT_EQ(expected.back(), val);
+                    expected.pop_back();
+                }
+        }
+        ASSERT_EQ(expected.size(), deque_int_len(d));
+    }
+
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(COL_OK, deque_int_get(d, i, &val));
+        EXPECT_EQ(expected[i], val);
+        EXPECT_EQ(expected[i], deque_int_at(d, i));
+    }
+    EXPECT_EQ(COL_ERR_ILLEGAL_ARGUMENT, deque_int_get(d, expected.size(), &val));
+    EXPECT_EQ(COL_OK, deque_int_set(d, 0, -1));
+    expected[0] = -1;
+    EXPECT_EQ(COL_OK, deque_int_front(d, &val));
+    EXPECT_EQ(-1, val);
+    EXPECT_EQ(COL_OK, deque_int_back(d, &val));
+    EXPECT_EQ(expected.back(), val);
+
+    deque_int_free(d);
+}
+
+TEST(deque_int, Linearize) {
+    deque_int d = deque_int_new();
+
+    // wrapped with the front part larger and smaller than the back part
+    for (int front = 1; front < 16; ++front) {
+        deque_int_clear(d);
+        for (int i = 0; i < 16 - front; ++i) {
+            EXPECT_EQ(COL_OK, deque_int_push_back(d, i));
+        }
+        for (int i = 1; i <= front; ++i) {
+            EXPECT_EQ(COL_OK, deque_int_push_front(d, -i));
+        }
+        EXPECT_EQ(16, d->cap);
+        int *begin = deque_int_begin(d);
+        int *end = deque_int_end(d);
+        ASSERT_EQ(16, end - begin);
+        // -front, ..., -1, 0, ..., 15 - front
+        for (int *it = begin; it != end; ++it) {
+            EXPECT_EQ(it - begin - front, *it);
+        }
+        // still a valid deque
+        int val = 0;
+        EXPECT_EQ(COL_OK, deque_int_pop_front(d, &val));
+        EXPECT_EQ(-front, val);
+    }
+
+    deque_int_free(d);
+}
+
+TEST(heap_int, PushPopHeapify) {
+    EXPECT_EQ(nullptr, heap_int_new(3));
+
+    for (unsigned arity: {2u, 4u}) {
+        heap_int h = heap_int_new(arity);
+        int val = 0;
+        EXPECT_EQ(COL_ERR_UNDERFLOW, heap_int_top(h, &val));
+        EXPECT_EQ(COL_ERR_UNDERFLOW, heap_int_pop(h, &val));
+
+        std::vector<int> values(1000);
+        srand(11);
+        for (auto &v: values) {
+            v = rand() % 500 - 250;
+            EXPECT_EQ(COL_OK, heap_int_push(h, v, nullptr));
+        }
+        std::vector<int> sorted(values);
+        std::sort(sorted.begin(), sorted.end());
+
+        EXPECT_EQ(values.size(), heap_int_len(h));
+        EXPECT_EQ(COL_OK, heap_int_top(h, &val));
+        EXPECT_EQ(sorted[0], val);
+        for (int expected: sorted) {
+            EXPECT_EQ(COL_OK, heap_int_pop(h, &val));
+            ASSERT_EQ(expected, val);
+        }
+        EXPECT_TRUE(heap_int_empty(h));
+
+        for (size_t n: {0, 1, 2, 5, 17, 1000}) {
+            EXPECT_EQ(COL_OK, heap_int_heapify(h, values.data(), n));
+            std::vector<int> prefix(values.begin(), values.begin() + n);
+            std::sort(prefix.begin(), prefix.end());
+            for (int expected: prefix) {
+                EXPECT_EQ(COL_OK, heap_int_pop(h, &val));
+                ASSERT_EQ(expected, val);
+            }
+            EXPECT_TRUE(heap_int_empty(h));
+        }
+
+        heap_int_free(h);
+    }
+}
+
+TEST(heap_int, Indexed) {
+    for (unsigned arity: {2u, 4u}) {
+        heap_int h = heap_int_new_indexed(arity);
+        std::map<size_t, int> live;
+        size_t handle = 0;
+        int val = 0;
+
+        srand(13);
+        for (int i = 0; i < 20000; ++i) {
+            const int op = rand() % 6;
+            if (op < 2 || live.empty()) {
+                int v = rand() % 1000;
+                EXPECT_EQ(COL_OK, heap_int_push(h, v, &handle));
+                ASSERT_EQ(0, live.count(handle));
+                live[handle] = v;
+                continue;
+            }
+            auto it = live.begin();
+            std::advance(it, rand() % live.size());
+            if (op == 2) {
+                EXPECT_EQ(COL_OK, heap_int_decrease_key(h, it->first, it->second - rand() % 100));
+                EXPECT_EQ(COL_OK, heap_int_get(h, it->first, &val));
+                it->second = val;
+                EXPECT_EQ(COL_ERR_ILLEGAL_ARGUMENT, heap_int_decrease_key(h, it->first, val + 1));
+            } else if (op == 3) {
+                it->second = rand() % 1000;
+                EXPECT_EQ(COL_OK, heap_int_update(h, it->first, it->second));
+            } else if (op == 4) {
+                EXPECT_EQ(COL_OK, heap_int_remove(h, it->first, &val));
+                EXPECT_EQ(it->second, val);
+                EXPECT_FALSE(heap_int_contains(h, it->first));
+                EXPECT_EQ(COL_ERR_ILLEGAL_ARGUMENT, heap_int_remove(h, it->first, &val));
+                live.erase(it);
+            } else {
+                int min = INT32_MAX;
+                for (auto &e: live) {
+                    min = std::min(min, e.second);
+                }
+                EXPECT_EQ(COL_OK, heap_int_pop(h, &val));
+                ASSERT_EQ(min, val);
+                // the popped handle is one with the minimal key
+                for (auto e = live.begin(); e != live.end(); ++e) {
+                    if (!heap_int_contains(h, e->first)) {
+                        EXPECT_EQ(min, e->second);
+                        live.erase(e);
+                        break;
+                    }
+                }
+            }
+            ASSERT_EQ(live.size(), heap_int_len(h));
+        }
+
+        // plain heaps have no handles
+        heap_int p = heap_int_new(arity);
+        EXPECT_EQ(COL_OK, heap_int_push(p, 1, &handle));
+        EXPECT_EQ(ICE_HEAP_NO_HANDLE, handle);
+        EXPECT_EQ(COL_ERR_ILLEGAL_ARGUMENT, heap_int_remove(p, 0, &val));
+        heap_int_free(p);
+
+        heap_int_free(h);
+    }
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests
+TEST(heap_int, DISABLED_BenchmarkPriorityQueue) {
+    for (int n = 1000; n <= 1000000; n *= 10) {
+        std::vector<int> keys(2 * n);
+        srand(1);
+        for (auto &k: keys) {
+            k = rand();
+        }
+        long s[4] = {0, 0, 0, 0};
+        double ms[4] = {0, 0, 0, 0};
+
+        // push n, then n times pop one and push one
+        for (unsigned arity: {2u, 4u}) {
+            const int r = arity == 2 ? 0 : 1;
+            heap_int h = heap_int_new(arity);
+            int val = 0;
+            auto t0 = std::chrono::steady_clock::now();
+            for (int i = 0; i < n; ++i) {
+                heap_int_push(h, keys[i], nullptr);
+            }
+            for (int i = n; i < 2 * n; ++i) {
+                heap_int_pop(h, &val);
+                s[r] += val;
+                heap_int_push(h, keys[i], nullptr);
+            }
+            ms[r] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            heap_int_free(h);
+        }
+
+        auto t0 = std::chrono::steady_clock::now();
+        std::priority_queue<int, std::vector<int>, std::greater<int>> pq;
+        for (int i = 0; i < n; ++i) {
+            pq.push(keys[i]);
+        }
+        for (int i = n; i < 2 * n; ++i) {
+            s[2] += pq.top();
+            pq.pop();
+            pq.push(keys[i]);
+        }
+        ms[2] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+        // re-sorting after every push, only for small n
+        if (n <= 10000) {
+            vec_int v = vec_int_new();
+            t0 = std::chrono::steady_clock::now();
+            for (int i = 0; i < n; ++i) {
+                vec_int_push_back(v, keys[i]);
+            }
+            for (int i = n; i < 2 * n; ++i) {
+                std::sort(vec_int_data(v), vec_int_data(v) + vec_int_len(v), std::greater<int>());
+                int val = 0;
+                vec_int_pop_back(v, &val);
+                s[3] += val;
+                vec_int_push_back(v, keys[i]);
+            }
+            ms[3] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            vec_int_free(v);
+            EXPECT_EQ(s[0], s[3]);
+        }
+
+        EXPECT_EQ(s[0], s[1]);
+        EXPECT_EQ(s[0], s[2]);
+        printf("pq %7d: binary=%8.2fms, 4-ary=%8.2fms, std::priority_queue=%8.2fms, re-sort=%8.2fms\n", n,
+               ms[0], ms[1], ms[2], ms[3]);
+    }
+}
@@ -25,6 +25,9 @@
  * For more information, please refer to <http://unlicense.org/>
  */
 
+#include <algorithm>
+#include <string>
+#include <vector>
 #include "gtest/gtest.h"
 #include "../vec_string.h"
 #include "../icestring.h"
@@ -64,3 +67,101 @@ TEST(vec_string, VecStringTest) {
     EXPECT_EQ(COL_OK, vec_string_erase(vec, 11));
     EXPECT_EQ(11, vec_string_len(vec));
 }
+
+TEST(vec_string, StrVec) {
+    strvec v = strvec_new();
+    EXPECT_EQ(0, strvec_len(v));
+
+    EXPECT_EQ(COL_OK, strvec_push(v, "pear"));
+    EXPECT_EQ(COL_OK, strvec_push(v, "apple"));
+    EXPECT_EQ(COL_OK, strvec_push(v, nullptr));
+    EXPECT_EQ(COL_OK, strvec_push_n(v, "猫🍌xyz", 7));
+    EXPECT_EQ(COL_OK, strvec_push(v, "apple"));
+    EXPECT_EQ(COL_OK, strvec_push(v, "app"));
+    EXPECT_EQ(6, strvec_len(v));
+
+    EXPECT_STREQ("pear", strvec_at(v, 0));
+    EXPECT_STREQ("", strvec_at(v, 2));
+    EXPECT_STREQ("猫🍌", strvec_at(v, 3));
+    EXPECT_TRUE(strview_eq(strview_of("apple"), strvec_view_at(v, 1)));
+    EXPECT_EQ(0, strvec_view_at(v, 2).nbytes);
+
+    const char * s;
+    ice_strview view;
+    EXPECT_EQ(COL_OK, strvec_get(v, 5, &s));
+    EXPECT_STREQ("app", s);
+    EXPECT_EQ(COL_OK, strvec_get_view(v, 3, &view));
+    EXPECT_EQ(7, view.nbytes);
+    EXPECT_EQ(COL_ERR_ILLEGAL_ARGUMENT, strvec_get(v, 6, &s));
+    EXPECT_EQ(COL_ERR_ILLEGAL_ARGUMENT, strvec_get_view(v, 6, &view));
+
+    EXPECT_EQ(COL_OK, strvec_sort(v));
+    std::vector<std::string> sorted;
+    for (size_t i = 0; i < strvec_len(v); ++i) {
+        sorted.emplace_back(strvec_at(v, i));
+    }
+    EXPECT_EQ((std::vector<std::string>{"", "app", "apple", "apple", "pear", "猫🍌"}), sorted);
+
+    strvec_dedupe(v);
+    EXPECT_EQ(5, strvec_len(v));
+    EXPECT_STREQ("apple", strvec_at(v, 2));
+    EXPECT_STREQ("pear", strvec_at(v, 3));
+    EXPECT_TRUE(strview_eq(strview_of_n("猫🍌xyz", 7), strvec_view_at(v, 4)));
+
+    strvec_clear(v);
+    EXPECT_EQ(0, strvec_len(v));
+    EXPECT_EQ(COL_OK, strvec_reserve(v, 100, 1000));
+    const char * bytes = v->bytes;
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(COL_OK, strvec_push(v, "0123456789"));
+    }
+    // Reserved room, the arena didn't move
+    EXPECT_EQ(bytes, v->bytes);
+    strvec_free(v);
+}
+
+TEST(vec_string, StrVecPushElement) {
+    strvec v = strvec_new();
+    EXPECT_EQ(COL_OK, strvec_push(v, "abc"));
+    // Re-pushing elements while the arena grows
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(COL_OK, strvec_push(v, strvec_at(v, strvec_len(v) - 1)));
+        EXPECT_EQ(COL_OK, strvec_push_n(v, strvec_at(v, 0) + 1, 2));
+    }
+    EXPECT_EQ(21, strvec_len(v));
+    EXPECT_STREQ("abc", strvec_at(v, 0));
+    EXPECT_STREQ("abc", strvec_at(v, 1));
+    for (size_t i = 2; i < strvec_len(v); ++i) {
+        EXPECT_STREQ("bc", strvec_at(v, i));
+    }
+    strvec_free(v);
+}
+
+TEST(vec_string, StrVecSortRandom) {
+    strvec v = strvec_new();
+    std::vector<std::string> expected;
+    unsigned seed = 1;
+    for (int i = 0; i < 5000; ++i) {
+        std::string s;
+        seed = seed * 1103515245 + 12345;
+        const size_t len = (seed >> 16) % 13;
+        for (size_t c = 0; c < len; ++c) {
+            seed = seed * 1103515245 + 12345;
+            s += (char) ('a' + (seed >> 16) % 3);
+        }
+        expected.push_back(s);
+        EXPECT_EQ(COL_OK, strvec_push_n(v, s.data(), s.size()));
+    }
+    std::sort(expected.begin(), expected.end());
+    EXPECT_EQ(COL_OK, strvec_sort(v));
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQ(expected[i], strvec_at(v, i));
+    }
+    expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+    strvec_dedupe(v);
+    ASSERT_EQ(expected.size(), strvec_len(v));
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQ(expected[i], strvec_at(v, i));
+    }
+    strvec_free(v);
+}
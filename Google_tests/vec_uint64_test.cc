@@ -374,3 +374,167 @@ TEST(vec_uint64, AlignmentTest) {
     EXPECT_TRUE(is_aligned(8, 2));
     EXPECT_TRUE(is_aligned(8, 1));
 }
+
+TEST(vec_uint64, AppendAndResize) {
+    const uint64_t values[] = {1, 2, 3, 4, 5};
+
+    vec_uint64 vec = vec_uint64_new();
+    EXPECT_EQ(COL_OK, vec_uint64_append(vec, values, 0));
+    EXPECT_EQ(0, vec_uint64_len(vec));
+    EXPECT_EQ(COL_ERR_ILLEGAL_ARGUMENT, vec_uint64_append(vec, nullptr, 1));
+
+    EXPECT_EQ(COL_OK, vec_uint64_append(vec, values, 5));
+    EXPECT_EQ(COL_OK, vec_uint64_append(vec, values, 2));
+    EXPECT_EQ(7, vec_uint64_len(vec));
+    EXPECT_EQ(5, vec_uint64_at(vec, 4));
+    EXPECT_EQ(2, vec_uint64_at(vec, 6));
+    EXPECT_EQ(vec_uint64_data(vec) + 7, vec_uint64_end(vec));
+
+    // Grow and fill
+    EXPECT_EQ(COL_OK, vec_uint64_resize(vec, 10, 42));
+    EXPECT_EQ(10, vec_uint64_len(vec));
+    EXPECT_EQ(2, vec_uint64_at(vec, 6));
+    EXPECT_EQ(42, vec_uint64_at(vec, 7));
+    EXPECT_EQ(42, vec_uint64_at(vec, 9));
+
+    // Shrink keeps the first elements
+    EXPECT_EQ(COL_OK, vec_uint64_resize(vec, 3, 0));
+    EXPECT_EQ(3, vec_uint64_len(vec));
+    EXPECT_EQ(3, vec_uint64_at(vec, 2));
+
+    EXPECT_EQ(COL_OK, vec_uint64_shrink_to_fit(vec));
+    EXPECT_EQ(3, vec->cap);
+    EXPECT_EQ(1, vec_uint64_at(vec, 0));
+    EXPECT_EQ(3, vec_uint64_at(vec, 2));
+
+    vec_uint64_clear(vec);
+    EXPECT_EQ(COL_OK, vec_uint64_shrink_to_fit(vec));
+    EXPECT_EQ(0, vec->cap);
+    EXPECT_EQ(nullptr, vec_uint64_data(vec));
+
+    vec_uint64_free(vec);
+}
+
+TEST(vec_uint64, AppendSelf) {
+    vec_uint64 vec = vec_uint64_new();
+    for (uint64_t i = 0; i < 5; ++i) {
+        EXPECT_EQ(COL_OK, vec_uint64_push_back(vec, i));
+    }
+
+    // Doubling repeatedly forces reserve to move the source block
+    for (int round = 0; round < 6; ++round) {
+        const size_t len = vec_uint64_len(vec);
+        EXPECT_EQ(COL_OK, vec_uint64_append(vec, vec_uint64_data(vec), len));
+        EXPECT_EQ(2 * len, vec_uint64_len(vec));
+    }
+    for (size_t i = 0; i < vec_uint64_len(vec); ++i) {
+        EXPECT_EQ(i % 5, vec_uint64_at(vec, i));
+    }
+
+    // A tail slice of the vector
+    const size_t len = vec_uint64_len(vec);
+    EXPECT_EQ(COL_OK, vec_uint64_append(vec, vec_uint64_data(vec) + len - 3, 3));
+    EXPECT_EQ(len + 3, vec_uint64_len(vec));
+    EXPECT_EQ(vec_uint64_at(vec, len - 3), vec_uint64_at(vec, len));
+    EXPECT_EQ(vec_uint64_at(vec, len - 1), vec_uint64_at(vec, len + 2));
+
+    vec_uint64_free(vec);
+}
+
+TEST(vec_uint64, EraseRangeAndSwapRemove) {
+    const uint64_t values[] = {0, 1, 2, 3, 4, 5, 6, 7};
+
+    vec_uint64 vec = vec_uint64_new();
+    EXPECT_EQ(COL_OK, vec_uint64_append(vec, values, 8));
+
+    EXPECT_EQ(COL_ERR_ILLEGAL_ARGUMENT, vec_uint64_erase_range(vec, 3, 2));
+    EXPECT_EQ(COL_ERR_ILLEGAL_ARGUMENT, vec_uint64_erase_range(vec, 0, 9));
+    EXPECT_EQ(COL_OK, vec_uint64_erase_range(vec, 2, 2));
+    EXPECT_EQ(8, vec_uint64_len(vec));
+
+    // Erase [2, 5) => 0, 1, 5, 6, 7
+    EXPECT_EQ(COL_OK, vec_uint64_erase_range(vec, 2, 5));
+    EXPECT_EQ(5, vec_uint64_len(vec));
+    EXPECT_EQ(1, vec_uint64_at(vec, 1));
+    EXPECT_EQ(5, vec_uint64_at(vec, 2));
+    EXPECT_EQ(7, vec_uint64_at(vec, 4));
+
+    // Swap remove moves the last element into the hole => 7, 1, 5, 6
+    EXPECT_EQ(COL_ERR_ILLEGAL_ARGUMENT, vec_uint64_swap_remove(vec, 5));
+    EXPECT_EQ(COL_OK, vec_uint64_swap_remove(vec, 0));
+    EXPECT_EQ(4, vec_uint64_len(vec));
+    EXPECT_EQ(7, vec_uint64_at(vec, 0));
+    EXPECT_EQ(6, vec_uint64_at(vec, 3));
+
+    // Removing the last element
+    EXPECT_EQ(COL_OK, vec_uint64_swap_remove(vec, 3));
+    EXPECT_EQ(3, vec_uint64_len(vec));
+    EXPECT_EQ(5, vec_uint64_at(vec, 2));
+
+    // Erase everything
+    EXPECT_EQ(COL_OK, vec_uint64_erase_range(vec, 0, vec_uint64_len(vec)));
+    EXPECT_TRUE(vec_uint64_empty(vec));
+
+    vec_uint64_free(vec);
+}
+
+TEST(vec_uint64, FindCountMinMaxSum) {
+    uint64_t res = 0;
+    vec_uint64 vec = vec_uint64_new();
+
+    EXPECT_EQ(0, vec_uint64_find(vec, 1));
+    EXPECT_EQ(0, vec_uint64_count(vec, 1));
+    EXPECT_EQ(COL_ERR_UNDERFLOW, vec_uint64_min(vec, &res));
+    EXPECT_EQ(COL_ERR_UNDERFLOW, vec_uint64_max(vec, &res));
+    EXPECT_EQ(0, vec_uint64_sum(vec));
+
+    for (uint64_t n = 1; n < 40; ++n) {
+        vec_uint64_clear(vec);
+        uint64_t expected_sum = 0;
+        for (uint64_t i = 0; i < n; ++i) {
+            // Values above INT64_MAX check the unsigned compare
+            uint64_t value = (i % 2 == 0) ? UINT64_MAX - i : i + 1;
+            expected_sum += value;
+            EXPECT_EQ(COL_OK, vec_uint64_push_back(vec, value));
+        }
+        EXPECT_EQ(0, vec_uint64_find(vec, UINT64_MAX));
+        EXPECT_EQ(n, vec_uint64_find(vec, 0));
+        EXPECT_EQ(1, vec_uint64_count(vec, UINT64_MAX));
+        EXPECT_EQ(COL_OK, vec_uint64_min(vec, &res));
+        EXPECT_EQ(n == 1 ? UINT64_MAX : 2, res);
+        EXPECT_EQ(COL_OK, vec_uint64_max(vec, &res));
+        EXPECT_EQ(UINT64_MAX, res);
+        EXPECT_EQ(expected_sum, vec_uint64_sum(vec));
+
+        EXPECT_EQ(COL_OK, vec_uint64_set(vec, n - 1, 0));
+        EXPECT_EQ(n - 1, vec_uint64_find(vec, 0));
+        EXPECT_EQ(COL_OK, vec_uint64_min(vec, &res));
+        EXPECT_EQ(0, res);
+    }
+
+    vec_uint64_free(vec);
+}
+
+TEST(vec_uint64, Sort) {
+    const uint64_t values[] = {UINT64_MAX, 0, 1ull << 40, 7, 1ull << 63, 7, 255, 256};
+    const uint64_t expected[] = {0, 7, 7, 255, 256, 1ull << 40, 1ull << 63, UINT64_MAX};
+
+    vec_uint64 vec = vec_uint64_new();
+    EXPECT_EQ(COL_OK, vec_uint64_append(vec, values, 8));
+    EXPECT_EQ(COL_OK, vec_uint64_sort(vec));
+    for (size_t i = 0; i < 8; ++i) {
+        EXPECT_EQ(expected[i], vec_uint64_at(vec, i));
+    }
+
+    uint16_t payload[] = {0, 1, 2, 3, 4, 5, 6, 7};
+    const uint16_t expected_payload[] = {1, 3, 5, 6, 7, 2, 4, 0};
+    vec_uint64_clear(vec);
+    EXPECT_EQ(COL_OK, vec_uint64_append(vec, values, 8));
+    EXPECT_EQ(COL_OK, vec_uint64_sort_kv(vec, payload, sizeof(uint16_t)));
+    for (size_t i = 0; i < 8; ++i) {
+        EXPECT_EQ(expected[i], vec_uint64_at(vec, i));
+        EXPECT_EQ(expected_payload[i], payload[i]);
+    }
+
+    vec_uint64_free(vec);
+}
@@ -41,15 +41,38 @@ extern "C" {
 #include "col_error.h"
 #include "icelogging.h"
 #include "icemalloc.h"
+#include "ice_thread_pool.h"
 /**
  * buf_<name>_memset
  * Uses memset which is not safe to erase data because
- * the memset call might be optimized away
+ * the memset call might be optimized away, use
+ * buf_<name>_secure_zero instead.
+ *
+ * @brief buf_<name>_memset_range(buf_<name> v, size_t first, size_t n, int c)
+ * Fill the entries [first, first + n) with c in one memset call.
+ *
+ * @brief buf_<name>_secure_zero(buf_<name> v)
+ * Wipe all reserved entries with ice_secure_zero, the limit is
+ * not changed.
  *
  * @brief buf_<name>_get(buf_<name> v, size_t i, <type>** res)
  * Fetch buffer entry at position i and put pointer to entry
  * at res. Returns COL_OK on success or COL_ERR_UNDERFLOW if
  * i is greater or equal to the buffers limit.
+ *
+ * @brief buf_<name>_emplace_n(buf_<name> v, size_t n, <type>** first)
+ * Append n uninitialized entries and put pointer to the first at
+ * first. Entries are alignedSize bytes apart.
+ *
+ * @brief buf_<name>_resize(buf_<name> v, size_t n)
+ * Set the limit to n, new entries are zeroed.
+ *
+ * @brief buf_<name>_copy_from(buf_<name> v, const <type>* src, size_t n)
+ * Replace the entries with n tightly packed entries from src.
+ *
+ * @brief buf_<name>_pack_into(buf_<name> v, void* dst)
+ * Copy the entries without padding to dst, which must hold
+ * lim * sizeof(<type>) bytes. Returns the number of bytes written.
  */
 
 #define makeBufOfTypeApi(name, type) \
@@ -63,6 +86,7 @@ extern "C" {
     typedef struct buf__##name* buf_##name; \
     typedef col_error_t (*PFN_buf_##name##_each)(buf_##name v, size_t i, void * pUserData); \
     typedef col_error_t (*PFN_buf_##name##_pred)(buf_##name v, size_t i, bool * pMatch, void * pUserData); \
+    typedef col_error_t (*PFN_buf_##name##_reduce)(buf_##name v, size_t first, size_t last, void * pPartial, void * pUserData); \
     buf_##name buf_##name##_new(size_t align);   \
     void buf_##name##_free(buf_##name v);                                            \
     col_error_t buf_##name##_reserve(buf_##name v, size_t new_cap);                         \
@@ -70,6 +94,8 @@ extern "C" {
     col_error_t buf_##name##_emplace_back(buf_##name v, type** res);                        \
     col_error_t buf_##name##_get(buf_##name v, size_t i, type** res);                       \
     col_error_t buf_##name##_memset(buf_##name v, size_t i, int c);                         \
+    col_error_t buf_##name##_memset_range(buf_##name v, size_t first, size_t n, int c);     \
+    void buf_##name##_secure_zero(buf_##name v);                                            \
     size_t buf_##name##_lim(buf_##name v);  \
     void buf_##name##_set_lim(buf_##name v, size_t lim);                                    \
     void buf_##name##_clear(buf_##name v);  \
@@ -77,7 +103,18 @@ extern "C" {
     type* buf_##name##_data(buf_##name v);  \
     col_error_t buf_##name##_each(buf_##name v, PFN_buf_##name##_each cb, void * pUserData);\
     col_error_t buf_##name##_each_reverse(buf_##name v, PFN_buf_##name##_each each, void * pUserData); \
-    col_error_t buf_##name##_search(buf_##name v, PFN_buf_##name##_pred predicate, size_t *pIndex, void * pUserData);
+    col_error_t buf_##name##_search(buf_##name v, PFN_buf_##name##_pred predicate, size_t *pIndex, void * pUserData); \
+    col_error_t buf_##name##_emplace_n(buf_##name v, size_t n, type** first);               \
+    col_error_t buf_##name##_resize(buf_##name v, size_t n);                                \
+    col_error_t buf_##name##_copy_from(buf_##name v, type const* src, size_t n);            \
+    size_t buf_##name##_pack_into(buf_##name v, void * dst);                                \
+    col_error_t buf_##name##_parallel_each(buf_##name v, ice_thread_pool pool, size_t grain,   \
+                                           PFN_buf_##name##_each cb, void * pUserData);    \
+    col_error_t buf_##name##_parallel_reduce(buf_##name v, ice_thread_pool pool, size_t grain, \
+                                             void * pResult, size_t result_size,           \
+                                             PFN_buf_##name##_reduce reduce,               \
+                                             PFN_ice_parallel_combine combine,             \
+                                             void * pUserData);
 
 #define makeBufOfTypeImpl(name, type) \
 buf_##name buf_##name##_new(size_t align) { \
@@ -168,6 +205,18 @@ col_error_t buf_##name##_memset(buf_##name v, size_t i, int c) {
     return COL_OK;                    \
 }                                     \
                                       \
+col_error_t buf_##name##_memset_range(buf_##name v, size_t first, size_t n, int c) {      \
+    if (first > v->lim || n > v->lim - first) {                  \
+        return COL_ERR_OVERFLOW;      \
+    }                                 \
+    memset(v->data + first * v->alignedSize, c, n * v->alignedSize); \
+    return COL_OK;                    \
+}                                     \
+                                      \
+void buf_##name##_secure_zero(buf_##name v) {                    \
+    ice_secure_zero(v->data, v->cap * v->alignedSize);           \
+}                                     \
+                                      \
 size_t buf_##name##_lim(buf_##name v) {        \
     return v->lim;                             \
 }                                              \
@@ -227,6 +276,599 @@ col_error_t buf_##name##_search(buf_##name v,                    \
     }                                 \
     *pIndex = v->lim;                 \
     return err;                       \
+}                                     \
+col_error_t buf_##name##_emplace_n(buf_##name v, size_t n, type** first) {                 \
+    col_error_t err = COL_OK;         \
+    if (n > SIZE_MAX - v->lim) {      \
+        return COL_ERR_BAD_ALLOC;     \
+    }                                 \
+    if ((err = buf_##name##_reserve(v, v->lim + n)) != COL_OK) { \
+        return err;                   \
+    }                                 \
+    *first = (type *) (v->data + v->lim * v->alignedSize);       \
+    v->lim += n;                      \
+    return COL_OK;                    \
+}                                     \
+col_error_t buf_##name##_resize(buf_##name v, size_t n) {        \
+    col_error_t err = COL_OK;         \
+    if ((err = buf_##name##_reserve(v, n)) != COL_OK) {          \
+        return err;                   \
+    }                                 \
+    if (n > v->lim) {                 \
+        memset(v->data + v->lim * v->alignedSize, 0, (n - v->lim) * v->alignedSize); \
+    }                                 \
+    v->lim = n;                       \
+    return COL_OK;                    \
+}                                     \
+col_error_t buf_##name##_copy_from(buf_##name v, type const* src, size_t n) { \
+    col_error_t err = COL_OK;         \
+    if ((err = buf_##name##_reserve(v, n)) != COL_OK) {          \
+        return err;                   \
+    }                                 \
+    if (v->alignedSize == sizeof(type)) {                        \
+        memcpy(v->data, src, n * sizeof(type));                  \
+    } else {                          \
+        for (size_t i = 0; i < n; ++i) {                         \
+            memcpy(v->data + i * v->alignedSize, src + i, sizeof(type)); \
+        }                             \
+    }                                 \
+    v->lim = n;                       \
+    return COL_OK;                    \
+}                                     \
+size_t buf_##name##_pack_into(buf_##name v, void * dst) {        \
+    char * out = (char *) dst;        \
+    if (v->alignedSize == sizeof(type)) {                        \
+        memcpy(out, v->data, v->lim * sizeof(type));             \
+    } else {                          \
+        for (size_t i = 0; i < v->lim; ++i) {                    \
+            memcpy(out + i * sizeof(type), v->data + i * v->alignedSize, sizeof(type)); \
+        }                             \
+    }                                 \
+    return v->lim * sizeof(type);     \
+}                                     \
+struct buf_##name##_parallel_ctx {    \
+    buf_##name v;                     \
+    PFN_buf_##name##_each each;       \
+    PFN_buf_##name##_reduce reduce;   \
+    void * pUserData;                 \
+};                                    \
+static col_error_t buf_##name##_parallel_each_chunk(size_t first, size_t last, size_t chunk, void * pArg) {      \
+    struct buf_##name##_parallel_ctx * ctx = (struct buf_##name##_parallel_ctx *) pArg;                        \
+    (void) chunk;                     \
+    col_error_t err = COL_OK;         \
+    for (size_t i = first; i < last; ++i) {                      \
+        if ((err = ctx->each(ctx->v, i, ctx->pUserData)) != COL_OK) {                                          \
+            return err;               \
+        }                             \
+    }                                 \
+    return COL_OK;                    \
+}                                     \
+static col_error_t buf_##name##_parallel_reduce_chunk(size_t first, size_t last, void * pPartial, void * pArg) { \
+    struct buf_##name##_parallel_ctx * ctx = (struct buf_##name##_parallel_ctx *) pArg;                        \
+    return ctx->reduce(ctx->v, first, last, pPartial, ctx->pUserData);                                         \
+}                                     \
+col_error_t buf_##name##_parallel_each(buf_##name v, ice_thread_pool pool, size_t grain,                         \
+                                       PFN_buf_##name##_each cb, void * pUserData) {                          \
+    struct buf_##name##_parallel_ctx ctx = {v, cb, NULL, pUserData};                                           \
+    return ice_thread_pool_parallel_for(pool, v->lim, ice_parallel_grain(grain, v->alignedSize),               \
+                                        buf_##name##_parallel_each_chunk, &ctx);                               \
+}                                     \
+col_error_t buf_##name##_parallel_reduce(buf_##name v, ice_thread_pool pool, size_t grain,                       \
+                                         void * pResult, size_t result_size,                                   \
+                                         PFN_buf_##name##_reduce reduce,                                       \
+                                         PFN_ice_parallel_combine combine,                                     \
+                                         void * pUserData) {                                                   \
+    struct buf_##name##_parallel_ctx ctx = {v, NULL, reduce, pUserData};                                       \
+    return ice_thread_pool_parallel_reduce(pool, v->lim, ice_parallel_grain(grain, v->alignedSize),            \
+                                           pResult, result_size,                                               \
+                                           buf_##name##_parallel_reduce_chunk, combine, &ctx);                 \
+}
+
+/**
+ * Macros to define chunked buffers. A cbuf_<name> stores its entries in
+ * blocks of block_len entries (a power of two). Growing appends blocks
+ * and never moves existing entries, so pointers returned by
+ * cbuf_<name>_emplace_back and cbuf_<name>_get stay valid until the
+ * buffer is freed. Entries are aligned like in buf_<name>.
+ *
+ * @brief cbuf_<name>_new(size_t align, size_t block_len)
+ * block_len is rounded up to a power of two. If block_len is 0 a block
+ * holds CBUF_DEFAULT_BLOCK_SIZE bytes, at least one entry.
+ */
+#define CBUF_DEFAULT_BLOCK_SIZE 4096
+
+#define makeChunkedBufOfTypeApi(name, type) \
+    struct cbuf__##name {            \
+        size_t lim;                  \
+        size_t cap;                  \
+        size_t align;                \
+        size_t alignedSize;          \
+        size_t shift;                \
+        size_t mask;                 \
+        size_t nblocks;              \
+        size_t blocks_cap;           \
+        char** blocks;               \
+    };                               \
+    typedef struct cbuf__##name* cbuf_##name; \
+    typedef col_error_t (*PFN_cbuf_##name##_each)(cbuf_##name v, size_t i, void * pUserData); \
+    cbuf_##name cbuf_##name##_new(size_t align, size_t block_len);                          \
+    void cbuf_##name##_free(cbuf_##name v);                                                 \
+    col_error_t cbuf_##name##_reserve(cbuf_##name v, size_t new_cap);                       \
+    col_error_t cbuf_##name##_back(cbuf_##name v, type** res);                              \
+    col_error_t cbuf_##name##_emplace_back(cbuf_##name v, type** res);                      \
+    col_error_t cbuf_##name##_get(cbuf_##name v, size_t i, type** res);                     \
+    size_t cbuf_##name##_lim(cbuf_##name v);  \
+    void cbuf_##name##_set_lim(cbuf_##name v, size_t lim);                                  \
+    void cbuf_##name##_clear(cbuf_##name v);  \
+    int cbuf_##name##_empty(cbuf_##name v);   \
+    size_t cbuf_##name##_block_len(cbuf_##name v);                                          \
+    col_error_t cbuf_##name##_each(cbuf_##name v, PFN_cbuf_##name##_each cb, void * pUserData); \
+    /* Unchecked entry access. The index is only verified in debug builds. */                \
+    static inline type* cbuf_##name##_at(cbuf_##name v, size_t i) {                         \
+        IVK_ASSERT(i < v->lim, "index must be less than lim")                               \
+        return (type *) (v->blocks[i >> v->shift] + (i & v->mask) * v->alignedSize);       \
+    }
+
+#define makeChunkedBufOfTypeImpl(name, type) \
+cbuf_##name cbuf_##name##_new(size_t align, size_t block_len) { \
+    cbuf_##name v = (cbuf_##name) ice_aligned_malloc(PTR_ALIGN, sizeof(struct cbuf__##name)); \
+    if (v == NULL) {                  \
+        return NULL;                  \
+    }                                 \
+    v->lim = 0;                       \
+    v->cap = 0;                       \
+    v->align = align;                 \
+    v->alignedSize = ice_align_up(sizeof(type), align);         \
+    if (block_len == 0) {             \
+        block_len = CBUF_DEFAULT_BLOCK_SIZE / v->alignedSize;   \
+    }                                 \
+    v->shift = 0;                     \
+    while (((size_t) 1 << v->shift) < block_len) {              \
+        v->shift++;                   \
+    }                                 \
+    v->mask = ((size_t) 1 << v->shift) - 1;                     \
+    v->nblocks = 0;                   \
+    v->blocks_cap = 0;                \
+    v->blocks = NULL;                 \
+    return v;                         \
+}                                     \
+                                      \
+void cbuf_##name##_free(cbuf_##name v) {                  \
+    if (v) {                          \
+        for (size_t b = 0; b < v->nblocks; ++b) {         \
+            ice_aligned_free(v->blocks[b]);               \
+        }                             \
+        ice_aligned_free(v->blocks);  \
+        ice_aligned_free(v);          \
+    }                                 \
+}                                     \
+                                      \
+col_error_t cbuf_##name##_reserve(cbuf_##name v, size_t new_cap) { \
+    if (new_cap <= v->cap) {          \
+        return COL_OK;                \
+    }                                 \
+    const size_t nblocks = (new_cap + v->mask) >> v->shift;     \
+    ltrace("[cbuf_reserve] - requested new cap=%ld, blocks=%ld", new_cap, nblocks); \
+    if (nblocks > v->blocks_cap) {    \
+        /* Only the block table moves, the entries stay where they are */ \
+        size_t blocks_cap = v->blocks_cap < 8 ? 8 : v->blocks_cap; \
+        while (blocks_cap < nblocks) {\
+            blocks_cap *= 2;          \
+        }                             \
+        char** blocks = (char**) ice_aligned_realloc(v->blocks, PTR_ALIGN,           \
+                                                     v->blocks_cap * sizeof(char*),  \
+                                                     blocks_cap * sizeof(char*));    \
+        if (blocks == NULL) {         \
+            return COL_ERR_BAD_ALLOC; \
+        }                             \
+        v->blocks = blocks;           \
+        v->blocks_cap = blocks_cap;   \
+    }                                 \
+    const size_t block_size = (v->mask + 1) * v->alignedSize;   \
+    while (v->nblocks < nblocks) {    \
+        char* block = (char*) ice_aligned_malloc(v->align, block_size); \
+        if (block == NULL) {          \
+            return COL_ERR_BAD_ALLOC; \
+        }                             \
+        v->blocks[v->nblocks++] = block;                        \
+        v->cap += v->mask + 1;        \
+    }                                 \
+    return COL_OK;                    \
+}                                     \
+                                      \
+col_error_t cbuf_##name##_back(cbuf_##name v, type** res) {     \
+    if (v->lim == 0) {                \
+        return COL_ERR_UNDERFLOW;     \
+    }                                 \
+    *res = cbuf_##name##_at(v, v->lim - 1);                     \
+    return COL_OK;                    \
+}                                     \
+                                      \
+col_error_t cbuf_##name##_emplace_back(cbuf_##name v, type** res) { \
+    col_error_t err = COL_OK;         \
+    if (v->lim == v->cap && (err = cbuf_##name##_reserve(v, v->lim + 1)) != COL_OK) { \
+        return err;                   \
+    }                                 \
+    v->lim++;                         \
+    *res = cbuf_##name##_at(v, v->lim - 1);                     \
+    return COL_OK;                    \
+}                                     \
+                                      \
+col_error_t cbuf_##name##_get(cbuf_##name v, size_t i, type** res) { \
+    if (i >= v->lim) {                \
+        return COL_ERR_OVERFLOW;      \
+    }                                 \
+    *res = cbuf_##name##_at(v, i);    \
+    return COL_OK;                    \
+}                                     \
+                                      \
+size_t cbuf_##name##_lim(cbuf_##name v) {      \
+    return v->lim;                             \
+}                                              \
+void cbuf_##name##_set_lim(cbuf_##name v, size_t lim) {                                    \
+    if (lim >= v->cap) {              \
+        lim = v->cap;                 \
+    }                                 \
+    v->lim = lim;                     \
+}                                     \
+void cbuf_##name##_clear(cbuf_##name v) {      \
+    v->lim = 0;                                \
+}                                              \
+int cbuf_##name##_empty(cbuf_##name v) {       \
+    return v->lim == 0;                        \
+}                                              \
+size_t cbuf_##name##_block_len(cbuf_##name v) {\
+    return v->mask + 1;                        \
+}                                              \
+col_error_t cbuf_##name##_each(cbuf_##name v, PFN_cbuf_##name##_each cb, void * pUserData) { \
+    col_error_t err = COL_OK;         \
+    for (size_t i = 0; i < v->lim; ++i) {      \
+        err = cb(v, i, pUserData);    \
+        if (err != COL_OK) {          \
+            return err;               \
+        }                             \
+    }                                 \
+    return err;                       \
+}
+
+/**
+ * Macros to define slot maps on top of the buffer of the same name, i.e.
+ * makeBufOfTypeApi(name, type) must be expanded before
+ * makeSlotMapApi(name, type).
+ *
+ * slotmap_<name>_insert returns a handle which stays valid until the
+ * entry is removed. A handle holds the slot index in the lower and the
+ * generation of the slot in the upper 32 bits. Removing an entry bumps
+ * the generation of its slot, so stale handles are detected even after
+ * the slot was reused. ICE_SLOT_NULL is never a valid handle.
+ *
+ * The entries are kept densely packed in a buf_<name>, removal moves the
+ * last entry into the gap. Iterate with slotmap_<name>_len and
+ * slotmap_<name>_at, slotmap_<name>_handle_at gives the handle of a dense
+ * entry. Pointers to entries are invalidated by insert and remove.
+ *
+ * Insert, remove and lookup are O(1). Released slots are reused, so
+ * there are no allocations once the map reached its maximum size.
+ */
+#define ICE_SLOT_NULL ((uint64_t) 0)
+#define ICE_SLOT_NONE UINT32_MAX
+
+typedef uint64_t ice_slot_handle;
+
+struct ice_slot {
+    uint32_t gen;
+    /* dense index of a live slot, next free slot otherwise */
+    uint32_t idx;
+};
+
+#define makeSlotMapApi(name, type) \
+    struct slotmap__##name {         \
+        buf_##name dense;            \
+        struct ice_slot* slots;      \
+        uint32_t* dense_slot;        \
+        size_t slots_len;            \
+        size_t slots_cap;            \
+        uint32_t free_head;          \
+    };                               \
+    typedef struct slotmap__##name* slotmap_##name; \
+    typedef col_error_t (*PFN_slotmap_##name##_each)(slotmap_##name m, size_t i, void * pUserData); \
+    slotmap_##name slotmap_##name##_new();                                                  \
+    void slotmap_##name##_free(slotmap_##name m);                                           \
+    col_error_t slotmap_##name##_reserve(slotmap_##name m, size_t new_cap);                 \
+    col_error_t slotmap_##name##_insert(slotmap_##name m, type** res, ice_slot_handle* pHandle); \
+    col_error_t slotmap_##name##_get(slotmap_##name m, ice_slot_handle handle, type** res); \
+    col_error_t slotmap_##name##_remove(slotmap_##name m, ice_slot_handle handle);          \
+    bool slotmap_##name##_contains(slotmap_##name m, ice_slot_handle handle);               \
+    size_t slotmap_##name##_len(slotmap_##name m);                                          \
+    int slotmap_##name##_empty(slotmap_##name m);                                           \
+    void slotmap_##name##_clear(slotmap_##name m);                                          \
+    type* slotmap_##name##_at(slotmap_##name m, size_t i);                                  \
+    ice_slot_handle slotmap_##name##_handle_at(slotmap_##name m, size_t i);                 \
+    col_error_t slotmap_##name##_each(slotmap_##name m, PFN_slotmap_##name##_each cb, void * pUserData);
+
+#define makeSlotMapImpl(name, type, align) \
+slotmap_##name slotmap_##name##_new() {                                                     \
+    slotmap_##name m = (slotmap_##name) ice_aligned_malloc(PTR_ALIGN, sizeof(struct slotmap__##name)); \
+    if (m == NULL) {                                                                        \
+        return NULL;                                                                        \
+    }                                                                                       \
+    if ((m->dense = buf_##name##_new(align)) == NULL) {                                     \
+        ice_aligned_free(m);                                                                \
+        return NULL;                                                                        \
+    }                                                                                       \
+    m->slots = NULL;                                                                        \
+    m->dense_slot = NULL;                                                                   \
+    m->slots_len = 0;                                                                       \
+    m->slots_cap = 0;                                                                       \
+    m->free_head = ICE_SLOT_NONE;                                                           \
+    return m;                                                                               \
+}                                                                                           \
+void slotmap_##name##_free(slotmap_##name m) {                                              \
+    if (m) {                                                                                \
+        buf_##name##_free(m->dense);                                                        \
+        ice_aligned_free(m->slots);                                                         \
+        ice_aligned_free(m->dense_slot);                                                    \
+        ice_aligned_free(m);                                                                \
+    }                                                                                       \
+}                                                                                           \
+col_error_t slotmap_##name##_reserve(slotmap_##name m, size_t new_cap) {                    \
+    if (new_cap >= ICE_SLOT_NONE) {                                                         \
+        return COL_ERR_OVERFLOW;                                                            \
+    }                                                                                       \
+    if (new_cap > m->slots_cap) {                                                           \
+        size_t cap = (size_t) ceil(VEC_GROWTH * (double) new_cap);                          \
+        cap = cap >= ICE_SLOT_NONE ? ICE_SLOT_NONE - 1 : cap;                               \
+        struct ice_slot* slots = (struct ice_slot*) ice_aligned_realloc(m->slots, PTR_ALIGN, \
+                                                  m->slots_cap * sizeof(struct ice_slot),   \
+                                                  cap * sizeof(struct ice_slot));           \
+        if (slots == NULL) {                                                                \
+            return COL_ERR_BAD_ALLOC;                                                       \
+        }                                                                                   \
+        m->slots = slots;                                                                   \
+        uint32_t* dense_slot = (uint32_t*) ice_aligned_realloc(m->dense_slot, PTR_ALIGN,    \
+                                                  m->slots_cap * sizeof(uint32_t),          \
+                                                  cap * sizeof(uint32_t));                  \
+        if (dense_slot == NULL) {                                                           \
+            /* slots already has the new capacity, that's harmless */                       \
+            return COL_ERR_BAD_ALLOC;                                                       \
+        }                                                                                   \
+        m->dense_slot = dense_slot;                                                         \
+        m->slots_cap = cap;                                                                 \
+    }                                                                                       \
+    return buf_##name##_reserve(m->dense, new_cap);                                         \
+}                                                                                           \
+static inline ice_slot_handle slotmap_##name##_handle(slotmap_##name m, uint32_t slot) {    \
+    return ((uint64_t) m->slots[slot].gen << 32) | slot;                                    \
+}                                                                                           \
+col_error_t slotmap_##name##_insert(slotmap_##name m, type** res, ice_slot_handle* pHandle) { \
+    col_error_t err = COL_OK;                                                               \
+    const size_t len = m->dense->lim;                                                       \
+    if ((err = slotmap_##name##_reserve(m, len + 1)) != COL_OK) {                           \
+        return err;                                                                         \
+    }                                                                                       \
+    uint32_t slot = m->free_head;                                                           \
+    if (slot != ICE_SLOT_NONE) {                                                            \
+        m->free_head = m->slots[slot].idx;                                                  \
+    } else {                                                                                \
+        slot = (uint32_t) m->slots_len++;                                                   \
+        /* generation 0 is never used, so handles are never ICE_SLOT_NULL */                \
+        m->slots[slot].gen = 1;                                                             \
+    }                                                                                       \
+    m->slots[slot].idx = (uint32_t) len;                                                    \
+    m->dense_slot[len] = slot;                                                              \
+    buf_##name##_set_lim(m->dense, len + 1);                                                \
+    *res = (type *) (m->dense->data + len * m->dense->alignedSize);                         \
+    if (pHandle != NULL) {                                                                  \
+        *pHandle = slotmap_##name##_handle(m, slot);                                        \
+    }                                                                                       \
+    return COL_OK;                                                                          \
+}                                                                                           \
+/* Returns the slot of a live handle or ICE_SLOT_NONE */                                    \
+static inline uint32_t slotmap_##name##_slot(slotmap_##name m, ice_slot_handle handle) {    \
+    const uint32_t slot = (uint32_t) handle;                                                \
+    if (slot >= m->slots_len || m->slots[slot].gen != (uint32_t) (handle >> 32)) {          \
+        return ICE_SLOT_NONE;                                                               \
+    }                                                                                       \
+    return slot;                                                                            \
+}                                                                                           \
+col_error_t slotmap_##name##_get(slotmap_##name m, ice_slot_handle handle, type** res) {   \
+    const uint32_t slot = slotmap_##name##_slot(m, handle);                                 \
+    if (slot == ICE_SLOT_NONE) {                                                            \
+        return COL_ERR_ILLEGAL_ARGUMENT;                                                    \
+    }                                                                                       \
+    *res = (type *) (m->dense->data + m->slots[slot].idx * m->dense->alignedSize);          \
+    return COL_OK;                                                                          \
+}                                                                                           \
+col_error_t slotmap_##name##_remove(slotmap_##name m, ice_slot_handle handle) {            \
+    const uint32_t slot = slotmap_##name##_slot(m, handle);                                 \
+    if (slot == ICE_SLOT_NONE) {                                                            \
+        return COL_ERR_ILLEGAL_ARGUMENT;                                                    \
+    }                                                                                       \
+    const uint32_t i = m->slots[slot].idx;                                                  \
+    const uint32_t last = (uint32_t) m->dense->lim - 1;                                     \
+    if (i != last) {                                                                        \
+        const size_t size = m->dense->alignedSize;                                          \
+        memcpy(m->dense->data + i * size, m->dense->data + last * size, size);              \
+        m->dense_slot[i] = m->dense_slot[last];                                             \
+        m->slots[m->dense_slot[i]].idx = i;                                                 \
+    }                                                                                       \
+    buf_##name##_set_lim(m->dense, last);                                                   \
+    /* a new generation invalidates all handles of the slot, 0 is skipped */                \
+    m->slots[slot].gen = m->slots[slot].gen + 1 == 0 ? 1 : m->slots[slot].gen + 1;          \
+    m->slots[slot].idx = m->free_head;                                                      \
+    m->free_head = slot;                                                                    \
+    return COL_OK;                                                                          \
+}                                                                                           \
+bool slotmap_##name##_contains(slotmap_##name m, ice_slot_handle handle) {                 \
+    return slotmap_##name##_slot(m, handle) != ICE_SLOT_NONE;                               \
+}                                                                                           \
+size_t slotmap_##name##_len(slotmap_##name m) {                                             \
+    return m->dense->lim;                                                                   \
+}                                                                                           \
+int slotmap_##name##_empty(slotmap_##name m) {                                              \
+    return m->dense->lim == 0;                                                              \
+}                                                                                           \
+void slotmap_##name##_clear(slotmap_##name m) {                                             \
+    while (m->dense->lim > 0) {                                                             \
+        slotmap_##name##_remove(m, slotmap_##name##_handle(m, m->dense_slot[m->dense->lim - 1])); \
+    }                                                                                       \
+}                                                                                           \
+type* slotmap_##name##_at(slotmap_##name m, size_t i) {                                     \
+    IVK_ASSERT(i < m->dense->lim, "index must be less than len")                            \
+    return (type *) (m->dense->data + i * m->dense->alignedSize);                           \
+}                                                                                           \
+ice_slot_handle slotmap_##name##_handle_at(slotmap_##name m, size_t i) {                    \
+    IVK_ASSERT(i < m->dense->lim, "index must be less than len")                            \
+    return slotmap_##name##_handle(m, m->dense_slot[i]);                                    \
+}                                                                                           \
+col_error_t slotmap_##name##_each(slotmap_##name m, PFN_slotmap_##name##_each cb, void * pUserData) { \
+    col_error_t err = COL_OK;                                                               \
+    for (size_t i = 0; i < m->dense->lim; ++i) {                                            \
+        if ((err = cb(m, i, pUserData)) != COL_OK) {                                        \
+            return err;                                                                     \
+        }                                                                                   \
+    }                                                                                       \
+    return COL_OK;                                                                          \
+}
+
+/**
+ * Macros to define per frame staging rings. A fring_<name> partitions one
+ * aligned allocation into frames_in_flight regions of frame_cap entries.
+ * Frame f sub-allocates linearly from region f % frames_in_flight, so
+ * there are no allocations once the ring is created.
+ *
+ * fring_<name>_alloc may be called from any number of threads, it is
+ * lock-free and hands out disjoint ranges of the current frame. Entries
+ * are alignedSize bytes apart like in buf_<name>.
+ *
+ * fring_<name>_begin_frame starts the next frame and must not run
+ * concurrently with fring_<name>_alloc. It fails with COL_ERR_OVERFLOW as
+ * long as the previous frame using the same region wasn't retired.
+ *
+ * fring_<name>_retire(r, frame) marks frame and all earlier frames as
+ * retired, e.g. after their fence was signaled. It may be called from
+ * any thread. Only frames before the current frame can be retired.
+ *
+ * @brief fring_<name>_region(fring_<name> r, size_t* pLen)
+ * Returns the start of the current frame's region and puts the number
+ * of allocated entries at pLen.
+ *
+ * @brief fring_<name>_offset(fring_<name> r, const <type>* p)
+ * Returns the byte offset of p from the start of the allocation.
+ */
+#define ICE_FRING_ALIGNED __attribute__((aligned(CACHE_LINE_SIZE)))
+
+#define makeFrameRingApi(name, type) \
+    struct fring__##name {           \
+        char* data;                  \
+        size_t alignedSize;          \
+        size_t frame_cap;            \
+        size_t region_size;          \
+        size_t frames;               \
+        uint64_t frame;              \
+        uint64_t retired ICE_FRING_ALIGNED; \
+        size_t used ICE_FRING_ALIGNED;      \
+    };                               \
+    typedef struct fring__##name* fring_##name;                                             \
+    fring_##name fring_##name##_new(size_t align, size_t frame_cap);                        \
+    void fring_##name##_free(fring_##name r);                                               \
+    col_error_t fring_##name##_alloc(fring_##name r, size_t n, type** first);               \
+    col_error_t fring_##name##_begin_frame(fring_##name r, uint64_t* pFrame);               \
+    col_error_t fring_##name##_retire(fring_##name r, uint64_t frame);                      \
+    uint64_t fring_##name##_frame(fring_##name r);                                          \
+    size_t fring_##name##_used(fring_##name r);                                             \
+    size_t fring_##name##_frame_cap(fring_##name r);                                        \
+    size_t fring_##name##_frames(fring_##name r);                                           \
+    type* fring_##name##_region(fring_##name r, size_t* pLen);                              \
+    size_t fring_##name##_offset(fring_##name r, type const* p);
+
+#define makeFrameRingImpl(name, type, frames_in_flight) \
+fring_##name fring_##name##_new(size_t align, size_t frame_cap) {                           \
+    const size_t frames = (frames_in_flight);                                               \
+    const size_t region_align = align > CACHE_LINE_SIZE ? align : CACHE_LINE_SIZE;          \
+    const size_t alignedSize = ice_align_up(sizeof(type), align);                           \
+    if (frames == 0 || frame_cap == 0 || frame_cap > SIZE_MAX / frames / alignedSize) {     \
+        return NULL;                                                                        \
+    }                                                                                       \
+    fring_##name r = (fring_##name) ice_aligned_malloc(CACHE_LINE_SIZE, sizeof(struct fring__##name)); \
+    if (r == NULL) {                                                                        \
+        return NULL;                                                                        \
+    }                                                                                       \
+    r->alignedSize = alignedSize;                                                           \
+    r->frame_cap = frame_cap;                                                               \
+    r->region_size = ice_align_up(frame_cap * alignedSize, region_align);                   \
+    r->frames = frames;                                                                     \
+    r->frame = 0;                                                                           \
+    r->retired = 0;                                                                         \
+    r->used = 0;                                                                            \
+    if ((r->data = (char*) ice_aligned_malloc(region_align, frames * r->region_size)) == NULL) { \
+        ice_aligned_free(r);                                                                \
+        return NULL;                                                                        \
+    }                                                                                       \
+    ltrace("[fring_new] - frames=%zu, region_size=%zu", frames, r->region_size);            \
+    return r;                                                                               \
+}                                                                                           \
+void fring_##name##_free(fring_##name r) {                                                  \
+    if (r) {                                                                                \
+        ice_aligned_free(r->data);                                                          \
+        ice_aligned_free(r);                                                                \
+    }                                                                                       \
+}                                                                                           \
+col_error_t fring_##name##_alloc(fring_##name r, size_t n, type** first) {                  \
+    size_t used = __atomic_load_n(&r->used, __ATOMIC_RELAXED);                              \
+    do {                                                                                    \
+        if (n > r->frame_cap - used) {                                                      \
+            return COL_ERR_OVERFLOW;                                                        \
+        }                                                                                   \
+    } while (!__atomic_compare_exchange_n(&r->used, &used, used + n, true,                  \
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));             \
+    *first = (type*) (r->data + (r->frame % r->frames) * r->region_size + used * r->alignedSize); \
+    return COL_OK;                                                                          \
+}                                                                                           \
+col_error_t fring_##name##_begin_frame(fring_##name r, uint64_t* pFrame) {                  \
+    const uint64_t next = r->frame + 1;                                                     \
+    /* frame next reuses the region of frame next - frames */                              \
+    if (next >= __atomic_load_n(&r->retired, __ATOMIC_ACQUIRE) + r->frames) {               \
+        return COL_ERR_OVERFLOW;                                                            \
+    }                                                                                       \
+    __atomic_store_n(&r->used, 0, __ATOMIC_RELAXED);                                        \
+    __atomic_store_n(&r->frame, next, __ATOMIC_RELEASE);                                    \
+    if (pFrame) {                                                                           \
+        *pFrame = next;                                                                     \
+    }                                                                                       \
+    return COL_OK;                                                                          \
+}                                                                                           \
+col_error_t fring_##name##_retire(fring_##name r, uint64_t frame) {                         \
+    if (frame >= __atomic_load_n(&r->frame, __ATOMIC_ACQUIRE)) {                            \
+        return COL_ERR_ILLEGAL_ARGUMENT;                                                    \
+    }                                                                                       \
+    uint64_t retired = __atomic_load_n(&r->retired, __ATOMIC_RELAXED);                      \
+    while (retired <= frame &&                                                              \
+           !__atomic_compare_exchange_n(&r->retired, &retired, frame + 1, true,             \
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {              \
+    }                                                                                       \
+    return COL_OK;                                                                          \
+}                                                                                           \
+uint64_t fring_##name##_frame(fring_##name r) {                                             \
+    return __atomic_load_n(&r->frame, __ATOMIC_ACQUIRE);                                    \
+}                                                                                           \
+size_t fring_##name##_used(fring_##name r) {                                                \
+    return __atomic_load_n(&r->used, __ATOMIC_RELAXED);                                     \
+}                                                                                           \
+size_t fring_##name##_frame_cap(fring_##name r) {                                           \
+    return r->frame_cap;                                                                    \
+}                                                                                           \
+size_t fring_##name##_frames(fring_##name r) {                                              \
+    return r->frames;                                                                       \
+}                                                                                           \
+type* fring_##name##_region(fring_##name r, size_t* pLen) {                                 \
+    if (pLen) {                                                                             \
+        *pLen = __atomic_load_n(&r->used, __ATOMIC_RELAXED);                                \
+    }                                                                                       \
+    return (type*) (r->data + (r->frame % r->frames) * r->region_size);                     \
+}                                                                                           \
+size_t fring_##name##_offset(fring_##name r, type const* p) {                               \
+    return (size_t) ((char const*) p - r->data);                                            \
 }
 
 #ifdef __cplusplus
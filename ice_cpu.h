@@ -0,0 +1,78 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+#ifndef IEW_C_ESSENTIALS_ICE_CPU_H
+#define IEW_C_ESSENTIALS_ICE_CPU_H
+
+/**
+ * Helpers for SIMD kernels with runtime CPU dispatch. Only include this
+ * header from translation units (.c files) which implement kernels.
+ *
+ * Kernels are compiled with function level target attributes so the
+ * library itself can still be built for the baseline instruction set.
+ * A kernel is selected at call time by querying the CPU features, e.g.
+ *
+ * #if defined(ICE_SIMD_X86)
+ *     if (ice_cpu_has_avx2()) {
+ *         return kernel_avx2(...);
+ *     }
+ * #endif
+ *     return kernel_scalar(...);
+ *
+ * SIMD kernels are only compiled if IEW_ENABLE_SIMD is defined.
+ */
+
+#if defined(IEW_ENABLE_SIMD) && defined(__GNUC__) && defined(__x86_64__)
+
+#include <immintrin.h>
+
+#define ICE_SIMD_X86 1
+
+// popcnt is available on every CPU with SSE 4.2 or AVX2
+#define ICE_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#define ICE_TARGET_SSE4 __attribute__((target("sse4.2,popcnt")))
+
+static inline int ice_cpu_has_avx2(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+}
+
+static inline int ice_cpu_has_sse4(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+}
+
+#elif defined(IEW_ENABLE_SIMD) && defined(__GNUC__) && defined(__aarch64__) && defined(__ARM_NEON)
+
+#include <arm_neon.h>
+
+// NEON is part of the AArch64 baseline, no runtime check required
+#define ICE_SIMD_NEON 1
+
+#endif
+
+#endif //IEW_C_ESSENTIALS_ICE_CPU_H
@@ -0,0 +1,285 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+#ifndef IEW_C_ESSENTIALS_ICE_FLAT_MAP_MACROS_H
+#define IEW_C_ESSENTIALS_ICE_FLAT_MAP_MACROS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "icemalloc.h"
+#include "col_error.h"
+#include "icelogging.h"
+
+/**
+ * Macros to define typed flat maps. A flat map stores keys and values in
+ * two parallel arrays sorted by key. Lookups are branchless binary
+ * searches over the contiguous keys with zero per entry overhead, which
+ * suits read-mostly maps with up to a few thousand keys.
+ *
+ * Maps are built in batches: fmap_<name>_add appends entries unsorted and
+ * fmap_<name>_build sorts them by key once. If a key was added several
+ * times the last added value is kept. Lookups on a map with unbuilt
+ * entries are invalid (asserted in debug builds).
+ *
+ * fmap_<name>_put and fmap_<name>_erase keep the map sorted but need to
+ * move the entries behind the position, so they are O(n).
+ *
+ * fnKeyLess(k1, k2) must return true if k1 is ordered before k2.
+ */
+
+#define makeFlatMapApi(name, keyType, valueType) \
+typedef struct fmap_##name##_T * fmap_##name;                                                       \
+typedef col_error_t (*PFN_fmap_##name##_each)(keyType key, valueType val, void * pUserData);        \
+fmap_##name fmap_##name##_new();                                                                    \
+void fmap_##name##_free(fmap_##name m);                                                             \
+col_error_t fmap_##name##_reserve(fmap_##name m, size_t new_cap);                                   \
+col_error_t fmap_##name##_add(fmap_##name m, keyType key, valueType value);                         \
+col_error_t fmap_##name##_build(fmap_##name m);                                                     \
+col_error_t fmap_##name##_get(fmap_##name m, keyType key, valueType * res);                         \
+bool fmap_##name##_contains(fmap_##name m, keyType key);                                            \
+col_error_t fmap_##name##_put(fmap_##name m, keyType key, valueType value);                         \
+col_error_t fmap_##name##_erase(fmap_##name m, keyType key);                                        \
+void fmap_##name##_clear(fmap_##name m);                                                            \
+size_t fmap_##name##_len(fmap_##name m);                                                            \
+const keyType * fmap_##name##_keys(fmap_##name m);                                                  \
+valueType * fmap_##name##_values(fmap_##name m);                                                    \
+col_error_t fmap_##name##_each(fmap_##name m, PFN_fmap_##name##_each cb, void * pUserData);
+
+#define makeFlatMapImpl(name, keyType, valueType, fnKeyLess) \
+struct fmap_##name##_T {                                                                             \
+    keyType * keys;                                                                                  \
+    valueType * values;                                                                              \
+    size_t len;                                                                                      \
+    size_t cap;                                                                                      \
+    bool sorted;                                                                                     \
+};                                                                                                   \
+fmap_##name fmap_##name##_new() {                                                                    \
+    fmap_##name m = (fmap_##name) ice_malloc_ptr_aligned(sizeof(struct fmap_##name##_T));            \
+    if (m == NULL) {                                                                                 \
+        return NULL;                                                                                 \
+    }                                                                                                \
+    m->keys = NULL;                                                                                  \
+    m->values = NULL;                                                                                \
+    m->len = 0;                                                                                      \
+    m->cap = 0;                                                                                      \
+    m->sorted = true;                                                                                \
+    return m;                                                                                        \
+}                                                                                                    \
+void fmap_##name##_free(fmap_##name m) {                                                             \
+    if (m) {                                                                                         \
+        ice_aligned_free(m->keys);                                                                   \
+        ice_aligned_free(m->values);                                                                 \
+        ice_aligned_free(m);                                                                         \
+    }                                                                                                \
+}                                                                                                    \
+col_error_t fmap_##name##_reserve(fmap_##name m, size_t new_cap) {                                   \
+    if (new_cap <= m->cap) {                                                                         \
+        return COL_OK;                                                                               \
+    }                                                                                                \
+    new_cap = (size_t) ceil(VEC_GROWTH * (double) new_cap);                                          \
+    if (new_cap > SIZE_MAX / sizeof(keyType) || new_cap > SIZE_MAX / sizeof(valueType)) {            \
+        return COL_ERR_BAD_ALLOC;                                                                    \
+    }                                                                                                \
+    keyType * keys = (keyType *) ice_aligned_realloc(m->keys, CACHE_LINE_SIZE,                       \
+                                                     m->cap * sizeof(keyType),                       \
+                                                     new_cap * sizeof(keyType));                     \
+    if (keys == NULL) {                                                                              \
+        return COL_ERR_BAD_ALLOC;                                                                    \
+    }                                                                                                \
+    m->keys = keys;                                                                                  \
+    valueType * values = (valueType *) ice_aligned_realloc(m->values, CACHE_LINE_SIZE,               \
+                                                           m->cap * sizeof(valueType),               \
+                                                           new_cap * sizeof(valueType));             \
+    if (values == NULL) {                                                                            \
+        /* keys already have the new capacity, that's harmless */                                   \
+        return COL_ERR_BAD_ALLOC;                                                                    \
+    }                                                                                                \
+    m->values = values;                                                                              \
+    m->cap = new_cap;                                                                                \
+    return COL_OK;                                                                                   \
+}                                                                                                    \
+col_error_t fmap_##name##_add(fmap_##name m, keyType key, valueType value) {                         \
+    col_error_t err = COL_OK;                                                                        \
+    if (m->len == m->cap && (err = fmap_##name##_reserve(m, m->len + 1)) != COL_OK) {                \
+        return err;                                                                                  \
+    }                                                                                                \
+    if (m->sorted && m->len > 0 && !fnKeyLess(m->keys[m->len - 1], key)) {                           \
+        m->sorted = false;                                                                           \
+    }                                                                                                \
+    m->keys[m->len] = key;                                                                           \
+    m->values[m->len] = value;                                                                       \
+    m->len++;                                                                                        \
+    return COL_OK;                                                                                   \
+}                                                                                                    \
+col_error_t fmap_##name##_build(fmap_##name m) {                                                     \
+    if (m->sorted) {                                                                                 \
+        return COL_OK;                                                                               \
+    }                                                                                                \
+    const size_t n = m->len;                                                                         \
+    keyType * tmp_keys = (keyType *) ice_aligned_malloc(CACHE_LINE_SIZE, n * sizeof(keyType));       \
+    valueType * tmp_values = (valueType *) ice_aligned_malloc(CACHE_LINE_SIZE, n * sizeof(valueType));\
+    if (tmp_keys == NULL || tmp_values == NULL) {                                                    \
+        ice_aligned_free(tmp_keys);                                                                  \
+        ice_aligned_free(tmp_values);                                                                \
+        return COL_ERR_BAD_ALLOC;                                                                    \
+    }                                                                                                \
+    /* Stable bottom-up merge sort, so the last added of equal keys stays last */                   \
+    keyType * src_keys = m->keys;                                                                    \
+    valueType * src_values = m->values;                                                              \
+    keyType * dst_keys = tmp_keys;                                                                   \
+    valueType * dst_values = tmp_values;                                                             \
+    for (size_t width = 1; width < n; width *= 2) {                                                  \
+        for (size_t lo = 0; lo < n; lo += 2 * width) {                                               \
+            const size_t mid = lo + width < n ? lo + width : n;                                      \
+            const size_t hi = lo + 2 * width < n ? lo + 2 * width : n;                               \
+            size_t i = lo, j = mid, o = lo;                                                          \
+            while (i < mid && j < hi) {                                                              \
+                if (fnKeyLess(src_keys[j], src_keys[i])) {                                           \
+                    dst_keys[o] = src_keys[j];                                                       \
+                    dst_values[o++] = src_values[j++];                                               \
+                } else {                                                                             \
+                    dst_keys[o] = src_keys[i];                                                       \
+                    dst_values[o++] = src_values[i++];                                               \
+                }                                                                                    \
+            }                                                                                        \
+            for (; i < mid; ++i, ++o) {                                                              \
+                dst_keys[o] = src_keys[i];                                                           \
+                dst_values[o] = src_values[i];                                                       \
+            }                                                                                        \
+            for (; j < hi; ++j, ++o) {                                                               \
+                dst_keys[o] = src_keys[j];                                                           \
+                dst_values[o] = src_values[j];                                                       \
+            }                                                                                        \
+        }                                                                                            \
+        keyType * swap_keys = src_keys; src_keys = dst_keys; dst_keys = swap_keys;                   \
+        valueType * swap_values = src_values; src_values = dst_values; dst_values = swap_values;      \
+    }                                                                                                \
+    /* Remove duplicates, the last entry of a run of equal keys wins */                              \
+    size_t len = 0;                                                                                  \
+    for (size_t i = 0; i < n; ++i) {                                                                 \
+        if (i + 1 < n && !fnKeyLess(src_keys[i], src_keys[i + 1])) {                                 \
+            continue;                                                                                \
+        }                                                                                            \
+        m->keys[len] = src_keys[i];                                                                  \
+        m->values[len] = src_values[i];                                                              \
+        len++;                                                                                       \
+    }                                                                                                \
+    ice_aligned_free(tmp_keys);                                                                      \
+    ice_aligned_free(tmp_values);                                                                    \
+    m->len = len;                                                                                    \
+    m->sorted = true;                                                                                \
+    return COL_OK;                                                                                   \
+}                                                                                                    \
+static inline size_t fmap_##name##_lower_bound(fmap_##name m, keyType key) {                         \
+    IVK_ASSERT(m->sorted, "fmap_build must be called after fmap_add")                                \
+    if (m->len == 0) {                                                                               \
+        return 0;                                                                                    \
+    }                                                                                                \
+    const keyType * base = m->keys;                                                                  \
+    size_t n = m->len;                                                                               \
+    while (n > 1) {                                                                                  \
+        const size_t half = n / 2;                                                                   \
+        base = fnKeyLess(base[half], key) ? base + half : base;                                      \
+        n -= half;                                                                                   \
+    }                                                                                                \
+    return (size_t) (base - m->keys) + fnKeyLess(*base, key);                                        \
+}                                                                                                    \
+static inline bool fmap_##name##_found(fmap_##name m, size_t i, keyType key) {                       \
+    return i < m->len && !fnKeyLess(key, m->keys[i]);                                                \
+}                                                                                                    \
+col_error_t fmap_##name##_get(fmap_##name m, keyType key, valueType * res) {                         \
+    const size_t i = fmap_##name##_lower_bound(m, key);                                              \
+    if (!fmap_##name##_found(m, i, key)) {                                                           \
+        return COL_ERR_ILLEGAL_ARGUMENT;                                                             \
+    }                                                                                                \
+    *res = m->values[i];                                                                             \
+    return COL_OK;                                                                                   \
+}                                                                                                    \
+bool fmap_##name##_contains(fmap_##name m, keyType key) {                                            \
+    return fmap_##name##_found(m, fmap_##name##_lower_bound(m, key), key);                           \
+}                                                                                                    \
+col_error_t fmap_##name##_put(fmap_##name m, keyType key, valueType value) {                         \
+    const size_t i = fmap_##name##_lower_bound(m, key);                                              \
+    if (fmap_##name##_found(m, i, key)) {                                                            \
+        m->values[i] = value;                                                                        \
+        return COL_OK;                                                                               \
+    }                                                                                                \
+    col_error_t err = COL_OK;                                                                        \
+    if (m->len == m->cap && (err = fmap_##name##_reserve(m, m->len + 1)) != COL_OK) {                \
+        return err;                                                                                  \
+    }                                                                                                \
+    memmove(m->keys + i + 1, m->keys + i, (m->len - i) * sizeof(keyType));                           \
+    memmove(m->values + i + 1, m->values + i, (m->len - i) * sizeof(valueType));                     \
+    m->keys[i] = key;                                                                                \
+    m->values[i] = value;                                                                            \
+    m->len++;                                                                                        \
+    return COL_OK;                                                                                   \
+}                                                                                                    \
+col_error_t fmap_##name##_erase(fmap_##name m, keyType key) {                                        \
+    const size_t i = fmap_##name##_lower_bound(m, key);                                              \
+    if (!fmap_##name##_found(m, i, key)) {                                                           \
+        return COL_ERR_ILLEGAL_ARGUMENT;                                                             \
+    }                                                                                                \
+    memmove(m->keys + i, m->keys + i + 1, (m->len - i - 1) * sizeof(keyType));                       \
+    memmove(m->values + i, m->values + i + 1, (m->len - i - 1) * sizeof(valueType));                 \
+    m->len--;                                                                                        \
+    return COL_OK;                                                                                   \
+}                                                                                                    \
+void fmap_##name##_clear(fmap_##name m) {                                                            \
+    m->len = 0;                                                                                      \
+    m->sorted = true;                                                                                \
+}                                                                                                    \
+size_t fmap_##name##_len(fmap_##name m) {                                                            \
+    return m->len;                                                                                   \
+}                                                                                                    \
+const keyType * fmap_##name##_keys(fmap_##name m) {                                                  \
+    return m->keys;                                                                                  \
+}                                                                                                    \
+valueType * fmap_##name##_values(fmap_##name m) {                                                    \
+    return m->values;                                                                                \
+}                                                                                                    \
+col_error_t fmap_##name##_each(fmap_##name m, PFN_fmap_##name##_each cb, void * pUserData) {         \
+    col_error_t err = COL_OK;                                                                        \
+    for (size_t i = 0; i < m->len; i++) {                                                            \
+        if ((err = cb(m->keys[i], m->values[i], pUserData)) != COL_OK) {                             \
+            return err;                                                                              \
+        }                                                                                            \
+    }                                                                                                \
+    return COL_OK;                                                                                   \
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //IEW_C_ESSENTIALS_ICE_FLAT_MAP_MACROS_H
@@ -0,0 +1,265 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+#ifndef IEW_C_ESSENTIALS_ICE_RING_MACROS_H
+#define IEW_C_ESSENTIALS_ICE_RING_MACROS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "col_error.h"
+#include "icemalloc.h"
+#include "icelogging.h"
+
+/**
+ * Macros to define bounded lock-free ring buffers (FIFO queues). The
+ * capacity is rounded up to a power of two.
+ *
+ * ICE_RING_SPSC: exactly one thread pushes and exactly one thread pops.
+ * Push and pop are wait-free, batches are copied with at most two memcpy.
+ *
+ * ICE_RING_MPMC: any number of threads push and pop. Every slot carries
+ * a sequence number which tells whether the slot is free for the
+ * producers of a lap or filled for its consumers (D. Vyukov's bounded
+ * MPMC queue). Batches claim a run of consecutive slots with a single
+ * CAS.
+ *
+ * Producer and consumer positions live on separate cache lines.
+ *
+ * ring_<name>_push returns COL_ERR_OVERFLOW if the ring is full and
+ * ring_<name>_pop returns COL_ERR_UNDERFLOW if the ring is empty. The
+ * batch functions return the number of elements transferred, which may
+ * be less than requested.
+ *
+ * ring_<name>_len is exact only if no other thread uses the ring.
+ */
+
+typedef enum ice_ring_mode {
+    ICE_RING_SPSC = 0,
+    ICE_RING_MPMC
+} ice_ring_mode;
+
+#define ICE_RING_ALIGNED __attribute__((aligned(CACHE_LINE_SIZE)))
+
+#define makeRingOfTypeApi(name, type) \
+    struct ring_cell__##name {                                                                      \
+        size_t seq;                                                                                 \
+        type val;                                                                                   \
+    };                                                                                              \
+    struct ring__##name {                                                                           \
+        size_t mask;                                                                                \
+        ice_ring_mode mode;                                                                         \
+        type * data;                                                                                \
+        struct ring_cell__##name * cells;                                                           \
+        /* written by producers */                                                                  \
+        size_t tail ICE_RING_ALIGNED;                                                               \
+        size_t cached_head;                                                                         \
+        /* written by consumers */                                                                  \
+        size_t head ICE_RING_ALIGNED;                                                               \
+        size_t cached_tail;                                                                         \
+    };                                                                                              \
+    typedef struct ring__##name * ring_##name;                                                      \
+    ring_##name ring_##name##_new(size_t cap, ice_ring_mode mode);                                  \
+    void ring_##name##_free(ring_##name r);                                                         \
+    col_error_t ring_##name##_push(ring_##name r, type val);                                        \
+    col_error_t ring_##name##_pop(ring_##name r, type * res);                                       \
+    size_t ring_##name##_push_n(ring_##name r, type const* src, size_t n);                          \
+    size_t ring_##name##_pop_n(ring_##name r, type * dst, size_t n);                                \
+    size_t ring_##name##_cap(ring_##name r);                                                        \
+    size_t ring_##name##_len(ring_##name r);                                                        \
+    bool ring_##name##_empty(ring_##name r);
+
+#define makeRingOfTypeImpl(name, type) \
+ring_##name ring_##name##_new(size_t cap, ice_ring_mode mode) {                                     \
+    if (cap < 2) {                                                                                  \
+        cap = 2;                                                                                    \
+    }                                                                                               \
+    if (cap > (SIZE_MAX >> 2) / sizeof(struct ring_cell__##name)) {                                 \
+        return NULL;                                                                                \
+    }                                                                                               \
+    size_t pow2 = 2;                                                                                \
+    while (pow2 < cap) {                                                                            \
+        pow2 <<= 1;                                                                                 \
+    }                                                                                               \
+    ltrace("[ring_new] - cap=%ld, mode=%d", pow2, mode);                                            \
+    ring_##name r = (ring_##name) ice_malloc_cache_aligned(sizeof(struct ring__##name));            \
+    if (r == NULL) {                                                                                \
+        return NULL;                                                                                \
+    }                                                                                               \
+    r->mask = pow2 - 1;                                                                             \
+    r->mode = mode;                                                                                 \
+    r->data = NULL;                                                                                 \
+    r->cells = NULL;                                                                                \
+    r->tail = 0;                                                                                    \
+    r->cached_head = 0;                                                                             \
+    r->head = 0;                                                                                    \
+    r->cached_tail = 0;                                                                             \
+    if (mode == ICE_RING_MPMC) {                                                                    \
+        r->cells = (struct ring_cell__##name *) ice_malloc_cache_aligned(                           \
+                pow2 * sizeof(struct ring_cell__##name));                                           \
+        if (r->cells != NULL) {                                                                     \
+            for (size_t i = 0; i < pow2; ++i) {                                                     \
+                r->cells[i].seq = i;                                                                \
+            }                                                                                       \
+        }                                                                                           \
+    } else {                                                                                        \
+        r->data = (type *) ice_malloc_cache_aligned(pow2 * sizeof(type));                           \
+    }                                                                                               \
+    if (r->cells == NULL && r->data == NULL) {                                                      \
+        ice_aligned_free(r);                                                                        \
+        return NULL;                                                                                \
+    }                                                                                               \
+    return r;                                                                                       \
+}                                                                                                   \
+void ring_##name##_free(ring_##name r) {                                                            \
+    if (r) {                                                                                        \
+        ice_aligned_free(r->data);                                                                  \
+        ice_aligned_free(r->cells);                                                                 \
+        ice_aligned_free(r);                                                                        \
+    }                                                                                               \
+}                                                                                                   \
+/* Number of free slots for the single producer */                                                \
+static inline size_t ring_##name##_spsc_free(ring_##name r, size_t tail, size_t n) {                \
+    size_t free = r->mask + 1 - (tail - r->cached_head);                                            \
+    if (free < n) {                                                                                 \
+        r->cached_head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);                               \
+        free = r->mask + 1 - (tail - r->cached_head);                                               \
+    }                                                                                               \
+    return free;                                                                                    \
+}                                                                                                   \
+/* Number of filled slots for the single consumer */                                              \
+static inline size_t ring_##name##_spsc_filled(ring_##name r, size_t head, size_t n) {              \
+    size_t filled = r->cached_tail - head;                                                          \
+    if (filled < n) {                                                                               \
+        r->cached_tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);                               \
+        filled = r->cached_tail - head;                                                             \
+    }                                                                                               \
+    return filled;                                                                                  \
+}                                                                                                   \
+/* Claims up to n consecutive slots whose sequence is pos + offset */                             \
+static inline size_t ring_##name##_mpmc_claim(ring_##name r, size_t * pos_ptr, size_t * pPos,      \
+                                              size_t n, size_t offset) {                            \
+    size_t pos = __atomic_load_n(pos_ptr, __ATOMIC_RELAXED);                                        \
+    for (;;) {                                                                                      \
+        bool stale = false;                                                                         \
+        size_t k = 0;                                                                               \
+        for (; k < n; ++k) {                                                                        \
+            const size_t seq = __atomic_load_n(&r->cells[(pos + k) & r->mask].seq, __ATOMIC_ACQUIRE);\
+            const intptr_t diff = (intptr_t) (seq - (pos + k + offset));                           \
+            if (diff != 0) {                                                                        \
+                /* diff > 0: another thread took the slot, pos is outdated */                       \
+                stale = k == 0 && diff > 0;                                                         \
+                break;                                                                              \
+            }                                                                                       \
+        }                                                                                           \
+        if (stale) {                                                                                \
+            pos = __atomic_load_n(pos_ptr, __ATOMIC_RELAXED);                                       \
+        } else if (k == 0) {                                                                        \
+            return 0;                                                                               \
+        } else if (__atomic_compare_exchange_n(pos_ptr, &pos, pos + k, true,                        \
+                                               __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {               \
+            *pPos = pos;                                                                            \
+            return k;                                                                               \
+        }                                                                                           \
+    }                                                                                               \
+}                                                                                                   \
+size_t ring_##name##_push_n(ring_##name r, type const* src, size_t n) {                             \
+    if (r->mode == ICE_RING_SPSC) {                                                                 \
+        const size_t tail = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);                            \
+        const size_t free = ring_##name##_spsc_free(r, tail, n);                                    \
+        if (n > free) {                                                                             \
+            n = free;                                                                               \
+        }                                                                                           \
+        const size_t i = tail & r->mask;                                                            \
+        const size_t first = r->mask + 1 - i < n ? r->mask + 1 - i : n;                             \
+        memcpy(r->data + i, src, first * sizeof(type));                                             \
+        memcpy(r->data, src + first, (n - first) * sizeof(type));                                  \
+        __atomic_store_n(&r->tail, tail + n, __ATOMIC_RELEASE);                                     \
+        return n;                                                                                   \
+    }                                                                                               \
+    size_t pos = 0;                                                                                 \
+    n = ring_##name##_mpmc_claim(r, &r->tail, &pos, n, 0);                                          \
+    for (size_t k = 0; k < n; ++k) {                                                                \
+        struct ring_cell__##name * cell = &r->cells[(pos + k) & r->mask];                           \
+        cell->val = src[k];                                                                         \
+        __atomic_store_n(&cell->seq, pos + k + 1, __ATOMIC_RELEASE);                                \
+    }                                                                                               \
+    return n;                                                                                       \
+}                                                                                                   \
+size_t ring_##name##_pop_n(ring_##name r, type * dst, size_t n) {                                   \
+    if (r->mode == ICE_RING_SPSC) {                                                                 \
+        const size_t head = __atomic_load_n(&r->head, __ATOMIC_RELAXED);                            \
+        const size_t filled = ring_##name##_spsc_filled(r, head, n);                                \
+        if (n > filled) {                                                                           \
+            n = filled;                                                                             \
+        }                                                                                           \
+        const size_t i = head & r->mask;                                                            \
+        const size_t first = r->mask + 1 - i < n ? r->mask + 1 - i : n;                             \
+        memcpy(dst, r->data + i, first * sizeof(type));                                             \
+        memcpy(dst + first, r->data, (n - first) * sizeof(type));                                   \
+        __atomic_store_n(&r->head, head + n, __ATOMIC_RELEASE);                                     \
+        return n;                                                                                   \
+    }                                                                                               \
+    size_t pos = 0;                                                                                 \
+    n = ring_##name##_mpmc_claim(r, &r->head, &pos, n, 1);                                          \
+    for (size_t k = 0; k < n; ++k) {                                                                \
+        struct ring_cell__##name * cell = &r->cells[(pos + k) & r->mask];                           \
+        dst[k] = cell->val;                                                                         \
+        __atomic_store_n(&cell->seq, pos + k + r->mask + 1, __ATOMIC_RELEASE);                      \
+    }                                                                                               \
+    return n;                                                                                       \
+}                                                                                                   \
+col_error_t ring_##name##_push(ring_##name r, type val) {                                           \
+    return ring_##name##_push_n(r, &val, 1) == 1 ? COL_OK : COL_ERR_OVERFLOW;                       \
+}                                                                                                   \
+col_error_t ring_##name##_pop(ring_##name r, type * res) {                                          \
+    return ring_##name##_pop_n(r, res, 1) == 1 ? COL_OK : COL_ERR_UNDERFLOW;                        \
+}                                                                                                   \
+size_t ring_##name##_cap(ring_##name r) {                                                           \
+    return r->mask + 1;                                                                             \
+}                                                                                                   \
+size_t ring_##name##_len(ring_##name r) {                                                           \
+    const size_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);                                \
+    const size_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);                                \
+    /* the positions are read one after the other, consumers may have moved on */                   \
+    const size_t len = tail - head;                                                                 \
+    return len > r->mask + 1 ? r->mask + 1 : len;                                                   \
+}                                                                                                   \
+bool ring_##name##_empty(ring_##name r) {                                                           \
+    return ring_##name##_len(r) == 0;                                                               \
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //IEW_C_ESSENTIALS_ICE_RING_MACROS_H
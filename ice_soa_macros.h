@@ -0,0 +1,222 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+#ifndef IEW_C_ESSENTIALS_ICE_SOA_MACROS_H
+#define IEW_C_ESSENTIALS_ICE_SOA_MACROS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "col_error.h"
+#include "icemalloc.h"
+#include "icelogging.h"
+
+/**
+ * Macros to define structure of arrays buffers. Every field is stored in
+ * its own column, so a pass over one field only loads that field:
+ *
+ * makeSoaBufApi(particle, (x, float), (y, float), (mass, float))
+ * makeSoaBufImpl(particle, (x, float), (y, float), (mass, float))
+ *
+ * defines soa_particle with the columns soa_particle_x(v),
+ * soa_particle_y(v) and soa_particle_mass(v). All columns share lim and
+ * cap. Up to 16 fields are supported.
+ *
+ * Columns are aligned to align (at least to the alignment of the field
+ * type) and padded to whole cache lines, so SIMD loops may process the
+ * cache line holding the last entry completely instead of handling a
+ * scalar tail. Column pointers are invalidated by operations which grow
+ * the buffer.
+ */
+
+#define ICE_SOA_NARGS(...) ICE_SOA_NARGS_(__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1)
+#define ICE_SOA_NARGS_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, N, ...) N
+#define ICE_SOA_CAT(a, b) ICE_SOA_CAT_(a, b)
+#define ICE_SOA_CAT_(a, b) a##b
+#define ICE_SOA_UNPACK(f, t) f, t
+#define ICE_SOA_INVOKE(m, args) m args
+#define ICE_SOA_APPLY(m, ctx, pair) ICE_SOA_INVOKE(m, (ctx, ICE_SOA_UNPACK pair))
+// Expands m(ctx, field, type) for every (field, type) pair
+#define ICE_SOA_FOR_EACH(m, ctx, ...) ICE_SOA_CAT(ICE_SOA_FE_, ICE_SOA_NARGS(__VA_ARGS__))(m, ctx, __VA_ARGS__)
+#define ICE_SOA_FE_1(m, ctx, x) ICE_SOA_APPLY(m, ctx, x)
+#define ICE_SOA_FE_2(m, ctx, x, ...) ICE_SOA_APPLY(m, ctx, x) ICE_SOA_FE_1(m, ctx, __VA_ARGS__)
+#define ICE_SOA_FE_3(m, ctx, x, ...) ICE_SOA_APPLY(m, ctx, x) ICE_SOA_FE_2(m, ctx, __VA_ARGS__)
+#define ICE_SOA_FE_4(m, ctx, x, ...) ICE_SOA_APPLY(m, ctx, x) ICE_SOA_FE_3(m, ctx, __VA_ARGS__)
+#define ICE_SOA_FE_5(m, ctx, x, ...) ICE_SOA_APPLY(m, ctx, x) ICE_SOA_FE_4(m, ctx, __VA_ARGS__)
+#define ICE_SOA_FE_6(m, ctx, x, ...) ICE_SOA_APPLY(m, ctx, x) ICE_SOA_FE_5(m, ctx, __VA_ARGS__)
+#define ICE_SOA_FE_7(m, ctx, x, ...) ICE_SOA_APPLY(m, ctx, x) ICE_SOA_FE_6(m, ctx, __VA_ARGS__)
+#define ICE_SOA_FE_8(m, ctx, x, ...) ICE_SOA_APPLY(m, ctx, x) ICE_SOA_FE_7(m, ctx, __VA_ARGS__)
+#define ICE_SOA_FE_9(m, ctx, x, ...) ICE_SOA_APPLY(m, ctx, x) ICE_SOA_FE_8(m, ctx, __VA_ARGS__)
+#define ICE_SOA_FE_10(m, ctx, x, ...) ICE_SOA_APPLY(m, ctx, x) ICE_SOA_FE_9(m, ctx, __VA_ARGS__)
+#define ICE_SOA_FE_11(m, ctx, x, ...) ICE_SOA_APPLY(m, ctx, x) ICE_SOA_FE_10(m, ctx, __VA_ARGS__)
+#define ICE_SOA_FE_12(m, ctx, x, ...) ICE_SOA_APPLY(m, ctx, x) ICE_SOA_FE_11(m, ctx, __VA_ARGS__)
+#define ICE_SOA_FE_13(m, ctx, x, ...) ICE_SOA_APPLY(m, ctx, x) ICE_SOA_FE_12(m, ctx, __VA_ARGS__)
+#define ICE_SOA_FE_14(m, ctx, x, ...) ICE_SOA_APPLY(m, ctx, x) ICE_SOA_FE_13(m, ctx, __VA_ARGS__)
+#define ICE_SOA_FE_15(m, ctx, x, ...) ICE_SOA_APPLY(m, ctx, x) ICE_SOA_FE_14(m, ctx, __VA_ARGS__)
+#define ICE_SOA_FE_16(m, ctx, x, ...) ICE_SOA_APPLY(m, ctx, x) ICE_SOA_FE_15(m, ctx, __VA_ARGS__)
+
+#define ICE_SOA_COL_ALIGN(v, t) ((v)->align < alignof(t) ? alignof(t) : (v)->align)
+#define ICE_SOA_COL_SIZE(cap, t) ice_align_up((cap) * sizeof(t), CACHE_LINE_SIZE)
+
+#define ICE_SOA_MEMBER(name, f, t) t* f;
+#define ICE_SOA_PARAM(name, f, t) , t f
+#define ICE_SOA_COLUMN_DECL(name, f, t) t* soa_##name##_##f(soa_##name v);
+#define ICE_SOA_COLUMN_IMPL(name, f, t) t* soa_##name##_##f(soa_##name v) { return v->f; }
+#define ICE_SOA_INIT(v, f, t) (v)->f = NULL;
+#define ICE_SOA_FREE(v, f, t) ice_aligned_free((v)->f);
+#define ICE_SOA_MAX_SIZE(max, f, t) (max) = sizeof(t) > (max) ? sizeof(t) : (max);
+#define ICE_SOA_REALLOC(v, f, t) \
+    if (err == COL_OK) {                                                                    \
+        t* col = (t*) ice_aligned_realloc((v)->f, ICE_SOA_COL_ALIGN(v, t),                  \
+                                          ICE_SOA_COL_SIZE((v)->cap, t),                    \
+                                          ICE_SOA_COL_SIZE(new_cap, t));                    \
+        if (col == NULL) {                                                                  \
+            err = COL_ERR_BAD_ALLOC;                                                        \
+        } else {                                                                            \
+            (v)->f = col;                                                                   \
+        }                                                                                   \
+    }
+#define ICE_SOA_STORE(v, f, t) (v)->f[(v)->lim] = f;
+#define ICE_SOA_MOVE(v, f, t) (v)->f[i] = (v)->f[(v)->lim - 1];
+
+#define makeSoaBufApi(name, ...) \
+    struct soa__##name {                                                                    \
+        size_t lim;                                                                         \
+        size_t cap;                                                                         \
+        size_t align;                                                                       \
+        ICE_SOA_FOR_EACH(ICE_SOA_MEMBER, name, __VA_ARGS__)                                 \
+    };                                                                                      \
+    typedef struct soa__##name* soa_##name;                                                 \
+    typedef col_error_t (*PFN_soa_##name##_each)(soa_##name v, size_t i, void * pUserData); \
+    soa_##name soa_##name##_new(size_t align);                                              \
+    void soa_##name##_free(soa_##name v);                                                   \
+    col_error_t soa_##name##_reserve(soa_##name v, size_t new_cap);                         \
+    col_error_t soa_##name##_push_back(soa_##name v ICE_SOA_FOR_EACH(ICE_SOA_PARAM, name, __VA_ARGS__)); \
+    col_error_t soa_##name##_emplace_back(soa_##name v, size_t* pIndex);                    \
+    col_error_t soa_##name##_swap_remove(soa_##name v, size_t i);                           \
+    size_t soa_##name##_lim(soa_##name v);                                                  \
+    void soa_##name##_set_lim(soa_##name v, size_t lim);                                    \
+    void soa_##name##_clear(soa_##name v);                                                  \
+    int soa_##name##_empty(soa_##name v);                                                   \
+    col_error_t soa_##name##_each(soa_##name v, PFN_soa_##name##_each cb, void * pUserData); \
+    ICE_SOA_FOR_EACH(ICE_SOA_COLUMN_DECL, name, __VA_ARGS__)
+
+#define makeSoaBufImpl(name, ...) \
+soa_##name soa_##name##_new(size_t align) {                                                 \
+    soa_##name v = (soa_##name) ice_aligned_malloc(PTR_ALIGN, sizeof(struct soa__##name));  \
+    if (v) {                                                                                \
+        v->lim = 0;                                                                         \
+        v->cap = 0;                                                                         \
+        v->align = align;                                                                   \
+        ICE_SOA_FOR_EACH(ICE_SOA_INIT, v, __VA_ARGS__)                                      \
+    }                                                                                       \
+    return v;                                                                               \
+}                                                                                           \
+void soa_##name##_free(soa_##name v) {                                                      \
+    if (v) {                                                                                \
+        ICE_SOA_FOR_EACH(ICE_SOA_FREE, v, __VA_ARGS__)                                      \
+        ice_aligned_free(v);                                                                \
+    }                                                                                       \
+}                                                                                           \
+col_error_t soa_##name##_reserve(soa_##name v, size_t new_cap) {                            \
+    if (new_cap <= v->cap) {                                                                \
+        return COL_OK;                                                                      \
+    }                                                                                       \
+    new_cap = (size_t) ceil(VEC_GROWTH * (double) new_cap);                                 \
+    size_t max_size = 0;                                                                    \
+    ICE_SOA_FOR_EACH(ICE_SOA_MAX_SIZE, max_size, __VA_ARGS__)                               \
+    if (new_cap > (SIZE_MAX - CACHE_LINE_SIZE) / max_size) {                                \
+        return COL_ERR_BAD_ALLOC;                                                           \
+    }                                                                                       \
+    ltrace("[soa_reserve] - lim=%ld, cap=%ld, new cap=%ld", v->lim, v->cap, new_cap);      \
+    /* Columns which already grew before a failure keep their larger block,                 \
+     * the next reserve copies from them again */                                           \
+    col_error_t err = COL_OK;                                                               \
+    ICE_SOA_FOR_EACH(ICE_SOA_REALLOC, v, __VA_ARGS__)                                       \
+    if (err == COL_OK) {                                                                    \
+        v->cap = new_cap;                                                                   \
+    }                                                                                       \
+    return err;                                                                             \
+}                                                                                           \
+col_error_t soa_##name##_push_back(soa_##name v ICE_SOA_FOR_EACH(ICE_SOA_PARAM, name, __VA_ARGS__)) { \
+    col_error_t err = COL_OK;                                                               \
+    if (v->lim == v->cap && (err = soa_##name##_reserve(v, v->lim + 1)) != COL_OK) {        \
+        return err;                                                                         \
+    }                                                                                       \
+    ICE_SOA_FOR_EACH(ICE_SOA_STORE, v, __VA_ARGS__)                                         \
+    v->lim++;                                                                               \
+    return COL_OK;                                                                          \
+}                                                                                           \
+col_error_t soa_##name##_emplace_back(soa_##name v, size_t* pIndex) {                       \
+    col_error_t err = COL_OK;                                                               \
+    if (v->lim == v->cap && (err = soa_##name##_reserve(v, v->lim + 1)) != COL_OK) {        \
+        return err;                                                                         \
+    }                                                                                       \
+    *pIndex = v->lim++;                                                                     \
+    return COL_OK;                                                                          \
+}                                                                                           \
+col_error_t soa_##name##_swap_remove(soa_##name v, size_t i) {                              \
+    if (i >= v->lim) {                                                                      \
+        return COL_ERR_ILLEGAL_ARGUMENT;                                                    \
+    }                                                                                       \
+    ICE_SOA_FOR_EACH(ICE_SOA_MOVE, v, __VA_ARGS__)                                          \
+    v->lim--;                                                                               \
+    return COL_OK;                                                                          \
+}                                                                                           \
+size_t soa_##name##_lim(soa_##name v) {                                                     \
+    return v->lim;                                                                          \
+}                                                                                           \
+void soa_##name##_set_lim(soa_##name v, size_t lim) {                                       \
+    v->lim = lim > v->cap ? v->cap : lim;                                                   \
+}                                                                                           \
+void soa_##name##_clear(soa_##name v) {                                                     \
+    v->lim = 0;                                                                             \
+}                                                                                           \
+int soa_##name##_empty(soa_##name v) {                                                      \
+    return v->lim == 0;                                                                     \
+}                                                                                           \
+col_error_t soa_##name##_each(soa_##name v, PFN_soa_##name##_each cb, void * pUserData) {   \
+    col_error_t err = COL_OK;                                                               \
+    for (size_t i = 0; i < v->lim; ++i) {                                                   \
+        if ((err = cb(v, i, pUserData)) != COL_OK) {                                        \
+            return err;                                                                     \
+        }                                                                                   \
+    }                                                                                       \
+    return COL_OK;                                                                          \
+}                                                                                           \
+ICE_SOA_FOR_EACH(ICE_SOA_COLUMN_IMPL, name, __VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //IEW_C_ESSENTIALS_ICE_SOA_MACROS_H
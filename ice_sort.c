@@ -0,0 +1,261 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "ice_sort.h"
+#include "icemalloc.h"
+#include "icelogging.h"
+
+#define ICE_RADIX_BUCKETS 256
+
+static unsigned ice_sort_num_threads(size_t n) {
+    if (n < ICE_SORT_PARALLEL_THRESHOLD) {
+        return 1;
+    }
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus <= 1) {
+        return 1;
+    }
+    return cpus > ICE_SORT_MAX_THREADS ? ICE_SORT_MAX_THREADS : (unsigned) cpus;
+}
+
+// Moves the payload elements to the positions given by the permutation idx
+static col_error_t ice_sort_permute_payload(const size_t * idx, size_t n, void * payload, size_t payload_size) {
+    char * tmp = ice_aligned_malloc(CACHE_LINE_SIZE, n * payload_size);
+    if (tmp == NULL) {
+        return COL_ERR_BAD_ALLOC;
+    }
+    const char * src = payload;
+    for (size_t i = 0; i < n; ++i) {
+        memcpy(tmp + i * payload_size, src + idx[i] * payload_size, payload_size);
+    }
+    memcpy(payload, tmp, n * payload_size);
+    ice_aligned_free(tmp);
+    return COL_OK;
+}
+
+/*
+ * Each thread owns a contiguous chunk of the keys. A pass consists of
+ * 3 phases separated by barriers:
+ *   1. every thread counts the digits in its chunk
+ *   2. thread 0 turns the counts into scatter offsets (digit major,
+ *      thread minor, which keeps the sort stable)
+ *   3. every thread scatters its chunk into the other buffer
+ */
+#define makeRadixSortImpl(suffix, keyType, passes) \
+struct ice_radix_job_##suffix {                                                                      \
+    keyType * keys[2];                                                                               \
+    size_t * idx[2];                                                                                 \
+    size_t n;                                                                                        \
+    unsigned nthreads;                                                                               \
+    size_t (*offsets)[ICE_RADIX_BUCKETS];                                                            \
+    pthread_barrier_t barrier;                                                                       \
+    pthread_mutex_t gate_lock;                                                                       \
+    pthread_cond_t gate_cond;                                                                        \
+    int gate_open;                                                                                   \
+    int skip;                                                                                        \
+    int src;                                                                                         \
+};                                                                                                   \
+                                                                                                     \
+struct ice_radix_worker_##suffix {                                                                   \
+    struct ice_radix_job_##suffix * job;                                                             \
+    unsigned t;                                                                                      \
+};                                                                                                   \
+                                                                                                     \
+static inline void ice_radix_wait_##suffix(struct ice_radix_job_##suffix * job) {                    \
+    if (job->nthreads > 1) {                                                                         \
+        pthread_barrier_wait(&job->barrier);                                                         \
+    }                                                                                                \
+}                                                                                                    \
+                                                                                                     \
+static void * ice_radix_run_##suffix(void * pArg) {                                                  \
+    struct ice_radix_worker_##suffix * worker = pArg;                                                \
+    struct ice_radix_job_##suffix * job = worker->job;                                               \
+    const unsigned t = worker->t;                                                                    \
+    if (t != 0) {                                                                                    \
+        /* Wait until the number of participating threads is known */                                \
+        pthread_mutex_lock(&job->gate_lock);                                                         \
+        while (!job->gate_open) {                                                                    \
+            pthread_cond_wait(&job->gate_cond, &job->gate_lock);                                     \
+        }                                                                                            \
+        pthread_mutex_unlock(&job->gate_lock);                                                       \
+        if (t >= job->nthreads) {                                                                    \
+            return NULL;                                                                             \
+        }                                                                                            \
+    }                                                                                                \
+    const size_t lo = job->n * t / job->nthreads;                                                    \
+    const size_t hi = job->n * (t + 1) / job->nthreads;                                              \
+    size_t * offsets = job->offsets[t];                                                              \
+    int src = 0;                                                                                     \
+                                                                                                     \
+    for (unsigned pass = 0; pass < (passes); ++pass) {                                               \
+        const unsigned shift = pass * 8;                                                             \
+        const keyType * keys = job->keys[src];                                                       \
+                                                                                                     \
+        memset(offsets, 0, ICE_RADIX_BUCKETS * sizeof(size_t));                                      \
+        for (size_t i = lo; i < hi; ++i) {                                                           \
+            offsets[(keys[i] >> shift) & 0xFF]++;                                                    \
+        }                                                                                            \
+        ice_radix_wait_##suffix(job);                                                                \
+                                                                                                     \
+        if (t == 0) {                                                                                \
+            job->skip = 0;                                                                           \
+            size_t sum = 0;                                                                          \
+            for (unsigned d = 0; d < ICE_RADIX_BUCKETS; ++d) {                                       \
+                size_t total = 0;                                                                    \
+                for (unsigned tt = 0; tt < job->nthreads; ++tt) {                                    \
+                    const size_t count = job->offsets[tt][d];                                        \
+                    job->offsets[tt][d] = sum + total;                                               \
+                    total += count;                                                                  \
+                }                                                                                    \
+                if (total == job->n) {                                                               \
+                    /* All keys have the same digit, nothing to do */                                \
+                    job->skip = 1;                                                                   \
+                }                                                                                    \
+                sum += total;                                                                        \
+            }                                                                                        \
+        }                                                                                            \
+        ice_radix_wait_##suffix(job);                                                                \
+                                                                                                     \
+        const int skip = job->skip;                                                                  \
+        if (!skip) {                                                                                 \
+            keyType * dst = job->keys[1 - src];                                                      \
+            if (job->idx[0] != NULL) {                                                               \
+                const size_t * idx = job->idx[src];                                                  \
+                size_t * idx_dst = job->idx[1 - src];                                                \
+                for (size_t i = lo; i < hi; ++i) {                                                   \
+                    const size_t pos = offsets[(keys[i] >> shift) & 0xFF]++;                         \
+                    dst[pos] = keys[i];                                                              \
+                    idx_dst[pos] = idx[i];                                                           \
+                }                                                                                    \
+            } else {                                                                                 \
+                for (size_t i = lo; i < hi; ++i) {                                                   \
+                    dst[offsets[(keys[i] >> shift) & 0xFF]++] = keys[i];                             \
+                }                                                                                    \
+            }                                                                                        \
+            src = 1 - src;                                                                           \
+        }                                                                                            \
+        ice_radix_wait_##suffix(job);                                                                \
+    }                                                                                                \
+    if (t == 0) {                                                                                    \
+        job->src = src;                                                                              \
+    }                                                                                                \
+    return NULL;                                                                                     \
+}                                                                                                    \
+                                                                                                     \
+col_error_t ice_radix_sort_##suffix(keyType * keys, size_t n, void * payload, size_t payload_size) { \
+    if (n < 2) {                                                                                     \
+        return COL_OK;                                                                               \
+    }                                                                                                \
+    if (payload != NULL && payload_size == 0) {                                                      \
+        return COL_ERR_ILLEGAL_ARGUMENT;                                                             \
+    }                                                                                                \
+    col_error_t err = COL_OK;                                                                        \
+    struct ice_radix_job_##suffix job = {                                                            \
+        .keys = {keys, NULL},                                                                        \
+        .idx = {NULL, NULL},                                                                         \
+        .n = n,                                                                                      \
+        .nthreads = ice_sort_num_threads(n),                                                         \
+        .offsets = NULL,                                                                             \
+        .gate_open = 0,                                                                              \
+        .skip = 0,                                                                                   \
+        .src = 0                                                                                     \
+    };                                                                                               \
+    ltrace("[ice_radix_sort] - n=%ld, threads=%d", n, job.nthreads);                                 \
+    job.keys[1] = ice_aligned_malloc(CACHE_LINE_SIZE, n * sizeof(keyType));                          \
+    job.offsets = ice_aligned_malloc(CACHE_LINE_SIZE, job.nthreads * sizeof(*job.offsets));          \
+    if (job.keys[1] == NULL || job.offsets == NULL) {                                                \
+        err = COL_ERR_BAD_ALLOC;                                                                     \
+        goto cleanup;                                                                                \
+    }                                                                                                \
+    if (payload != NULL) {                                                                           \
+        job.idx[0] = ice_aligned_malloc(CACHE_LINE_SIZE, n * sizeof(size_t));                        \
+        job.idx[1] = ice_aligned_malloc(CACHE_LINE_SIZE, n * sizeof(size_t));                        \
+        if (job.idx[0] == NULL || job.idx[1] == NULL) {                                              \
+            err = COL_ERR_BAD_ALLOC;                                                                 \
+            goto cleanup;                                                                            \
+        }                                                                                            \
+        for (size_t i = 0; i < n; ++i) {                                                             \
+            job.idx[0][i] = i;                                                                       \
+        }                                                                                            \
+    }                                                                                                \
+                                                                                                     \
+    struct ice_radix_worker_##suffix workers[ICE_SORT_MAX_THREADS];                                  \
+    pthread_t threads[ICE_SORT_MAX_THREADS];                                                         \
+    unsigned started = 1;                                                                            \
+    pthread_mutex_init(&job.gate_lock, NULL);                                                        \
+    pthread_cond_init(&job.gate_cond, NULL);                                                         \
+    for (; started < job.nthreads; ++started) {                                                      \
+        workers[started].job = &job;                                                                 \
+        workers[started].t = started;                                                                \
+        if (pthread_create(&threads[started], NULL, ice_radix_run_##suffix, &workers[started]) != 0) {\
+            lerror("[ice_radix_sort] - could only start %d of %d threads", started, job.nthreads);   \
+            break;                                                                                   \
+        }                                                                                            \
+    }                                                                                                \
+    /* Chunks are assigned to the threads which are actually running */                              \
+    job.nthreads = started;                                                                          \
+    if (job.nthreads > 1 && pthread_barrier_init(&job.barrier, NULL, job.nthreads) != 0) {           \
+        job.nthreads = 1;                                                                            \
+    }                                                                                                \
+    pthread_mutex_lock(&job.gate_lock);                                                              \
+    job.gate_open = 1;                                                                               \
+    pthread_cond_broadcast(&job.gate_cond);                                                          \
+    pthread_mutex_unlock(&job.gate_lock);                                                            \
+                                                                                                     \
+    workers[0].job = &job;                                                                           \
+    workers[0].t = 0;                                                                                \
+    ice_radix_run_##suffix(&workers[0]);                                                             \
+    for (unsigned t = 1; t < started; ++t) {                                                         \
+        pthread_join(threads[t], NULL);                                                              \
+    }                                                                                                \
+    if (job.nthreads > 1) {                                                                          \
+        pthread_barrier_destroy(&job.barrier);                                                       \
+    }                                                                                                \
+    pthread_cond_destroy(&job.gate_cond);                                                            \
+    pthread_mutex_destroy(&job.gate_lock);                                                           \
+                                                                                                     \
+    if (job.src == 1) {                                                                              \
+        memcpy(keys, job.keys[1], n * sizeof(keyType));                                              \
+    }                                                                                                \
+    if (payload != NULL) {                                                                           \
+        err = ice_sort_permute_payload(job.idx[job.src], n, payload, payload_size);                  \
+    }                                                                                                \
+                                                                                                     \
+cleanup:                                                                                             \
+    ice_aligned_free(job.keys[1]);                                                                   \
+    ice_aligned_free(job.offsets);                                                                   \
+    ice_aligned_free(job.idx[0]);                                                                    \
+    ice_aligned_free(job.idx[1]);                                                                    \
+    return err;                                                                                      \
+}
+
+makeRadixSortImpl(u32, uint32_t, 4)
+makeRadixSortImpl(u64, uint64_t, 8)
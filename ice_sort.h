@@ -0,0 +1,64 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+#ifndef IEW_C_ESSENTIALS_ICE_SORT_H
+#define IEW_C_ESSENTIALS_ICE_SORT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "col_error.h"
+
+/**
+ * LSD radix sort kernels used by the vec_<name>_sort functions of the
+ * numeric vectors. Keys are sorted ascending as unsigned integers, 8 bit
+ * per pass. Passes where all keys share the same digit are skipped.
+ *
+ * If payload is not NULL it must point to n elements of payload_size
+ * bytes each. The payload is permuted the same way as the keys, which
+ * allows sorting a parallel vector by key. The sort is stable.
+ *
+ * Arrays with at least ICE_SORT_PARALLEL_THRESHOLD keys are sorted by
+ * up to ICE_SORT_MAX_THREADS threads.
+ */
+
+#define ICE_SORT_PARALLEL_THRESHOLD (1 << 20)
+#define ICE_SORT_MAX_THREADS 16
+
+col_error_t ice_radix_sort_u32(uint32_t * keys, size_t n, void * payload, size_t payload_size);
+
+col_error_t ice_radix_sort_u64(uint64_t * keys, size_t n, void * payload, size_t payload_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //IEW_C_ESSENTIALS_ICE_SORT_H
@@ -0,0 +1,327 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "ice_thread_pool.h"
+#include "icelogging.h"
+
+// Chunk range of one thread. Owner and thieves claim chunks with the same
+// atomic counter, so every chunk is processed exactly once.
+struct ice_thread_pool_slot {
+    size_t next;
+    size_t end;
+    char pad[CACHE_LINE_SIZE - 2 * sizeof(size_t)];
+};
+
+struct ice_thread_pool_job {
+    size_t n;
+    size_t grain;
+    PFN_ice_parallel_chunk fn;
+    void * pUserData;
+    int failed;
+    int err;
+};
+
+struct ice_thread_pool_worker {
+    ice_thread_pool pool;
+    unsigned index;
+};
+
+struct ice_thread_pool_T {
+    struct ice_thread_pool_slot * slots;
+    struct ice_thread_pool_worker * workers;
+    pthread_t * threads;
+    unsigned nthreads;
+    pthread_mutex_t submit_lock;
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond;
+    pthread_cond_t done_cond;
+    struct ice_thread_pool_job * job;
+    unsigned long generation;
+    unsigned busy;
+    int shutdown;
+};
+
+// The pool whose chunk the current thread is running
+static __thread ice_thread_pool ice_current_pool = NULL;
+
+static pthread_once_t ice_default_pool_once = PTHREAD_ONCE_INIT;
+static ice_thread_pool ice_default_pool = NULL;
+
+static void ice_thread_pool_work(ice_thread_pool pool, struct ice_thread_pool_job * job, unsigned self) {
+    ice_thread_pool prev = ice_current_pool;
+    ice_current_pool = pool;
+    for (unsigned k = 0; k < pool->nthreads; ++k) {
+        struct ice_thread_pool_slot * slot = &pool->slots[(self + k) % pool->nthreads];
+        while (!__atomic_load_n(&job->failed, __ATOMIC_RELAXED)) {
+            const size_t c = __atomic_fetch_add(&slot->next, 1, __ATOMIC_RELAXED);
+            if (c >= slot->end) {
+                break;
+            }
+            const size_t first = c * job->grain;
+            const size_t last = job->n - first > job->grain ? first + job->grain : job->n;
+            col_error_t err = job->fn(first, last, c, job->pUserData);
+            if (err != COL_OK) {
+                int expected = COL_OK;
+                __atomic_compare_exchange_n(&job->err, &expected, (int) err, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+                __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+            }
+        }
+    }
+    ice_current_pool = prev;
+}
+
+static void * ice_thread_pool_run(void * pArg) {
+    struct ice_thread_pool_worker * worker = pArg;
+    ice_thread_pool pool = worker->pool;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->shutdown && pool->generation == seen) {
+            pthread_cond_wait(&pool->work_cond, &pool->lock);
+        }
+        if (pool->shutdown) {
+            break;
+        }
+        seen = pool->generation;
+        struct ice_thread_pool_job * job = pool->job;
+        pthread_mutex_unlock(&pool->lock);
+
+        ice_thread_pool_work(pool, job, worker->index);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0) {
+            pthread_cond_signal(&pool->done_cond);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+ice_thread_pool ice_thread_pool_new(unsigned nthreads) {
+    if (nthreads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = cpus > 0 ? (unsigned) cpus : 1;
+    }
+    if (nthreads > ICE_THREAD_POOL_MAX_THREADS) {
+        nthreads = ICE_THREAD_POOL_MAX_THREADS;
+    }
+    ice_thread_pool pool = ice_malloc_cache_aligned(sizeof(struct ice_thread_pool_T));
+    if (pool == NULL) {
+        return NULL;
+    }
+    pool->slots = ice_malloc_cache_aligned(nthreads * sizeof(struct ice_thread_pool_slot));
+    pool->workers = ice_malloc_ptr_aligned(nthreads * sizeof(struct ice_thread_pool_worker));
+    pool->threads = ice_malloc_ptr_aligned(nthreads * sizeof(pthread_t));
+    if (pool->slots == NULL || pool->workers == NULL || pool->threads == NULL) {
+        ice_aligned_free(pool->slots);
+        ice_aligned_free(pool->workers);
+        ice_aligned_free(pool->threads);
+        ice_aligned_free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->submit_lock, NULL);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+    pool->job = NULL;
+    pool->generation = 0;
+    pool->busy = 0;
+    pool->shutdown = 0;
+
+    // Thread 0 is the thread calling parallel_for
+    unsigned started = 1;
+    for (; started < nthreads; ++started) {
+        pool->workers[started].pool = pool;
+        pool->workers[started].index = started;
+        if (pthread_create(&pool->threads[started], NULL, ice_thread_pool_run, &pool->workers[started]) != 0) {
+            lerror("[ice_thread_pool_new] - could only start %d of %d threads", started, nthreads);
+            break;
+        }
+    }
+    pool->nthreads = started;
+    ltrace("[ice_thread_pool_new] - threads=%d", pool->nthreads);
+    return pool;
+}
+
+void ice_thread_pool_free(ice_thread_pool pool) {
+    if (pool == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->lock);
+    for (unsigned t = 1; t < pool->nthreads; ++t) {
+        pthread_join(pool->threads[t], NULL);
+    }
+    pthread_cond_destroy(&pool->done_cond);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_mutex_destroy(&pool->submit_lock);
+    ice_aligned_free(pool->slots);
+    ice_aligned_free(pool->workers);
+    ice_aligned_free(pool->threads);
+    ice_aligned_free(pool);
+}
+
+unsigned ice_thread_pool_size(ice_thread_pool pool) {
+    return pool->nthreads;
+}
+
+static void ice_thread_pool_default_init() {
+    ice_default_pool = ice_thread_pool_new(0);
+}
+
+ice_thread_pool ice_thread_pool_default() {
+    pthread_once(&ice_default_pool_once, ice_thread_pool_default_init);
+    return ice_default_pool;
+}
+
+col_error_t ice_thread_pool_parallel_for(ice_thread_pool pool,
+                                         size_t n,
+                                         size_t grain,
+                                         PFN_ice_parallel_chunk fn,
+                                         void * pUserData) {
+    if (n == 0) {
+        return COL_OK;
+    }
+    if (grain == 0) {
+        grain = ICE_PARALLEL_DEFAULT_GRAIN;
+    }
+    const size_t nchunks = n / grain + (n % grain != 0);
+    if (pool == NULL) {
+        pool = ice_thread_pool_default();
+    }
+
+    if (pool == NULL || pool->nthreads == 1 || nchunks == 1 || pool == ice_current_pool) {
+        col_error_t err = COL_OK;
+        for (size_t c = 0; c < nchunks; ++c) {
+            const size_t first = c * grain;
+            const size_t last = n - first > grain ? first + grain : n;
+            if ((err = fn(first, last, c, pUserData)) != COL_OK) {
+                return err;
+            }
+        }
+        return COL_OK;
+    }
+
+    struct ice_thread_pool_job job = {
+        .n = n,
+        .grain = grain,
+        .fn = fn,
+        .pUserData = pUserData,
+        .failed = 0,
+        .err = COL_OK
+    };
+
+    pthread_mutex_lock(&pool->submit_lock);
+    for (unsigned t = 0; t < pool->nthreads; ++t) {
+        pool->slots[t].next = nchunks * t / pool->nthreads;
+        pool->slots[t].end = nchunks * (t + 1) / pool->nthreads;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->job = &job;
+    pool->busy = pool->nthreads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    ice_thread_pool_work(pool, &job, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy > 0) {
+        pthread_cond_wait(&pool->done_cond, &pool->lock);
+    }
+    pool->job = NULL;
+    pthread_mutex_unlock(&pool->lock);
+    pthread_mutex_unlock(&pool->submit_lock);
+
+    return (col_error_t) job.err;
+}
+
+struct ice_thread_pool_reduce_job {
+    char * partials;
+    size_t stride;
+    const void * identity;
+    size_t result_size;
+    PFN_ice_parallel_reduce reduce;
+    void * pUserData;
+};
+
+static col_error_t ice_thread_pool_reduce_chunk(size_t first, size_t last, size_t chunk, void * pArg) {
+    struct ice_thread_pool_reduce_job * job = pArg;
+    void * partial = job->partials + chunk * job->stride;
+    memcpy(partial, job->identity, job->result_size);
+    return job->reduce(first, last, partial, job->pUserData);
+}
+
+col_error_t ice_thread_pool_parallel_reduce(ice_thread_pool pool,
+                                            size_t n,
+                                            size_t grain,
+                                            void * pResult,
+                                            size_t result_size,
+                                            PFN_ice_parallel_reduce reduce,
+                                            PFN_ice_parallel_combine combine,
+                                            void * pUserData) {
+    if (n == 0) {
+        return COL_OK;
+    }
+    if (grain == 0) {
+        grain = ICE_PARALLEL_DEFAULT_GRAIN;
+    }
+    const size_t nchunks = n / grain + (n % grain != 0);
+    // Partials on separate cache lines
+    const size_t stride = ice_align_up(result_size, CACHE_LINE_SIZE);
+    if (stride == 0 || nchunks > SIZE_MAX / stride) {
+        return COL_ERR_ILLEGAL_ARGUMENT;
+    }
+    struct ice_thread_pool_reduce_job job = {
+        .partials = ice_malloc_cache_aligned(nchunks * stride),
+        .stride = stride,
+        .identity = pResult,
+        .result_size = result_size,
+        .reduce = reduce,
+        .pUserData = pUserData
+    };
+    if (job.partials == NULL) {
+        return COL_ERR_BAD_ALLOC;
+    }
+    col_error_t err = ice_thread_pool_parallel_for(pool, n, grain, ice_thread_pool_reduce_chunk, &job);
+    if (err == COL_OK) {
+        for (size_t c = 0; c < nchunks; ++c) {
+            combine(pResult, job.partials + c * stride, pUserData);
+        }
+    }
+    ice_aligned_free(job.partials);
+    return err;
+}
@@ -0,0 +1,137 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+#ifndef IEW_C_ESSENTIALS_ICE_THREAD_POOL_H
+#define IEW_C_ESSENTIALS_ICE_THREAD_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#include "col_error.h"
+#include "icemalloc.h"
+
+/**
+ * A small work stealing thread pool for data parallel loops.
+ *
+ * ice_thread_pool_parallel_for splits the index range [0, n) into chunks
+ * of grain indices. Chunk c covers [c * grain, min((c + 1) * grain, n)).
+ * Every thread of the pool, including the calling thread, starts with a
+ * contiguous range of chunks and steals chunks from the other threads
+ * when its own range is exhausted. The call returns when all chunks are
+ * processed.
+ *
+ * The chunk boundaries only depend on n and grain, never on the number
+ * of threads, so per chunk results can be combined in a deterministic
+ * order.
+ *
+ * If a chunk returns an error no further chunks are started and one of
+ * the errors is returned. A parallel_for called from within a chunk of
+ * the same pool runs sequentially on the calling thread.
+ *
+ * A pool runs one parallel_for at a time, concurrent calls are
+ * serialized.
+ */
+
+#define ICE_THREAD_POOL_MAX_THREADS 64
+#define ICE_PARALLEL_DEFAULT_GRAIN 4096
+
+typedef struct ice_thread_pool_T * ice_thread_pool;
+
+typedef col_error_t (*PFN_ice_parallel_chunk)(size_t first, size_t last, size_t chunk, void * pUserData);
+typedef col_error_t (*PFN_ice_parallel_reduce)(size_t first, size_t last, void * pPartial, void * pUserData);
+typedef void (*PFN_ice_parallel_combine)(void * pResult, const void * pPartial, void * pUserData);
+
+/**
+ * Creates a pool with nthreads threads, the calling thread counts as one.
+ * If nthreads is 0 the number of online CPUs is used.
+ */
+ice_thread_pool ice_thread_pool_new(unsigned nthreads);
+
+void ice_thread_pool_free(ice_thread_pool pool);
+
+unsigned ice_thread_pool_size(ice_thread_pool pool);
+
+/**
+ * Returns the shared pool which is used if NULL is passed as pool. It is
+ * created on first use with one thread per online CPU and lives until
+ * the process exits. Returns NULL if the pool cannot be created.
+ */
+ice_thread_pool ice_thread_pool_default();
+
+col_error_t ice_thread_pool_parallel_for(ice_thread_pool pool,
+                                         size_t n,
+                                         size_t grain,
+                                         PFN_ice_parallel_chunk fn,
+                                         void * pUserData);
+
+/**
+ * Parallel reduction of [0, n). pResult points to result_size bytes which
+ * hold the identity of the reduction on entry and the result on return.
+ *
+ * Every chunk gets its own partial result, initialized with a copy of the
+ * identity, and reduce folds the chunk's range into it. The partials are
+ * then folded into pResult by combine in chunk order. As the chunks don't
+ * depend on the number of threads the result is deterministic, also for
+ * floating point reductions.
+ */
+col_error_t ice_thread_pool_parallel_reduce(ice_thread_pool pool,
+                                            size_t n,
+                                            size_t grain,
+                                            void * pResult,
+                                            size_t result_size,
+                                            PFN_ice_parallel_reduce reduce,
+                                            PFN_ice_parallel_combine combine,
+                                            void * pUserData);
+
+/**
+ * Rounds grain up so that a chunk of elements of elem_size bytes spans
+ * whole cache lines. Threads working on neighbouring chunks then don't
+ * share cache lines if the data starts on a cache line. A grain of 0
+ * selects ICE_PARALLEL_DEFAULT_GRAIN.
+ */
+static inline size_t ice_parallel_grain(size_t grain, size_t elem_size) {
+    if (grain == 0) {
+        grain = ICE_PARALLEL_DEFAULT_GRAIN;
+    }
+    size_t a = elem_size, b = CACHE_LINE_SIZE;
+    while (b != 0) {
+        const size_t t = a % b;
+        a = b;
+        b = t;
+    }
+    const size_t per_line = CACHE_LINE_SIZE / a;
+    return (grain + per_line - 1) / per_line * per_line;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //IEW_C_ESSENTIALS_ICE_THREAD_POOL_H
@@ -0,0 +1,294 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "iceintern.h"
+#include "icemalloc.h"
+#include "icehash.h"
+#include "icelogging.h"
+#include "col_error.h"
+
+// Bytes of a regular arena chunk, larger strings get their own chunk
+#define ICE_INTERN_CHUNK_SIZE (64 * 1024)
+// Ids of the first id directory chunk, every further chunk doubles
+#define ICE_INTERN_ID_BASE 64
+#define ICE_INTERN_ID_CHUNKS 27
+
+struct ice_intern_entry {
+    uint64_t hash;
+    uint32_t id;
+    uint32_t nbytes;
+    char str[];
+};
+
+struct ice_intern_chunk {
+    struct ice_intern_chunk * next;
+    size_t size;
+    size_t used;
+    char data[];
+};
+
+struct ice_intern_slot {
+    uint64_t hash;
+    struct ice_intern_entry * entry;
+};
+
+// A table is never modified after it has been replaced by a larger one
+// and kept until the pool is freed, so lookups can still probe it.
+struct ice_intern_table {
+    struct ice_intern_table * retired;
+    size_t mask;
+    struct ice_intern_slot slots[];
+};
+
+struct ice_intern_T {
+    pthread_mutex_t lock;
+    struct ice_intern_table * table;
+    struct ice_intern_chunk * chunks;
+    uint32_t count;
+    struct ice_intern_entry ** ids[ICE_INTERN_ID_CHUNKS];
+};
+
+static struct ice_intern_table * ice_intern_table_new(size_t cap) {
+    struct ice_intern_table * t = ice_zmalloc_ptr_aligned(sizeof(struct ice_intern_table)
+                                                          + cap * sizeof(struct ice_intern_slot));
+    if (t != NULL) {
+        t->mask = cap - 1;
+    }
+    return t;
+}
+
+static void ice_intern_table_put(struct ice_intern_table * t, struct ice_intern_entry * e) {
+    size_t i = e->hash & t->mask;
+    while (t->slots[i].entry != NULL) {
+        i = (i + 1) & t->mask;
+    }
+    t->slots[i].hash = e->hash;
+    __atomic_store_n(&t->slots[i].entry, e, __ATOMIC_RELEASE);
+}
+
+static struct ice_intern_entry * ice_intern_lookup(ice_intern pool, const char * s, size_t nb, uint64_t hash) {
+    const struct ice_intern_table * t = __atomic_load_n(&pool->table, __ATOMIC_ACQUIRE);
+    for (size_t i = hash & t->mask;; i = (i + 1) & t->mask) {
+        struct ice_intern_entry * e = __atomic_load_n(&t->slots[i].entry, __ATOMIC_ACQUIRE);
+        if (e == NULL) {
+            return NULL;
+        }
+        if (t->slots[i].hash == hash && e->nbytes == nb && memcmp(e->str, s, nb) == 0) {
+            return e;
+        }
+    }
+}
+
+// Id i is in chunk c with ICE_INTERN_ID_BASE * (2^c - 1) <= i < ICE_INTERN_ID_BASE * (2^(c+1) - 1)
+static inline size_t ice_intern_id_chunk(uint32_t id, size_t * pIndex) {
+    const uint64_t q = (uint64_t) id / ICE_INTERN_ID_BASE + 1;
+    const size_t c = 63 - (size_t) __builtin_clzll(q);
+    *pIndex = id - ICE_INTERN_ID_BASE * (((uint64_t) 1 << c) - 1);
+    return c;
+}
+
+static void * ice_intern_arena_alloc(ice_intern pool, size_t size) {
+    size = (size + PTR_ALIGN - 1) & ~(PTR_ALIGN - 1);
+    struct ice_intern_chunk * chunk = pool->chunks;
+    if (chunk == NULL || chunk->size - chunk->used < size) {
+        const size_t chunk_size = size > ICE_INTERN_CHUNK_SIZE / 4 ? size : ICE_INTERN_CHUNK_SIZE;
+        if ((chunk = ice_malloc_ptr_aligned(sizeof(struct ice_intern_chunk) + chunk_size)) == NULL) {
+            return NULL;
+        }
+        chunk->size = chunk_size;
+        chunk->used = 0;
+        if (pool->chunks != NULL && chunk_size != ICE_INTERN_CHUNK_SIZE) {
+            // Keep filling the current chunk after a large string
+            chunk->next = pool->chunks->next;
+            pool->chunks->next = chunk;
+        } else {
+            chunk->next = pool->chunks;
+            pool->chunks = chunk;
+        }
+    }
+    void * p = chunk->data + chunk->used;
+    chunk->used += size;
+    return p;
+}
+
+static col_error_t ice_intern_grow(ice_intern pool) {
+    struct ice_intern_table * old = pool->table;
+    struct ice_intern_table * t = ice_intern_table_new(2 * (old->mask + 1));
+    if (t == NULL) {
+        return COL_ERR_BAD_ALLOC;
+    }
+    for (size_t i = 0; i <= old->mask; ++i) {
+        if (old->slots[i].entry != NULL) {
+            ice_intern_table_put(t, old->slots[i].entry);
+        }
+    }
+    t->retired = old;
+    __atomic_store_n(&pool->table, t, __ATOMIC_RELEASE);
+    ltrace("[ice_intern_grow] - cap=%zu", t->mask + 1);
+    return COL_OK;
+}
+
+ice_intern ice_intern_new(size_t cap) {
+    ice_intern pool = ice_zmalloc_ptr_aligned(sizeof(struct ice_intern_T));
+    if (pool == NULL) {
+        return NULL;
+    }
+    // Tables are kept at most 70% full
+    size_t table_cap = 16;
+    while (table_cap * 7 < cap * 10) {
+        table_cap *= 2;
+    }
+    if ((pool->table = ice_intern_table_new(table_cap)) == NULL) {
+        ice_aligned_free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    return pool;
+}
+
+void ice_intern_free(ice_intern pool) {
+    if (pool == NULL) {
+        return;
+    }
+    for (struct ice_intern_table * t = pool->table; t != NULL;) {
+        struct ice_intern_table * retired = t->retired;
+        ice_aligned_free(t);
+        t = retired;
+    }
+    for (struct ice_intern_chunk * c = pool->chunks; c != NULL;) {
+        struct ice_intern_chunk * next = c->next;
+        ice_aligned_free(c);
+        c = next;
+    }
+    for (size_t c = 0; c < ICE_INTERN_ID_CHUNKS; ++c) {
+        ice_aligned_free(pool->ids[c]);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    ice_aligned_free(pool);
+}
+
+const char * ice_intern_n(ice_intern pool, const char * s, size_t nb, uint32_t * pId) {
+    if ((s == NULL && nb > 0) || nb > UINT32_MAX) {
+        return NULL;
+    }
+    if (s == NULL) {
+        s = "";
+    }
+    const uint64_t hash = fnv_64a_buf((void *) s, nb, FNV1A_64_INIT);
+    struct ice_intern_entry * e = ice_intern_lookup(pool, s, nb, hash);
+    if (e == NULL) {
+        pthread_mutex_lock(&pool->lock);
+        // Another thread may have inserted s in the meantime
+        e = ice_intern_lookup(pool, s, nb, hash);
+        if (e == NULL) {
+            const uint32_t id = pool->count;
+            size_t index;
+            const size_t c = ice_intern_id_chunk(id, &index);
+            if (id == ICE_INTERN_NONE
+                || ((pool->table->mask + 1) * 7 <= ((size_t) id + 1) * 10 && ice_intern_grow(pool) != COL_OK)) {
+                pthread_mutex_unlock(&pool->lock);
+                return NULL;
+            }
+            if (pool->ids[c] == NULL) {
+                struct ice_intern_entry ** ids = ice_malloc_ptr_aligned(
+                        ((size_t) ICE_INTERN_ID_BASE << c) * sizeof(struct ice_intern_entry *));
+                if (ids == NULL) {
+                    pthread_mutex_unlock(&pool->lock);
+                    return NULL;
+                }
+                __atomic_store_n(&pool->ids[c], ids, __ATOMIC_RELEASE);
+            }
+            if ((e = ice_intern_arena_alloc(pool, sizeof(struct ice_intern_entry) + nb + 1)) == NULL) {
+                pthread_mutex_unlock(&pool->lock);
+                return NULL;
+            }
+            e->hash = hash;
+            e->id = id;
+            e->nbytes = (uint32_t) nb;
+            memcpy(e->str, s, nb);
+            e->str[nb] = '\0';
+            pool->ids[c][index] = e;
+            ice_intern_table_put(pool->table, e);
+            __atomic_store_n(&pool->count, id + 1, __ATOMIC_RELEASE);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+    if (pId != NULL) {
+        *pId = e->id;
+    }
+    return e->str;
+}
+
+const char * ice_intern_str(ice_intern pool, const char * s) {
+    return s == NULL ? NULL : ice_intern_n(pool, s, strlen(s), NULL);
+}
+
+const char * ice_intern_find_n(ice_intern pool, const char * s, size_t nb, uint32_t * pId) {
+    if (s == NULL && nb == 0) {
+        s = "";
+    }
+    const struct ice_intern_entry * e = s == NULL || nb > UINT32_MAX
+                                        ? NULL
+                                        : ice_intern_lookup(pool, s, nb, fnv_64a_buf((void *) s, nb, FNV1A_64_INIT));
+    if (pId != NULL) {
+        *pId = e == NULL ? ICE_INTERN_NONE : e->id;
+    }
+    return e == NULL ? NULL : e->str;
+}
+
+const char * ice_intern_find(ice_intern pool, const char * s) {
+    return s == NULL ? NULL : ice_intern_find_n(pool, s, strlen(s), NULL);
+}
+
+const char * ice_intern_get(ice_intern pool, uint32_t id) {
+    if (id >= __atomic_load_n(&pool->count, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+    size_t index;
+    const size_t c = ice_intern_id_chunk(id, &index);
+    return __atomic_load_n(&pool->ids[c], __ATOMIC_ACQUIRE)[index]->str;
+}
+
+static inline const struct ice_intern_entry * ice_intern_entry_of(const char * interned) {
+    return (const struct ice_intern_entry *) (interned - offsetof(struct ice_intern_entry, str));
+}
+
+uint32_t ice_intern_id(const char * interned) {
+    return ice_intern_entry_of(interned)->id;
+}
+
+size_t ice_intern_size(const char * interned) {
+    return ice_intern_entry_of(interned)->nbytes;
+}
+
+size_t ice_intern_count(ice_intern pool) {
+    return __atomic_load_n(&pool->count, __ATOMIC_ACQUIRE);
+}
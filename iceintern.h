@@ -0,0 +1,111 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+#ifndef IEW_C_ESSENTIALS_ICEINTERN_H
+#define IEW_C_ESSENTIALS_ICEINTERN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * String interning pool. Every distinct string is stored once in a
+ * chunked arena and keeps its address and its 32-bit id until the pool
+ * is freed, so interned strings can be compared by pointer or by id.
+ *
+ * Strings are found through an open addressing table which caches the
+ * FNV-64a hash of every string. Inserts are serialized by a lock,
+ * lookups don't take the lock and can run concurrently to inserts, so
+ * several threads can share one pool.
+ *
+ * Interned strings are '\0' terminated and must not be modified.
+ */
+
+#define ICE_INTERN_NONE UINT32_MAX
+
+typedef struct ice_intern_T * ice_intern;
+
+/**
+ * @param cap Number of strings the pool holds without growing its table
+ * @return The pool or NULL if out of memory
+ */
+ice_intern ice_intern_new(size_t cap);
+
+void ice_intern_free(ice_intern pool);
+
+/**
+ * Intern the first nb bytes of s. s may contain '\0' bytes and may be NULL
+ * if nb is 0.
+ *
+ * @param pId Set to the id of the string, may be NULL
+ * @return The interned string or NULL if out of memory or s is NULL and nb > 0
+ */
+const char * ice_intern_n(ice_intern pool, const char * s, size_t nb, uint32_t * pId);
+
+/**
+ * Intern the '\0' terminated string s.
+ */
+const char * ice_intern_str(ice_intern pool, const char * s);
+
+/**
+ * Find an interned string without inserting it. s may be NULL if nb is 0.
+ *
+ * @param pId Set to the id of the string or ICE_INTERN_NONE, may be NULL
+ * @return The interned string or NULL if s isn't interned
+ */
+const char * ice_intern_find_n(ice_intern pool, const char * s, size_t nb, uint32_t * pId);
+
+const char * ice_intern_find(ice_intern pool, const char * s);
+
+/**
+ * The interned string with the given id or NULL if there is none.
+ */
+const char * ice_intern_get(ice_intern pool, uint32_t id);
+
+/**
+ * The id of a string returned by the pool.
+ */
+uint32_t ice_intern_id(const char * interned);
+
+/**
+ * The byte size of a string returned by the pool.
+ */
+size_t ice_intern_size(const char * interned);
+
+/**
+ * The number of interned strings.
+ */
+size_t ice_intern_count(ice_intern pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //IEW_C_ESSENTIALS_ICEINTERN_H
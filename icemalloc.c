@@ -26,6 +26,7 @@
  */
 
 #include <string.h>
+#include <stdint.h>
 
 #include "icemalloc.h"
 #include "icelogging.h"
@@ -81,19 +82,39 @@ void * ice_aligned_realloc(void * memblock, size_t align, size_t old_size, size_
         return memblock;
     }
 
-    // Allocate a new block
-    void * fake_new_ptr = ice_aligned_malloc(align, new_size);
-    if (fake_new_ptr == NULL) {
+    if (memblock == NULL) {
+        return ice_aligned_malloc(align, new_size);
+    }
+
+    const size_t hdr_size = PTR_OFFSET_SZ + (align - 1);
+    if (new_size > SIZE_MAX - hdr_size) {
+        return NULL;
+    }
+
+    // Grow the underlying block with realloc, large blocks are often
+    // extended in place or remapped without copying. The block must keep
+    // the old data at its old offset until it is moved, the offset can be
+    // larger than hdr_size, e.g. for lstr characters.
+    const offset_t old_offset = ice_offset_of(memblock);
+    size_t block_size = new_size + hdr_size;
+    if (block_size < old_offset + old_size) {
+        block_size = old_offset + old_size;
+    }
+    uint8_t * p = IEW_FN_REALLOC((uint8_t *) memblock - old_offset, block_size);
+    if (p == NULL) {
         return NULL;
     }
 
-    // Copy data to new block
-    if (memblock != NULL) {
-        memcpy(fake_new_ptr, memblock, old_size);
-        ice_aligned_free(memblock);
+    // The data keeps its offset to the block, move it if the block moved
+    // to an address with a different alignment
+    uint8_t * ptr = (uint8_t *) ice_align_up((uintptr_t) p + PTR_OFFSET_SZ, align);
+    if (ptr != p + old_offset) {
+        memmove(ptr, p + old_offset, old_size);
     }
+    *((offset_t *) ptr - 1) = (offset_t) (ptr - p);
+    ltrace("[ice_aligned_realloc] - pointer=%ld, offset=%ld", ptr, ptr - p);
 
-    return fake_new_ptr;
+    return ptr;
 }
 
 void * ice_aligned_malloc(size_t align, size_t size) {
@@ -124,23 +145,35 @@ void * ice_aligned_zmalloc(size_t align, size_t size) {
         const size_t hdr_size = PTR_OFFSET_SZ + (align - 1);
         ltrace("[ice_aligned_zmalloc] - hdr_size=%ld, alloc size=%ld", hdr_size, size+hdr_size);
 
-        const void * p = IEW_FN_MALLOC(size + hdr_size);
-        ltrace("[ice_aligned_zmalloc] - pointer malloc=%ld", p);
+        if (size > SIZE_MAX - hdr_size) {
+            return NULL;
+        }
 
-        if (p != NULL) {
-            // This is unsafe because compiler might optimize away
-            // this memset call. Haven't found how to use memset_s yet.
-            memset((void *) p, 0, size + hdr_size);
-            ptr = (void *) ice_align_up(((uintptr_t ) p + PTR_OFFSET_SZ), align);
-            ltrace("[ice_aligned_malloc] - pointer aligned=%ld", ptr);
+        const void * p = IEW_FN_CALLOC(1, size + hdr_size);
+        ltrace("[ice_aligned_zmalloc] - pointer calloc=%ld", p);
 
-            *((offset_t *) ptr - 1) = (offset_t)((uintptr_t ) ptr - (uintptr_t ) p);
-            ltrace("[ice_aligned_malloc] - offset=%ld", *((offset_t *) ptr - 1));
-        }
+        ptr = ice_align_memblock(p, align);
     }
     return ptr;
 }
 
+void ice_secure_zero(void * ptr, size_t size) {
+    if (ptr == NULL || size == 0) {
+        return;
+    }
+#if defined(__GNUC__)
+    memset(ptr, 0, size);
+    // The barrier pretends to read the zeroed memory so the
+    // memset can't be removed as a dead store.
+    __asm__ __volatile__("" : : "r"(ptr) : "memory");
+#else
+    volatile uint8_t * p = (volatile uint8_t *) ptr;
+    while (size--) {
+        *p++ = 0;
+    }
+#endif
+}
+
 void ice_aligned_free(void * ptr) {
     if (ptr == NULL) {
         return;
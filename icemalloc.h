@@ -63,8 +63,18 @@ void * ice_aligned_realloc(void * memblock, size_t align, size_t old_size, size_
 
 void *ice_aligned_malloc(size_t align, size_t size);
 
+/**
+ * Allocates zeroed memory with calloc. Large blocks usually come as fresh
+ * pages from the kernel which are zeroed already and aren't touched.
+ */
 void *ice_aligned_zmalloc(size_t align, size_t size);
 
+/**
+ * Zeroes size bytes at ptr. Unlike memset the call is never optimized
+ * away, even if ptr is freed right after, so use it to wipe secrets.
+ */
+void ice_secure_zero(void *ptr, size_t size);
+
 void ice_aligned_free(void *ptr);
 
 #define ice_malloc_cache_aligned(s) ice_aligned_malloc(CACHE_LINE_SIZE, s)
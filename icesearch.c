@@ -0,0 +1,293 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+#include <string.h>
+#include <stdbool.h>
+
+#include "icesearch.h"
+#include "icemalloc.h"
+#include "ice_cpu.h"
+
+// Without SIMD needles longer than this use Horspool
+#define ICE_SEARCH_SHORT_NEEDLE 32
+
+// Rough frequency rank of bytes in text, higher is more frequent. The
+// byte filter compares the two rarest bytes of the needle because they
+// give the least false candidates.
+static unsigned ice_search_byte_rank(unsigned char c) {
+    static const char frequent[] = "etaoinsrhldcumfpgwybvkxjqz";
+    if (c == ' ') {
+        return 255;
+    }
+    if (c >= 'a' && c <= 'z') {
+        return 250 - 4 * (unsigned) (strchr(frequent, c) - frequent);
+    }
+    if (c >= 'A' && c <= 'Z') {
+        return 120 - 2 * (unsigned) (strchr(frequent, c - 'A' + 'a') - frequent);
+    }
+    if (c >= '0' && c <= '9') {
+        return 130;
+    }
+    if (c == '\n' || c == '.' || c == ',' || c == '/' || c == '_' || c == '-' || c == '"' || c == '=') {
+        return 140;
+    }
+    if (c >= 0x80) {
+        // UTF-8 lead bytes are rarer than continuation bytes
+        return c >= 0xc0 ? 80 : 110;
+    }
+    return c < 0x20 ? 10 : 60;
+}
+
+static void ice_search_rare_bytes(const char * needle, size_t m, size_t * pRare1, size_t * pRare2) {
+    size_t r1 = 0;
+    size_t r2 = m - 1;
+    for (size_t i = 0; i < m; ++i) {
+        if (ice_search_byte_rank((unsigned char) needle[i]) < ice_search_byte_rank((unsigned char) needle[r1])) {
+            r1 = i;
+        }
+    }
+    if (r2 == r1) {
+        r2 = 0;
+    }
+    // Prefer a second byte with a different value
+    for (size_t i = 0; i < m; ++i) {
+        if (i == r1) {
+            continue;
+        }
+        const bool same = needle[i] == needle[r1];
+        const bool best_same = needle[r2] == needle[r1];
+        if ((best_same && !same)
+            || (same == best_same && ice_search_byte_rank((unsigned char) needle[i]) < ice_search_byte_rank((unsigned char) needle[r2]))) {
+            r2 = i;
+        }
+    }
+    *pRare1 = r1;
+    *pRare2 = r2;
+}
+
+// --- Scalar kernels
+
+static size_t ice_search_filter_scalar(const char * s, size_t nb, const char * needle, size_t m,
+                                       size_t r1, size_t r2) {
+    // The SIMD kernels pass their tail which may be shorter than the needle
+    if (nb < m) {
+        return ICE_SEARCH_NPOS;
+    }
+    // Candidates are found by the byte at r1, positions are shifted by r1
+    const char * p = s + r1;
+    const char * end = s + r1 + (nb - m) + 1;
+    while (p < end && (p = memchr(p, needle[r1], (size_t) (end - p))) != NULL) {
+        const char * candidate = p - r1;
+        if (candidate[r2] == needle[r2] && memcmp(candidate, needle, m) == 0) {
+            return (size_t) (candidate - s);
+        }
+        p++;
+    }
+    return ICE_SEARCH_NPOS;
+}
+
+static void ice_search_shifts(const char * needle, size_t m, uint32_t shift[256]) {
+    const uint32_t max = m > UINT32_MAX ? UINT32_MAX : (uint32_t) m;
+    for (int c = 0; c < 256; ++c) {
+        shift[c] = max;
+    }
+    for (size_t i = 0; i + 1 < m; ++i) {
+        const size_t d = m - 1 - i;
+        shift[(unsigned char) needle[i]] = d > UINT32_MAX ? UINT32_MAX : (uint32_t) d;
+    }
+}
+
+static size_t ice_search_horspool(const char * s, size_t nb, const char * needle, size_t m,
+                                  const uint32_t shift[256]) {
+    const unsigned char last = (unsigned char) needle[m - 1];
+    size_t i = 0;
+    while (i <= nb - m) {
+        const unsigned char c = (unsigned char) s[i + m - 1];
+        if (c == last && memcmp(s + i, needle, m - 1) == 0) {
+            return i;
+        }
+        i += shift[c];
+    }
+    return ICE_SEARCH_NPOS;
+}
+
+#if defined(ICE_SIMD_X86)
+
+// --- AVX2 kernels
+
+ICE_TARGET_AVX2 static size_t ice_search_filter_avx2(const char * s, size_t nb, const char * needle, size_t m,
+                                                     size_t r1, size_t r2) {
+    const __m256i b1 = _mm256_set1_epi8(needle[r1]);
+    const __m256i b2 = _mm256_set1_epi8(needle[r2]);
+    size_t i = 0;
+    for (; i + m - 1 + 32 <= nb; i += 32) {
+        const __m256i block1 = _mm256_loadu_si256((const __m256i *) (s + i + r1));
+        const __m256i block2 = _mm256_loadu_si256((const __m256i *) (s + i + r2));
+        uint32_t mask = (uint32_t) _mm256_movemask_epi8(
+                _mm256_and_si256(_mm256_cmpeq_epi8(block1, b1), _mm256_cmpeq_epi8(block2, b2)));
+        while (mask != 0) {
+            const size_t pos = i + (size_t) __builtin_ctz(mask);
+            if (memcmp(s + pos, needle, m) == 0) {
+                return pos;
+            }
+            mask &= mask - 1;
+        }
+    }
+    const size_t pos = ice_search_filter_scalar(s + i, nb - i, needle, m, r1, r2);
+    return pos == ICE_SEARCH_NPOS ? pos : i + pos;
+}
+
+// --- SSE4 kernels
+
+ICE_TARGET_SSE4 static size_t ice_search_filter_sse4(const char * s, size_t nb, const char * needle, size_t m,
+                                                     size_t r1, size_t r2) {
+    const __m128i b1 = _mm_set1_epi8(needle[r1]);
+    const __m128i b2 = _mm_set1_epi8(needle[r2]);
+    size_t i = 0;
+    for (; i + m - 1 + 16 <= nb; i += 16) {
+        const __m128i block1 = _mm_loadu_si128((const __m128i *) (s + i + r1));
+        const __m128i block2 = _mm_loadu_si128((const __m128i *) (s + i + r2));
+        uint32_t mask = (uint32_t) _mm_movemask_epi8(
+                _mm_and_si128(_mm_cmpeq_epi8(block1, b1), _mm_cmpeq_epi8(block2, b2)));
+        while (mask != 0) {
+            const size_t pos = i + (size_t) __builtin_ctz(mask);
+            if (memcmp(s + pos, needle, m) == 0) {
+                return pos;
+            }
+            mask &= mask - 1;
+        }
+    }
+    const size_t pos = ice_search_filter_scalar(s + i, nb - i, needle, m, r1, r2);
+    return pos == ICE_SEARCH_NPOS ? pos : i + pos;
+}
+
+#elif defined(ICE_SIMD_NEON)
+
+// --- NEON kernels
+
+static size_t ice_search_filter_neon(const char * s, size_t nb, const char * needle, size_t m,
+                                     size_t r1, size_t r2) {
+    const uint8x16_t b1 = vdupq_n_u8((uint8_t) needle[r1]);
+    const uint8x16_t b2 = vdupq_n_u8((uint8_t) needle[r2]);
+    size_t i = 0;
+    for (; i + m - 1 + 16 <= nb; i += 16) {
+        const uint8x16_t block1 = vld1q_u8((const uint8_t *) (s + i + r1));
+        const uint8x16_t block2 = vld1q_u8((const uint8_t *) (s + i + r2));
+        const uint8x16_t eq = vandq_u8(vceqq_u8(block1, b1), vceqq_u8(block2, b2));
+        if (vmaxvq_u8(eq) == 0) {
+            continue;
+        }
+        uint8_t lanes[16];
+        vst1q_u8(lanes, eq);
+        for (size_t l = 0; l < 16; ++l) {
+            if (lanes[l] != 0 && memcmp(s + i + l, needle, m) == 0) {
+                return i + l;
+            }
+        }
+    }
+    const size_t pos = ice_search_filter_scalar(s + i, nb - i, needle, m, r1, r2);
+    return pos == ICE_SEARCH_NPOS ? pos : i + pos;
+}
+
+#endif
+
+// --- Dispatch
+
+// Searches needles with at least 2 bytes which fit into s
+static size_t ice_search_kernel(const char * s, size_t nb, const char * needle, size_t m,
+                                size_t r1, size_t r2, const uint32_t * shift) {
+#if defined(ICE_SIMD_X86)
+    if (ice_cpu_has_avx2()) {
+        return ice_search_filter_avx2(s, nb, needle, m, r1, r2);
+    } else if (ice_cpu_has_sse4()) {
+        return ice_search_filter_sse4(s, nb, needle, m, r1, r2);
+    }
+#elif defined(ICE_SIMD_NEON)
+    return ice_search_filter_neon(s, nb, needle, m, r1, r2);
+#endif
+    if (m > ICE_SEARCH_SHORT_NEEDLE) {
+        uint32_t local_shift[256];
+        if (shift == NULL) {
+            ice_search_shifts(needle, m, local_shift);
+            shift = local_shift;
+        }
+        return ice_search_horspool(s, nb, needle, m, shift);
+    }
+    return ice_search_filter_scalar(s, nb, needle, m, r1, r2);
+}
+
+size_t ice_search(const char * s, size_t nb, const char * needle, size_t needle_nb) {
+    if (needle_nb == 0) {
+        return 0;
+    }
+    if (needle_nb > nb) {
+        return ICE_SEARCH_NPOS;
+    }
+    if (needle_nb == 1) {
+        const char * p = memchr(s, needle[0], nb);
+        return p == NULL ? ICE_SEARCH_NPOS : (size_t) (p - s);
+    }
+    size_t r1, r2;
+    ice_search_rare_bytes(needle, needle_nb, &r1, &r2);
+    return ice_search_kernel(s, nb, needle, needle_nb, r1, r2, NULL);
+}
+
+ice_needle ice_needle_new(const char * needle, size_t nb) {
+    ice_needle n = ice_malloc_ptr_aligned(sizeof(struct ice_needle_t));
+    if (n == NULL) {
+        return NULL;
+    }
+    // At least one byte, ice_aligned_malloc returns NULL for size 0
+    if ((n->bytes = ice_malloc_ptr_aligned(nb + 1)) == NULL) {
+        ice_aligned_free(n);
+        return NULL;
+    }
+    memcpy(n->bytes, needle, nb);
+    n->bytes[nb] = '\0';
+    n->nbytes = nb;
+    n->rare1 = 0;
+    n->rare2 = 0;
+    if (nb > 1) {
+        ice_search_rare_bytes(needle, nb, &n->rare1, &n->rare2);
+        ice_search_shifts(needle, nb, n->shift);
+    }
+    return n;
+}
+
+void ice_needle_free(ice_needle needle) {
+    if (needle != NULL) {
+        ice_aligned_free(needle->bytes);
+        ice_aligned_free(needle);
+    }
+}
+
+size_t ice_needle_find(ice_needle needle, const char * s, size_t nb) {
+    if (needle->nbytes <= 1 || needle->nbytes > nb) {
+        return ice_search(s, nb, needle->bytes, needle->nbytes);
+    }
+    return ice_search_kernel(s, nb, needle->bytes, needle->nbytes, needle->rare1, needle->rare2, needle->shift);
+}
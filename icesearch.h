@@ -0,0 +1,74 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+#ifndef IEW_C_ESSENTIALS_ICESEARCH_H
+#define IEW_C_ESSENTIALS_ICESEARCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Byte substring search. Candidates are found by comparing two rare bytes
+ * of the needle at 16 or 32 positions at once (AVX2, SSE4 or NEON) and
+ * verified with memcmp. Without SIMD long needles use the precomputed
+ * shifts of the Boyer-Moore-Horspool algorithm.
+ *
+ * Both return the byte offset of the first occurrence or ICE_SEARCH_NPOS.
+ * The empty needle is found at 0.
+ */
+#define ICE_SEARCH_NPOS SIZE_MAX
+
+size_t ice_search(const char * s, size_t nb, const char * needle, size_t needle_nb);
+
+/**
+ * A compiled needle. Keeps a copy of the needle, the positions of its
+ * rare bytes and its shift table, so searching for the same needle in
+ * many strings doesn't set up the search again.
+ */
+typedef struct ice_needle_t {
+    size_t nbytes;
+    char * bytes;
+    size_t rare1;
+    size_t rare2;
+    uint32_t shift[256];
+} *ice_needle;
+
+ice_needle ice_needle_new(const char * needle, size_t nb);
+
+void ice_needle_free(ice_needle needle);
+
+size_t ice_needle_find(ice_needle needle, const char * s, size_t nb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //IEW_C_ESSENTIALS_ICESEARCH_H
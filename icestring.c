@@ -27,8 +27,12 @@
 
 #include "icestring.h"
 #include "icemalloc.h"
+#include "iceutf8.h"
 
 #include <string.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdbool.h>
 
 char * str_of(const char * s) {
     return str_nbof(s, SIZE_MAX);
@@ -74,7 +78,7 @@ void str_free(char * str) {
 }
 
 size_t str_len(const char * str) {
-    return utf8len(str);
+    return ice_utf8_count(str, strlen(str));
 }
 
 size_t str_size(const char * str) {
@@ -106,10 +110,11 @@ char * str_append(char * str, const char * s) {
     return buf;
 }
 
-// https://github.com/sheredom/utf8.h
-// We had to copy and adjust the code because
-// utf8.h 'utf8chr' function for example returns
-// pointers, but we want to work with codepoint indices.
+// Encodes rune into chars and returns the number of bytes written.
+static inline size_t str_rune_encode(int rune, char * chars) {
+    return 0 == rune ? 0 : ice_utf8_encode_rune(rune, chars);
+}
+
 void str_rune_to_chars(int rune, char chars[5]) {
     chars[0] = '\0';
     chars[1] = '\0';
@@ -117,31 +122,7 @@ void str_rune_to_chars(int rune, char chars[5]) {
     chars[3] = '\0';
     chars[4] = '\0';
 
-    if (0 == rune) {
-        return;
-    } else if (0 == ((utf8_int32_t)0xffffff80 & rune)) {
-        /* 1-byte/7-bit ascii
-         * (0b0xxxxxxx) */
-        chars[0] = (utf8_int8_t)rune;
-    } else if (0 == ((utf8_int32_t)0xfffff800 & rune)) {
-        /* 2-byte/11-bit utf8 code point
-         * (0b110xxxxx 0b10xxxxxx) */
-        chars[0] = (utf8_int8_t)(0xc0 | (utf8_int8_t)(rune >> 6));
-        chars[1] = (utf8_int8_t)(0x80 | (utf8_int8_t)(rune & 0x3f));
-    } else if (0 == ((utf8_int32_t)0xffff0000 & rune)) {
-        /* 3-byte/16-bit utf8 code point
-         * (0b1110xxxx 0b10xxxxxx 0b10xxxxxx) */
-        chars[0] = (utf8_int8_t)(0xe0 | (utf8_int8_t)(rune >> 12));
-        chars[1] = (utf8_int8_t)(0x80 | (utf8_int8_t)((rune >> 6) & 0x3f));
-        chars[2] = (utf8_int8_t)(0x80 | (utf8_int8_t)(rune & 0x3f));
-    } else { /* if (0 == ((int)0xffe00000 & chr)) { */
-        /* 4-byte/21-bit utf8 code point
-         * (0b11110xxx 0b10xxxxxx 0b10xxxxxx 0b10xxxxxx) */
-        chars[0] = (utf8_int8_t)(0xf0 | (utf8_int8_t)(rune >> 18));
-        chars[1] = (utf8_int8_t)(0x80 | (utf8_int8_t)((rune >> 12) & 0x3f));
-        chars[2] = (utf8_int8_t)(0x80 | (utf8_int8_t)((rune >> 6) & 0x3f));
-        chars[3] = (utf8_int8_t)(0x80 | (utf8_int8_t)(rune & 0x3f));
-    }
+    str_rune_encode(rune, chars);
 }
 
 int str_index_rune(const char * str, int chr) {
@@ -155,127 +136,684 @@ int str_index_rune(const char * str, int chr) {
     return str_index_string(str, c);
 }
 
-// Code adapted from: https://github.com/sheredom/utf8.h
-// We had to copy and adjust the code because
-// utf8.h 'utf8chr' function for example returns
-// pointers, but we want to work with codepoint indices.
 int str_index_string(const char * str, const char * lookup) {
     if (str == NULL || lookup == NULL) {
         return -1;
     }
-    utf8_int32_t throwaway_codepoint = 0;
+    // A match of a valid UTF-8 lookup string always starts at a codepoint
+    const ice_strview haystack = strview_of(str);
+    const size_t pos = strview_find(haystack, strview_of(lookup));
+    if (pos == STRVIEW_NPOS) {
+        return -1;
+    }
+    return (int) ice_utf8_count(str, pos);
+}
 
-    /*
-     * if needle has no utf8 codepoints before the null terminating
-     * byte then return 0.
-     * Empty string is always in a string.
-     */
-    if ('\0' == *lookup) {
-        return 0;
+int str_index_needle(const char * str, ice_needle needle) {
+    if (str == NULL) {
+        return -1;
+    }
+    const size_t pos = ice_needle_find(needle, str, strlen(str));
+    if (pos == ICE_SEARCH_NPOS) {
+        return -1;
     }
+    return (int) ice_utf8_count(str, pos);
+}
 
-    int codepoints_count = 0;
-    while ('\0' != *str) {
-        const utf8_int8_t *maybeMatch = str;
-        const utf8_int8_t *n = lookup;
+char * str_substring(const char * str, size_t start, size_t end) {
+    // Same index return the empty string
+    if (start == end) {
+        return str_of_empty();
+    }
 
-        // Match bytes of string and lookup string
-        while (*str == *n && (*str != '\0' && *n != '\0')) {
-            n++;
-            str++;
-        }
+    // Fix order of indices
+    if (start > end) {
+        size_t tmp = end;
+        end = start;
+        start = tmp;
+    }
 
-        if ('\0' == *n) {
-            return codepoints_count;
-        } else {
-            /* h could be in the middle of an unmatching utf8 codepoint,
-             * so we need to march it on to the next character beginning
-             * starting from the current character */
-            str = utf8codepoint(maybeMatch, &throwaway_codepoint);
-            codepoints_count ++;
+    return str_of_view(strview_substring(strview_of(str), start, end));
+}
+
+_Static_assert(sizeof(int) == sizeof(int32_t), "vec_int elements must be 32-bit codepoints");
+
+col_error_t str_to_utf32(const char * str, vec_int v) {
+    const ice_strview s = strview_of(str);
+    col_error_t err;
+    if ((err = vec_int_reserve(v, v->len + s.nbytes)) != COL_OK) {
+        return err;
+    }
+    size_t count;
+    if (!ice_utf8_to_utf32(s.ptr, s.nbytes, (int32_t *) v->data + v->len, &count, NULL)) {
+        return COL_ERR_ILLEGAL_ARGUMENT;
+    }
+    v->len += count;
+    return COL_OK;
+}
+
+char * str_from_utf32(const int32_t * runes, size_t n) {
+    if (runes == NULL) {
+        return str_of_empty();
+    }
+    size_t nb;
+    if (!ice_utf32_utf8_size(runes, n, &nb, NULL)) {
+        return NULL;
+    }
+    char * buf;
+    if ((buf = ice_aligned_malloc(PTR_ALIGN, nb + 1)) == NULL) {
+        return NULL;
+    }
+    buf[ice_utf32_to_utf8(runes, n, buf)] = '\0';
+    return buf;
+}
+
+ice_strbuf ice_strbuf_new(size_t cap) {
+    ice_strbuf sb = ice_malloc_ptr_aligned(sizeof(struct ice_strbuf_t));
+    if (sb == NULL) {
+        return NULL;
+    }
+    sb->len = 0;
+    sb->cap = 0;
+    sb->data = NULL;
+    if (ice_strbuf_reserve(sb, cap) != COL_OK) {
+        ice_aligned_free(sb);
+        return NULL;
+    }
+    return sb;
+}
+
+void ice_strbuf_free(ice_strbuf sb) {
+    if (sb != NULL) {
+        ice_aligned_free(sb->data);
+        ice_aligned_free(sb);
+    }
+}
+
+col_error_t ice_strbuf_reserve(ice_strbuf sb, size_t cap) {
+    if (sb->data != NULL && cap <= sb->cap) {
+        return COL_OK;
+    }
+    if (cap >= SIZE_MAX / 2) {
+        return COL_ERR_BAD_ALLOC;
+    }
+    // Copies only the used bytes and the '\0' byte
+    char * data = ice_aligned_realloc(sb->data, PTR_ALIGN, sb->data == NULL ? 0 : sb->len + 1, cap + 1);
+    if (data == NULL) {
+        return COL_ERR_BAD_ALLOC;
+    }
+    data[sb->len] = '\0';
+    sb->data = data;
+    sb->cap = cap;
+    return COL_OK;
+}
+
+static inline col_error_t ice_strbuf_grow(ice_strbuf sb, size_t nb) {
+    if (nb <= sb->cap - sb->len) {
+        return COL_OK;
+    }
+    if (nb > SIZE_MAX / 2 - sb->len) {
+        return COL_ERR_BAD_ALLOC;
+    }
+    size_t cap = (size_t) (VEC_GROWTH * (double) sb->cap);
+    if (cap < sb->len + nb) {
+        cap = sb->len + nb;
+    }
+    if (cap < 15) {
+        cap = 15;
+    }
+    return ice_strbuf_reserve(sb, cap);
+}
+
+col_error_t ice_strbuf_append(ice_strbuf sb, const char * s) {
+    if (s == NULL) {
+        return COL_OK;
+    }
+    return ice_strbuf_append_n(sb, s, strlen(s));
+}
+
+col_error_t ice_strbuf_append_n(ice_strbuf sb, const char * s, size_t nb) {
+    // s may point into the buffer which growing can move
+    const uintptr_t s_addr = (uintptr_t) s;
+    const uintptr_t data_addr = (uintptr_t) sb->data;
+    const bool aliased = sb->data != NULL && s_addr >= data_addr && s_addr < data_addr + sb->len;
+    col_error_t err;
+    if ((err = ice_strbuf_grow(sb, nb)) != COL_OK) {
+        return err;
+    }
+    if (aliased) {
+        s = sb->data + (s_addr - data_addr);
+    }
+    memcpy(sb->data + sb->len, s, nb);
+    sb->len += nb;
+    sb->data[sb->len] = '\0';
+    return COL_OK;
+}
+
+col_error_t ice_strbuf_append_rune(ice_strbuf sb, int rune) {
+    col_error_t err;
+    if ((err = ice_strbuf_grow(sb, 4)) != COL_OK) {
+        return err;
+    }
+    sb->len += str_rune_encode(rune, sb->data + sb->len);
+    sb->data[sb->len] = '\0';
+    return COL_OK;
+}
+
+col_error_t ice_strbuf_appendf(ice_strbuf sb, const char * fmt, ...) {
+    col_error_t err;
+    if ((err = ice_strbuf_grow(sb, 0)) != COL_OK) {
+        return err;
+    }
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(sb->data + sb->len, sb->cap - sb->len + 1, fmt, args);
+    va_end(args);
+    if (n < 0) {
+        sb->data[sb->len] = '\0';
+        return COL_ERR_ILLEGAL_ARGUMENT;
+    }
+    if ((size_t) n > sb->cap - sb->len) {
+        // Didn't fit, grow and format again
+        if ((err = ice_strbuf_grow(sb, (size_t) n)) != COL_OK) {
+            sb->data[sb->len] = '\0';
+            return err;
         }
+        va_start(args, fmt);
+        vsnprintf(sb->data + sb->len, sb->cap - sb->len + 1, fmt, args);
+        va_end(args);
     }
+    sb->len += (size_t) n;
+    return COL_OK;
+}
 
-    return -1;
+size_t ice_strbuf_size(ice_strbuf sb) {
+    return sb->len;
 }
 
-typedef struct str_scan_token_t {
-    size_t scan_index;
-    char * str_mem;
-    size_t codepoint_index;
-} str_scan_token;
+const char * ice_strbuf_cstr(ice_strbuf sb) {
+    return sb->data;
+}
+
+void ice_strbuf_clear(ice_strbuf sb) {
+    sb->len = 0;
+    sb->data[0] = '\0';
+}
+
+char * ice_strbuf_finish(ice_strbuf sb) {
+    if (sb == NULL) {
+        return NULL;
+    }
+    char * str = sb->data;
+    ice_aligned_free(sb);
+    return str;
+}
+
+_Static_assert(sizeof(lstr_hdr) % PTR_ALIGN == 0, "lstr characters must be pointer aligned");
+_Static_assert(sizeof(offset_t) == sizeof(uint16_t), "lstr offset must match ice_aligned_malloc");
+
+static char * lstr_alloc(size_t cap) {
+    if (cap > SIZE_MAX - sizeof(lstr_hdr) - 1) {
+        return NULL;
+    }
+    char * block = ice_aligned_malloc(PTR_ALIGN, sizeof(lstr_hdr) + cap + 1);
+    if (block == NULL) {
+        return NULL;
+    }
+    lstr_hdr * hdr = (lstr_hdr *) block;
+    hdr->size = 0;
+    hdr->cap = cap;
+    hdr->len = 0;
+    // Lets ice_aligned_free find the start of the block from the characters
+    hdr->offset = (uint16_t) (ice_offset_of(block) + sizeof(lstr_hdr));
+
+    char * str = block + sizeof(lstr_hdr);
+    str[0] = '\0';
+    return str;
+}
+
+char * lstr_of(const char * s) {
+    return lstr_nbof(s, SIZE_MAX);
+}
 
-// Internal utility for substring and other codepoint index based functions.
-// Scan the string and gather information about the string.
-void str_codepoint_byte_pos(char * str, str_scan_token * tok_start, str_scan_token * tok_end) {
+// Copies exactly nb bytes, s must have at least nb bytes.
+static char * lstr_of_bytes(const char * s, size_t nb) {
+    char * str = lstr_alloc(nb);
     if (str == NULL) {
-        return;
+        return NULL;
     }
-    utf8_int32_t throwaway_codepoint = 0;
+    memcpy(str, s, nb);
+    str[nb] = '\0';
+    lstr_hdr * hdr = lstr_hdr_of(str);
+    hdr->size = nb;
+    hdr->len = nb == 0 ? 0 : LSTR_LEN_UNKNOWN;
+    return str;
+}
 
-    /*
-     * if needle has no utf8 codepoints before the null terminating
-     * byte then return 0.
-     * Empty string is always in a string.
-     */
-    if (tok_start->scan_index == 0) {
-        tok_start->str_mem = str;
-        tok_start->codepoint_index = 0;
+char * lstr_nbof(const char * s, size_t nb) {
+    if (s == NULL || nb == 0) {
+        return lstr_of_empty();
     }
-    if (tok_end->scan_index == 0) {
-        tok_end->str_mem = str;
-        tok_end->codepoint_index = 0;
+    const size_t slen_bytes = utf8size_lazy(s);
+    if (nb > slen_bytes) {
+        nb = slen_bytes;
     }
+    return lstr_of_bytes(s, nb);
+}
 
-    size_t codepoints_count = 0;
-    while ('\0' != *str) {
-        utf8_int8_t *maybeMatch = str;
+char * lstr_of_empty() {
+    return lstr_alloc(0);
+}
+
+void lstr_free(char * lstr) {
+    str_free(lstr);
+}
+
+size_t lstr_len(const char * lstr) {
+    lstr_hdr * hdr = lstr_hdr_of(lstr);
+    if (hdr->len == LSTR_LEN_UNKNOWN) {
+        hdr->len = str_len(lstr);
+    }
+    return hdr->len;
+}
+
+size_t lstr_size(const char * lstr) {
+    return lstr_hdr_of(lstr)->size;
+}
 
-        if (codepoints_count == tok_start->scan_index) {
-            tok_start->str_mem = maybeMatch;
-            tok_start->codepoint_index = codepoints_count;
+// Appends exactly nb bytes of s, lstr stays valid if out of memory.
+static char * lstr_append_bytes(char * lstr, const char * s, size_t nb) {
+    lstr_hdr * hdr = lstr_hdr_of(lstr);
+    if (nb > hdr->cap - hdr->size) {
+        // s may point into lstr which is freed after growing
+        const uintptr_t s_addr = (uintptr_t) s;
+        const uintptr_t lstr_addr = (uintptr_t) lstr;
+        const bool aliased = s_addr >= lstr_addr && s_addr <= lstr_addr + hdr->size;
+        if (nb > SIZE_MAX / 2 - hdr->size) {
+            return NULL;
+        }
+        size_t cap = (size_t) (VEC_GROWTH * (double) hdr->cap);
+        if (cap < hdr->size + nb) {
+            cap = hdr->size + nb;
+        }
+        char * grown = lstr_alloc(cap);
+        if (grown == NULL) {
+            return NULL;
         }
-        if (codepoints_count == tok_end->scan_index) {
-            tok_end->str_mem = maybeMatch;
-            tok_end->codepoint_index = codepoints_count;
+        lstr_hdr * grown_hdr = lstr_hdr_of(grown);
+        memcpy(grown, lstr, hdr->size);
+        grown_hdr->size = hdr->size;
+        grown_hdr->len = hdr->len;
+        if (aliased) {
+            s = grown + (s_addr - lstr_addr);
         }
-        /* h could be in the middle of an unmatching utf8 codepoint,
-         * so we need to march it on to the next character beginning
-         * starting from the current character */
-        str = utf8codepoint(maybeMatch, &throwaway_codepoint);
-        codepoints_count ++;
+        lstr_free(lstr);
+        lstr = grown;
+        hdr = grown_hdr;
     }
+    memcpy(lstr + hdr->size, s, nb);
+    if (hdr->len != LSTR_LEN_UNKNOWN) {
+        hdr->len += ice_utf8_count(s, nb);
+    }
+    hdr->size += nb;
+    lstr[hdr->size] = '\0';
+    return lstr;
+}
 
-    if (codepoints_count <= tok_start->scan_index) {
-        tok_start->str_mem = str;
-        tok_start->codepoint_index = codepoints_count;
+char * lstr_append(char * lstr, const char * s) {
+    if (lstr == NULL) {
+        return lstr_of(s);
     }
-    if (codepoints_count <= tok_end->scan_index) {
-        tok_end->str_mem = str;
-        tok_end->codepoint_index = codepoints_count;
+    if (s == NULL || *s == '\0') {
+        return lstr;
     }
+    return lstr_append_bytes(lstr, s, utf8size_lazy(s));
 }
 
-char * str_substring(const char * str, size_t start, size_t end) {
-    // Same index return the empty string
-    if (start == end) {
-        return str_of_empty();
+char * lstr_substring(const char * lstr, size_t start, size_t end) {
+    if (start > end) {
+        size_t tmp = end;
+        end = start;
+        start = tmp;
+    }
+    const size_t len = lstr_len(lstr);
+    if (end > len) {
+        end = len;
+    }
+    if (start >= end) {
+        return lstr_of_empty();
     }
 
-    // Fix order of indices
+    char * sub;
+    if (len == lstr_size(lstr)) {
+        // ASCII, codepoint indices are byte indices
+        sub = lstr_of_bytes(lstr + start, end - start);
+    } else {
+        const ice_strview v = strview_substring(strview_of_n(lstr, lstr_size(lstr)), start, end);
+        sub = lstr_of_bytes(v.ptr, v.nbytes);
+    }
+    if (sub != NULL) {
+        lstr_hdr_of(sub)->len = end - start;
+    }
+    return sub;
+}
+
+ice_strview strview_of(const char * s) {
+    ice_strview v = {.ptr = s == NULL ? "" : s, .nbytes = s == NULL ? 0 : strlen(s)};
+    return v;
+}
+
+ice_strview strview_of_n(const char * s, size_t nb) {
+    ice_strview v = {.ptr = s == NULL ? "" : s, .nbytes = s == NULL ? 0 : nb};
+    return v;
+}
+
+char * str_of_view(ice_strview v) {
+    // Don't use str_nbof, it would scan the viewed string up to its '\0'
+    char * buf;
+    if ((buf = ice_aligned_malloc(PTR_ALIGN, v.nbytes + 1)) == NULL) {
+        return NULL;
+    }
+    memcpy(buf, v.ptr, v.nbytes);
+    buf[v.nbytes] = '\0';
+    return buf;
+}
+
+size_t strview_len(ice_strview v) {
+    return ice_utf8_count(v.ptr, v.nbytes);
+}
+
+ice_strview strview_substring(ice_strview v, size_t start, size_t end) {
+    if (start > end) {
+        size_t tmp = end;
+        end = start;
+        start = tmp;
+    }
+    const size_t first = ice_utf8_offset(v.ptr, v.nbytes, start);
+    const size_t last = first + ice_utf8_offset(v.ptr + first, v.nbytes - first, end - start);
+    return strview_of_n(v.ptr + first, last - first);
+}
+
+size_t strview_find(ice_strview v, ice_strview needle) {
+    return ice_search(v.ptr, v.nbytes, needle.ptr, needle.nbytes);
+}
+
+size_t strview_find_needle(ice_strview v, ice_needle needle) {
+    return ice_needle_find(needle, v.ptr, v.nbytes);
+}
+
+static inline bool strview_is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+ice_strview strview_trim_left(ice_strview v) {
+    size_t i = 0;
+    while (i < v.nbytes && strview_is_space(v.ptr[i])) {
+        i++;
+    }
+    return strview_of_n(v.ptr + i, v.nbytes - i);
+}
+
+ice_strview strview_trim_right(ice_strview v) {
+    size_t n = v.nbytes;
+    while (n > 0 && strview_is_space(v.ptr[n - 1])) {
+        n--;
+    }
+    return strview_of_n(v.ptr, n);
+}
+
+ice_strview strview_trim(ice_strview v) {
+    return strview_trim_right(strview_trim_left(v));
+}
+
+int strview_cmp(ice_strview a, ice_strview b) {
+    const size_t n = a.nbytes < b.nbytes ? a.nbytes : b.nbytes;
+    const int c = memcmp(a.ptr, b.ptr, n);
+    if (c != 0) {
+        return c;
+    }
+    return a.nbytes < b.nbytes ? -1 : a.nbytes > b.nbytes;
+}
+
+bool strview_eq(ice_strview a, ice_strview b) {
+    return a.nbytes == b.nbytes && memcmp(a.ptr, b.ptr, a.nbytes) == 0;
+}
+
+bool strview_starts_with(ice_strview v, ice_strview prefix) {
+    return v.nbytes >= prefix.nbytes && memcmp(v.ptr, prefix.ptr, prefix.nbytes) == 0;
+}
+
+bool strview_ends_with(ice_strview v, ice_strview suffix) {
+    return v.nbytes >= suffix.nbytes && memcmp(v.ptr + v.nbytes - suffix.nbytes, suffix.ptr, suffix.nbytes) == 0;
+}
+
+ice_strview_split strview_split(ice_strview v, ice_strview sep) {
+    ice_strview_split it = {.rest = v, .sep = sep, .done = false};
+    return it;
+}
+
+bool strview_split_next(ice_strview_split * it, ice_strview * tok) {
+    if (it->done) {
+        return false;
+    }
+    const size_t pos = it->sep.nbytes == 0 ? STRVIEW_NPOS : strview_find(it->rest, it->sep);
+    if (pos == STRVIEW_NPOS) {
+        *tok = it->rest;
+        it->done = true;
+    } else {
+        *tok = strview_of_n(it->rest.ptr, pos);
+        it->rest = strview_of_n(it->rest.ptr + pos + it->sep.nbytes, it->rest.nbytes - pos - it->sep.nbytes);
+    }
+    return true;
+}
+
+#define strview_tok_is_delim(it, c) (((it)->delims[(unsigned char) (c) >> 6] >> ((unsigned char) (c) & 63)) & 1)
+
+ice_strview_tok strview_tokenize(ice_strview v, const char * delims) {
+    ice_strview_tok it = {.rest = v, .delims = {0, 0, 0, 0}};
+    for (const unsigned char * d = (const unsigned char *) delims; d != NULL && *d != '\0'; ++d) {
+        it.delims[*d >> 6] |= (uint64_t) 1 << (*d & 63);
+    }
+    return it;
+}
+
+bool strview_tokenize_next(ice_strview_tok * it, ice_strview * tok) {
+    const char * p = it->rest.ptr;
+    const char * end = it->rest.ptr + it->rest.nbytes;
+    while (p < end && strview_tok_is_delim(it, *p)) {
+        p++;
+    }
+    if (p == end) {
+        it->rest = strview_of_n(end, 0);
+        return false;
+    }
+    const char * first = p;
+    while (p < end && !strview_tok_is_delim(it, *p)) {
+        p++;
+    }
+    *tok = strview_of_n(first, (size_t) (p - first));
+    it->rest = strview_of_n(p, (size_t) (end - p));
+    return true;
+}
+
+str_cpindex str_cpindex_new(const char * str, size_t stride) {
+    str_cpindex idx = ice_malloc_ptr_aligned(sizeof(struct str_cpindex_t));
+    if (idx == NULL) {
+        return NULL;
+    }
+    const ice_strview v = strview_of(str);
+    idx->str = v.ptr;
+    idx->nbytes = v.nbytes;
+    idx->len = ice_utf8_count(v.ptr, v.nbytes);
+    idx->stride = stride == 0 ? STR_CPINDEX_STRIDE : stride;
+    idx->nmarks = idx->len / idx->stride + 1;
+    if ((idx->marks = ice_aligned_malloc(PTR_ALIGN, idx->nmarks * sizeof(size_t))) == NULL) {
+        ice_aligned_free(idx);
+        return NULL;
+    }
+    // Mark m is the offset of codepoint m * stride, found from mark m - 1
+    idx->marks[0] = 0;
+    for (size_t m = 1; m < idx->nmarks; ++m) {
+        const size_t prev = idx->marks[m - 1];
+        idx->marks[m] = prev + ice_utf8_offset(v.ptr + prev, v.nbytes - prev, idx->stride);
+    }
+    return idx;
+}
+
+void str_cpindex_free(str_cpindex idx) {
+    if (idx != NULL) {
+        ice_aligned_free(idx->marks);
+        ice_aligned_free(idx);
+    }
+}
+
+size_t str_cpindex_len(str_cpindex idx) {
+    return idx->len;
+}
+
+size_t str_cpindex_offset(str_cpindex idx, size_t k) {
+    if (k >= idx->len) {
+        return idx->nbytes;
+    }
+    const size_t m = k / idx->stride;
+    const size_t base = idx->marks[m];
+    return base + ice_utf8_offset(idx->str + base, idx->nbytes - base, k - m * idx->stride);
+}
+
+size_t str_cpindex_codepoint(str_cpindex idx, size_t pos) {
+    if (pos >= idx->nbytes) {
+        return idx->len;
+    }
+    // Last mark at or before pos
+    size_t lo = 0;
+    size_t hi = idx->nmarks;
+    while (hi - lo > 1) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (idx->marks[mid] <= pos) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo * idx->stride + ice_utf8_count(idx->str + idx->marks[lo], pos - idx->marks[lo]);
+}
+
+ice_strview str_cpindex_view(str_cpindex idx, size_t start, size_t end) {
     if (start > end) {
         size_t tmp = end;
         end = start;
         start = tmp;
     }
+    const size_t first = str_cpindex_offset(idx, start);
+    const size_t last = str_cpindex_offset(idx, end);
+    return strview_of_n(idx->str + first, last - first);
+}
 
-    // Scan the string once and resolve the byte positions for the
-    // codepoint indices
-    str_scan_token tok_start = {.scan_index = start, .str_mem = NULL, .codepoint_index = 0};
-    str_scan_token tok_end = {.scan_index = end, .str_mem = NULL, .codepoint_index = 0};
+char * str_cpindex_substring(str_cpindex idx, size_t start, size_t end) {
+    if (start == end) {
+        return str_of_empty();
+    }
+    return str_of_view(str_cpindex_view(idx, start, end));
+}
 
-    str_codepoint_byte_pos((char *) str, &tok_start, &tok_end);
+int str_cpindex_index_string(str_cpindex idx, const char * lookup) {
+    if (lookup == NULL) {
+        return -1;
+    }
+    const size_t pos = strview_find(strview_of_n(idx->str, idx->nbytes), strview_of(lookup));
+    if (pos == STRVIEW_NPOS) {
+        return -1;
+    }
+    return (int) str_cpindex_codepoint(idx, pos);
+}
+
+_Static_assert(sizeof(ice_sstr) == ICE_SSTR_SIZE, "ice_sstr must not be padded");
+_Static_assert(ICE_SSTR_INLINE < ICE_SSTR_HEAP, "inline sizes must not collide with the heap tag");
+
+static inline void sstr_set_inline_size(ice_sstr * s, size_t nb) {
+    s->u.data[nb] = '\0';
+    s->u.data[ICE_SSTR_SIZE - 1] = (char) nb;
+}
+
+static inline void sstr_set_heap(ice_sstr * s, char * lstr) {
+    s->u.lstr = lstr;
+    s->u.data[ICE_SSTR_SIZE - 1] = (char) ICE_SSTR_HEAP;
+}
+
+col_error_t sstr_init_n(ice_sstr * s, const char * str, size_t nb) {
+    if (str == NULL || nb == 0) {
+        sstr_set_inline_size(s, 0);
+        return COL_OK;
+    }
+    if (nb <= ICE_SSTR_INLINE) {
+        memcpy(s->u.data, str, nb);
+        sstr_set_inline_size(s, nb);
+        return COL_OK;
+    }
+    char * lstr = lstr_of_bytes(str, nb);
+    if (lstr == NULL) {
+        sstr_set_inline_size(s, 0);
+        return COL_ERR_BAD_ALLOC;
+    }
+    sstr_set_heap(s, lstr);
+    return COL_OK;
+}
+
+col_error_t sstr_init(ice_sstr * s, const char * str) {
+    return sstr_init_n(s, str, str == NULL ? 0 : strlen(str));
+}
 
-    return str_nbof(tok_start.str_mem, (tok_end.str_mem - tok_start.str_mem));
+void sstr_free(ice_sstr * s) {
+    if (!sstr_is_inline(s)) {
+        lstr_free(s->u.lstr);
+    }
+    sstr_set_inline_size(s, 0);
 }
 
+col_error_t sstr_append_n(ice_sstr * s, const char * str, size_t nb) {
+    if (str == NULL || nb == 0) {
+        return COL_OK;
+    }
+    if (!sstr_is_inline(s)) {
+        char * lstr = lstr_append_bytes(s->u.lstr, str, nb);
+        if (lstr == NULL) {
+            return COL_ERR_BAD_ALLOC;
+        }
+        s->u.lstr = lstr;
+        return COL_OK;
+    }
+    const size_t size = sstr_size(s);
+    if (nb <= ICE_SSTR_INLINE - size) {
+        memcpy(s->u.data + size, str, nb);
+        sstr_set_inline_size(s, size + nb);
+        return COL_OK;
+    }
+    // Spill, leave room to grow like lstr_append
+    if (nb > SIZE_MAX / 2) {
+        return COL_ERR_BAD_ALLOC;
+    }
+    char * lstr = lstr_alloc((size_t) (VEC_GROWTH * (double) (size + nb)));
+    if (lstr == NULL) {
+        return COL_ERR_BAD_ALLOC;
+    }
+    memcpy(lstr, s->u.data, size);
+    memcpy(lstr + size, str, nb);
+    lstr[size + nb] = '\0';
+    lstr_hdr * hdr = lstr_hdr_of(lstr);
+    hdr->size = size + nb;
+    hdr->len = LSTR_LEN_UNKNOWN;
+    sstr_set_heap(s, lstr);
+    return COL_OK;
+}
+
+col_error_t sstr_append(ice_sstr * s, const char * str) {
+    return sstr_append_n(s, str, str == NULL ? 0 : strlen(str));
+}
+
+char * str_of_sstr(const ice_sstr * s) {
+    return str_of_view(sstr_view(s));
+}
+
+bool sstr_eq(const ice_sstr * a, const ice_sstr * b) {
+    return strview_eq(sstr_view(a), sstr_view(b));
+}
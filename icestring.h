@@ -32,9 +32,13 @@ extern "C" {
 #endif
 
 #include <uchar.h>
+#include <stdint.h>
+#include <stdbool.h>
 #include "col_error.h"
 #include <error.h>
 #include "utf8.h"
+#include "icesearch.h"
+#include "vec_int.h"
 
 /**
  * Create a clone of s. Returns the empty string if s is NULL.
@@ -88,6 +92,8 @@ size_t str_size(const char * str);
  * The memory of str might be reallocated. Using original pointer of str leads
  * to undefined behaviour.
  *
+ * Every call copies str, use ice_strbuf to build a string from many pieces.
+ *
  * @param str Left string
  * @param s The string to append/concat
  * @return Concatenated string
@@ -96,10 +102,380 @@ char * str_append(char * str, const char * s);
 
 int str_index_rune(const char * str, int rune);
 
+/**
+ * Codepoint index of the first occurrence of lookup in str or -1.
+ */
 int str_index_string(const char * str, const char * lookup);
 
+/**
+ * Like str_index_string with a compiled needle, e.g. to search the same
+ * string in many strings.
+ */
+int str_index_needle(const char * str, ice_needle needle);
+
 char * str_substring(const char * str, size_t start, size_t end);
 
+/**
+ * Append the codepoints of str to v. ASCII runs are transcoded 16 or 32
+ * bytes at a time.
+ *
+ * @return COL_ERR_ILLEGAL_ARGUMENT if str isn't valid UTF-8, v is
+ * unchanged then. Use ice_utf8_to_utf32 to get the offset of the error.
+ */
+col_error_t str_to_utf32(const char * str, vec_int v);
+
+/**
+ * Create a string from n codepoints. A 0 codepoint is encoded as '\0'
+ * byte, so the string ends there.
+ *
+ * @return The string or NULL if a codepoint is negative, a surrogate or
+ * above U+10FFFF or if out of memory
+ */
+char * str_from_utf32(const int32_t * runes, size_t n);
+
+/**
+ * String builder with explicit length and capacity. Appending grows the
+ * buffer geometrically, so building a string from n pieces is O(n) in
+ * contrast to repeated str_append calls.
+ *
+ * The buffer is always '\0' terminated. ice_strbuf_finish hands the
+ * buffer over as a string which must be released with str_free.
+ */
+typedef struct ice_strbuf_t {
+    size_t len;
+    size_t cap;
+    char * data;
+} *ice_strbuf;
+
+/**
+ * Create a string builder with room for cap bytes.
+ *
+ * @param cap Initial capacity in bytes excluding the '\0' byte
+ * @return The string builder or NULL if out of memory
+ */
+ice_strbuf ice_strbuf_new(size_t cap);
+
+void ice_strbuf_free(ice_strbuf sb);
+
+col_error_t ice_strbuf_reserve(ice_strbuf sb, size_t cap);
+
+/**
+ * Append string s. Does nothing if s is NULL.
+ */
+col_error_t ice_strbuf_append(ice_strbuf sb, const char * s);
+
+/**
+ * Append the first nb bytes of s. s must have at least nb bytes.
+ */
+col_error_t ice_strbuf_append_n(ice_strbuf sb, const char * s, size_t nb);
+
+/**
+ * Append the UTF-8 encoding of codepoint rune. Does nothing if rune is 0.
+ */
+col_error_t ice_strbuf_append_rune(ice_strbuf sb, int rune);
+
+/**
+ * Append printf style formatted output, formatted directly into the buffer.
+ */
+col_error_t ice_strbuf_appendf(ice_strbuf sb, const char * fmt, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * The number of bytes without counting '\0'.
+ */
+size_t ice_strbuf_size(ice_strbuf sb);
+
+/**
+ * The '\0' terminated content. Valid until the next modification.
+ */
+const char * ice_strbuf_cstr(ice_strbuf sb);
+
+void ice_strbuf_clear(ice_strbuf sb);
+
+/**
+ * Free the string builder and return its content as string. The
+ * string must be released with str_free.
+ *
+ * @return The built string or NULL if out of memory
+ */
+char * ice_strbuf_finish(ice_strbuf sb);
+
+/**
+ * Length prefixed strings. A lstr is a '\0' terminated char * with a
+ * header in front of the first byte which stores the byte length, the
+ * capacity and the codepoint count. The codepoint count is computed on
+ * the first lstr_len call and cached.
+ *
+ * A lstr can be passed to every function expecting a char *, including
+ * str_free. Functions returning a new string, e.g. str_append, return
+ * plain strings though. Only lstr_* functions keep the header up to date,
+ * so don't modify a lstr through its char *.
+ */
+#define LSTR_LEN_UNKNOWN SIZE_MAX
+
+typedef struct lstr_hdr_t {
+    size_t size;
+    size_t cap;
+    size_t len;
+    char reserved[sizeof(size_t) - sizeof(uint16_t)];
+    // Same as the offset stored by ice_aligned_malloc, must be the last field
+    uint16_t offset;
+} lstr_hdr;
+
+#define lstr_hdr_of(str) ((lstr_hdr *) ((char *) (str) - sizeof(lstr_hdr)))
+
+/**
+ * Create a lstr from s. Returns the empty lstr if s is NULL.
+ */
+char * lstr_of(const char * s);
+
+/**
+ * Create a lstr from the first nb bytes of s, nb is clamped to the byte
+ * length of s.
+ */
+char * lstr_nbof(const char * s, size_t nb);
+
+char * lstr_of_empty();
+
+void lstr_free(char * lstr);
+
+/**
+ * The number of codepoints of lstr. O(n) on the first call, O(1) after.
+ */
+size_t lstr_len(const char * lstr);
+
+/**
+ * The number of bytes used by lstr without counting '\0'. O(1).
+ */
+size_t lstr_size(const char * lstr);
+
+/**
+ * Append s to lstr. lstr grows geometrically, so appending n strings is
+ * O(n). If lstr is NULL a lstr of s is returned. The original pointer of
+ * lstr must not be used anymore.
+ *
+ * @return The concatenated lstr or NULL if out of memory
+ */
+char * lstr_append(char * lstr, const char * s);
+
+/**
+ * Like str_substring but returns a lstr. Doesn't scan lstr if it's
+ * known to be ASCII.
+ */
+char * lstr_substring(const char * lstr, size_t start, size_t end);
+
+/**
+ * Non-owning view of nbytes bytes at ptr. The bytes don't need to be '\0'
+ * terminated. Views never allocate, they are valid as long as the viewed
+ * string is. Use str_of_view to create a string from a view.
+ *
+ * Substring indices are codepoint indices like in str_substring, find
+ * returns byte offsets into the view or STRVIEW_NPOS.
+ */
+typedef struct ice_strview {
+    const char * ptr;
+    size_t nbytes;
+} ice_strview;
+
+#define STRVIEW_NPOS ICE_SEARCH_NPOS
+
+/**
+ * View of s without the '\0' byte. Returns the empty view if s is NULL.
+ */
+ice_strview strview_of(const char * s);
+
+ice_strview strview_of_n(const char * s, size_t nb);
+
+/**
+ * Create a new string with the bytes of v. Release it with str_free.
+ */
+char * str_of_view(ice_strview v);
+
+/**
+ * The number of codepoints of v.
+ */
+size_t strview_len(ice_strview v);
+
+ice_strview strview_substring(ice_strview v, size_t start, size_t end);
+
+/**
+ * Byte offset of the first occurrence of needle in v or STRVIEW_NPOS.
+ * The empty needle is found at 0.
+ */
+size_t strview_find(ice_strview v, ice_strview needle);
+
+size_t strview_find_needle(ice_strview v, ice_needle needle);
+
+/**
+ * Remove leading and/or trailing ASCII whitespace.
+ */
+ice_strview strview_trim(ice_strview v);
+ice_strview strview_trim_left(ice_strview v);
+ice_strview strview_trim_right(ice_strview v);
+
+/**
+ * Byte wise comparison, a prefix sorts before the longer view.
+ *
+ * @return <0, 0 or >0 like strcmp
+ */
+int strview_cmp(ice_strview a, ice_strview b);
+bool strview_eq(ice_strview a, ice_strview b);
+bool strview_starts_with(ice_strview v, ice_strview prefix);
+bool strview_ends_with(ice_strview v, ice_strview suffix);
+
+/**
+ * Iterator splitting a view at every occurrence of a separator. Adjacent
+ * separators give empty tokens, e.g. "a,,b" gives "a", "" and "b".
+ *
+ * ice_strview_split it = strview_split(v, strview_of(","));
+ * ice_strview tok;
+ * while (strview_split_next(&it, &tok)) { ... }
+ */
+typedef struct ice_strview_split {
+    ice_strview rest;
+    ice_strview sep;
+    bool done;
+} ice_strview_split;
+
+ice_strview_split strview_split(ice_strview v, ice_strview sep);
+bool strview_split_next(ice_strview_split * it, ice_strview * tok);
+
+/**
+ * Iterator returning the non-empty tokens between runs of delimiter
+ * bytes. delims is a '\0' terminated set of ASCII delimiters.
+ */
+typedef struct ice_strview_tok {
+    ice_strview rest;
+    uint64_t delims[4];
+} ice_strview_tok;
+
+ice_strview_tok strview_tokenize(ice_strview v, const char * delims);
+bool strview_tokenize_next(ice_strview_tok * it, ice_strview * tok);
+
+/**
+ * Codepoint index of a string. Records the byte offset of every stride-th
+ * codepoint, so substring and index lookups jump close to the target and
+ * decode at most stride codepoints instead of the whole prefix. Worth it
+ * if many lookups are done on the same large string.
+ *
+ * The index refers to the string, the string must not be modified or
+ * released while the index is in use.
+ */
+#define STR_CPINDEX_STRIDE 128
+
+typedef struct str_cpindex_t {
+    const char * str;
+    size_t nbytes;
+    size_t len;
+    size_t stride;
+    size_t nmarks;
+    size_t * marks;
+} *str_cpindex;
+
+/**
+ * Build the codepoint index of str.
+ *
+ * @param stride Codepoints between two recorded offsets, 0 uses
+ * STR_CPINDEX_STRIDE
+ * @return The index or NULL if out of memory
+ */
+str_cpindex str_cpindex_new(const char * str, size_t stride);
+
+void str_cpindex_free(str_cpindex idx);
+
+/**
+ * The number of codepoints of the indexed string.
+ */
+size_t str_cpindex_len(str_cpindex idx);
+
+/**
+ * Byte offset of the codepoint with index k or the byte size of the
+ * string if k is out of range.
+ */
+size_t str_cpindex_offset(str_cpindex idx, size_t k);
+
+/**
+ * Codepoint index of the codepoint starting at byte offset pos.
+ */
+size_t str_cpindex_codepoint(str_cpindex idx, size_t pos);
+
+/**
+ * Same as str_substring and strview_substring on the indexed string.
+ */
+char * str_cpindex_substring(str_cpindex idx, size_t start, size_t end);
+ice_strview str_cpindex_view(str_cpindex idx, size_t start, size_t end);
+
+/**
+ * Same as str_index_string on the indexed string.
+ */
+int str_cpindex_index_string(str_cpindex idx, const char * lookup);
+
+/**
+ * Small string value type. Strings of up to ICE_SSTR_INLINE bytes are
+ * stored inline in the 24 byte struct, longer strings spill to a heap
+ * allocated lstr. Building short keys with sstr functions needs no
+ * allocation at all.
+ *
+ * The last byte of data holds the size of an inline string or
+ * ICE_SSTR_HEAP. An ice_sstr must be initialized with sstr_init* and
+ * released with sstr_free. Copying the struct copies a heap pointer, so
+ * only one of the copies may be released.
+ */
+#define ICE_SSTR_SIZE 24
+#define ICE_SSTR_INLINE (ICE_SSTR_SIZE - 2)
+#define ICE_SSTR_HEAP 0xff
+
+typedef struct ice_sstr {
+    union {
+        char data[ICE_SSTR_SIZE];
+        char * lstr;
+    } u;
+} ice_sstr;
+
+/**
+ * Initialize s with a copy of str. NULL gives the empty string.
+ */
+col_error_t sstr_init(ice_sstr * s, const char * str);
+
+/**
+ * Initialize s with a copy of the first nb bytes of str.
+ */
+col_error_t sstr_init_n(ice_sstr * s, const char * str, size_t nb);
+
+/**
+ * Release the heap string of s if any, s is the empty string afterwards.
+ */
+void sstr_free(ice_sstr * s);
+
+col_error_t sstr_append(ice_sstr * s, const char * str);
+
+col_error_t sstr_append_n(ice_sstr * s, const char * str, size_t nb);
+
+/**
+ * Create a new string with the bytes of s. Release it with str_free.
+ */
+char * str_of_sstr(const ice_sstr * s);
+
+bool sstr_eq(const ice_sstr * a, const ice_sstr * b);
+
+static inline bool sstr_is_inline(const ice_sstr * s) {
+    return (unsigned char) s->u.data[ICE_SSTR_SIZE - 1] != ICE_SSTR_HEAP;
+}
+
+/**
+ * The '\0' terminated characters of s. Valid until s is modified.
+ */
+static inline const char * sstr_cstr(const ice_sstr * s) {
+    return sstr_is_inline(s) ? s->u.data : s->u.lstr;
+}
+
+static inline size_t sstr_size(const ice_sstr * s) {
+    return sstr_is_inline(s) ? (unsigned char) s->u.data[ICE_SSTR_SIZE - 1] : lstr_size(s->u.lstr);
+}
+
+static inline ice_strview sstr_view(const ice_sstr * s) {
+    return strview_of_n(sstr_cstr(s), sstr_size(s));
+}
+
 #ifdef __cplusplus
 };
 #endif
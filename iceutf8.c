@@ -0,0 +1,776 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+#include <string.h>
+#include <stdint.h>
+
+#include "iceutf8.h"
+#include "ice_cpu.h"
+
+// --- Scalar kernels
+
+static size_t ice_utf8_count_scalar(const char * s, size_t nb) {
+    const unsigned char * p = (const unsigned char *) s;
+    size_t count = 0;
+    for (size_t i = 0; i < nb; ++i) {
+        count += (p[i] & 0xc0) != 0x80;
+    }
+    return count;
+}
+
+static size_t ice_utf8_offset_scalar(const char * s, size_t nb, size_t k) {
+    const unsigned char * p = (const unsigned char *) s;
+    for (size_t i = 0; i < nb; ++i) {
+        if ((p[i] & 0xc0) != 0x80 && k-- == 0) {
+            return i;
+        }
+    }
+    return nb;
+}
+
+// Decodes the sequence at p, returns its length or 0 if it is invalid.
+// https://www.unicode.org/versions/Unicode15.0.0/ch03.pdf, table 3-7
+static inline size_t ice_utf8_decode_one(const unsigned char * p, size_t avail, int32_t * pRune) {
+    const unsigned char c = p[0];
+    if (c < 0x80) {
+        *pRune = c;
+        return 1;
+    }
+    size_t n;
+    unsigned char lo = 0x80;
+    unsigned char hi = 0xbf;
+    int32_t rune;
+    if (c >= 0xc2 && c <= 0xdf) {
+        n = 1;
+        rune = c & 0x1f;
+    } else if (c >= 0xe0 && c <= 0xef) {
+        n = 2;
+        lo = c == 0xe0 ? 0xa0 : lo; // overlong
+        hi = c == 0xed ? 0x9f : hi; // surrogates
+        rune = c & 0x0f;
+    } else if (c >= 0xf0 && c <= 0xf4) {
+        n = 3;
+        lo = c == 0xf0 ? 0x90 : lo; // overlong
+        hi = c == 0xf4 ? 0x8f : hi; // above U+10FFFF
+        rune = c & 0x07;
+    } else {
+        return 0;
+    }
+    if (n >= avail || p[1] < lo || p[1] > hi) {
+        return 0;
+    }
+    rune = (rune << 6) | (p[1] & 0x3f);
+    for (size_t j = 2; j <= n; ++j) {
+        if ((p[j] & 0xc0) != 0x80) {
+            return 0;
+        }
+        rune = (rune << 6) | (p[j] & 0x3f);
+    }
+    *pRune = rune;
+    return n + 1;
+}
+
+// Returns the offset of the first invalid sequence or nb if s is valid.
+static size_t ice_utf8_error_offset_scalar(const char * s, size_t nb) {
+    const unsigned char * p = (const unsigned char *) s;
+    size_t i = 0;
+    while (i < nb) {
+        // Skip ASCII 8 bytes at a time
+        uint64_t word;
+        while (i + 8 <= nb && (memcpy(&word, p + i, 8), (word & 0x8080808080808080ULL) == 0)) {
+            i += 8;
+        }
+        if (i == nb) {
+            break;
+        }
+        int32_t rune;
+        const size_t len = ice_utf8_decode_one(p + i, nb - i, &rune);
+        if (len == 0) {
+            return i;
+        }
+        i += len;
+    }
+    return nb;
+}
+
+// Decodes up to the first invalid sequence and returns its offset or nb
+// if s is valid. dst needs room for nb codepoints.
+static size_t ice_utf8_to_utf32_scalar(const char * s, size_t nb, int32_t * dst, size_t * pCount) {
+    const unsigned char * p = (const unsigned char *) s;
+    size_t i = 0;
+    size_t k = 0;
+    while (i < nb) {
+        const size_t len = ice_utf8_decode_one(p + i, nb - i, dst + k);
+        if (len == 0) {
+            break;
+        }
+        i += len;
+        k++;
+    }
+    *pCount = k;
+    return i;
+}
+
+static size_t ice_utf32_to_utf8_scalar(const int32_t * src, size_t n, char * dst) {
+    size_t nb = 0;
+    for (size_t i = 0; i < n; ++i) {
+        nb += ice_utf8_encode_rune(src[i], dst + nb);
+    }
+    return nb;
+}
+
+#if defined(ICE_SIMD_X86) || defined(ICE_SIMD_NEON)
+
+// Lookup tables of the vectorized validation from "Validating UTF-8 In
+// Less Than One Instruction Per Byte" (Keiser, Lemire). Every byte is
+// classified by the high nibble of the previous byte, the low nibble of
+// the previous byte and its own high nibble. The error bits of the three
+// lookups only overlap for invalid two byte combinations. Invalid 3 and 4
+// byte sequences are found by checking where continuation bytes must be.
+#define ICE_UTF8_TOO_SHORT      (1 << 0)
+#define ICE_UTF8_TOO_LONG       (1 << 1)
+#define ICE_UTF8_OVERLONG_3     (1 << 2)
+#define ICE_UTF8_TOO_LARGE      (1 << 3)
+#define ICE_UTF8_SURROGATE      (1 << 4)
+#define ICE_UTF8_OVERLONG_2     (1 << 5)
+#define ICE_UTF8_TOO_LARGE_1000 (1 << 6)
+#define ICE_UTF8_OVERLONG_4     (1 << 6)
+#define ICE_UTF8_TWO_CONTS      (1 << 7)
+#define ICE_UTF8_CARRY          (ICE_UTF8_TOO_SHORT | ICE_UTF8_TOO_LONG | ICE_UTF8_TWO_CONTS)
+
+#define ICE_UTF8_BYTE_1_HIGH \
+    ICE_UTF8_TOO_LONG, ICE_UTF8_TOO_LONG, ICE_UTF8_TOO_LONG, ICE_UTF8_TOO_LONG, \
+    ICE_UTF8_TOO_LONG, ICE_UTF8_TOO_LONG, ICE_UTF8_TOO_LONG, ICE_UTF8_TOO_LONG, \
+    ICE_UTF8_TWO_CONTS, ICE_UTF8_TWO_CONTS, ICE_UTF8_TWO_CONTS, ICE_UTF8_TWO_CONTS, \
+    ICE_UTF8_TOO_SHORT | ICE_UTF8_OVERLONG_2, \
+    ICE_UTF8_TOO_SHORT, \
+    ICE_UTF8_TOO_SHORT | ICE_UTF8_OVERLONG_3 | ICE_UTF8_SURROGATE, \
+    ICE_UTF8_TOO_SHORT | ICE_UTF8_TOO_LARGE | ICE_UTF8_TOO_LARGE_1000 | ICE_UTF8_OVERLONG_4
+
+#define ICE_UTF8_BYTE_1_LOW \
+    ICE_UTF8_CARRY | ICE_UTF8_OVERLONG_3 | ICE_UTF8_OVERLONG_2 | ICE_UTF8_OVERLONG_4, \
+    ICE_UTF8_CARRY | ICE_UTF8_OVERLONG_2, \
+    ICE_UTF8_CARRY, \
+    ICE_UTF8_CARRY, \
+    ICE_UTF8_CARRY | ICE_UTF8_TOO_LARGE, \
+    ICE_UTF8_CARRY | ICE_UTF8_TOO_LARGE | ICE_UTF8_TOO_LARGE_1000, \
+    ICE_UTF8_CARRY | ICE_UTF8_TOO_LARGE | ICE_UTF8_TOO_LARGE_1000, \
+    ICE_UTF8_CARRY | ICE_UTF8_TOO_LARGE | ICE_UTF8_TOO_LARGE_1000, \
+    ICE_UTF8_CARRY | ICE_UTF8_TOO_LARGE | ICE_UTF8_TOO_LARGE_1000, \
+    ICE_UTF8_CARRY | ICE_UTF8_TOO_LARGE | ICE_UTF8_TOO_LARGE_1000, \
+    ICE_UTF8_CARRY | ICE_UTF8_TOO_LARGE | ICE_UTF8_TOO_LARGE_1000, \
+    ICE_UTF8_CARRY | ICE_UTF8_TOO_LARGE | ICE_UTF8_TOO_LARGE_1000, \
+    ICE_UTF8_CARRY | ICE_UTF8_TOO_LARGE | ICE_UTF8_TOO_LARGE_1000, \
+    ICE_UTF8_CARRY | ICE_UTF8_TOO_LARGE | ICE_UTF8_TOO_LARGE_1000 | ICE_UTF8_SURROGATE, \
+    ICE_UTF8_CARRY | ICE_UTF8_TOO_LARGE | ICE_UTF8_TOO_LARGE_1000, \
+    ICE_UTF8_CARRY | ICE_UTF8_TOO_LARGE | ICE_UTF8_TOO_LARGE_1000
+
+#define ICE_UTF8_BYTE_2_HIGH \
+    ICE_UTF8_TOO_SHORT, ICE_UTF8_TOO_SHORT, ICE_UTF8_TOO_SHORT, ICE_UTF8_TOO_SHORT, \
+    ICE_UTF8_TOO_SHORT, ICE_UTF8_TOO_SHORT, ICE_UTF8_TOO_SHORT, ICE_UTF8_TOO_SHORT, \
+    ICE_UTF8_TOO_LONG | ICE_UTF8_OVERLONG_2 | ICE_UTF8_TWO_CONTS | ICE_UTF8_OVERLONG_3 | ICE_UTF8_TOO_LARGE_1000 | ICE_UTF8_OVERLONG_4, \
+    ICE_UTF8_TOO_LONG | ICE_UTF8_OVERLONG_2 | ICE_UTF8_TWO_CONTS | ICE_UTF8_OVERLONG_3 | ICE_UTF8_TOO_LARGE, \
+    ICE_UTF8_TOO_LONG | ICE_UTF8_OVERLONG_2 | ICE_UTF8_TWO_CONTS | ICE_UTF8_SURROGATE | ICE_UTF8_TOO_LARGE, \
+    ICE_UTF8_TOO_LONG | ICE_UTF8_OVERLONG_2 | ICE_UTF8_TWO_CONTS | ICE_UTF8_SURROGATE | ICE_UTF8_TOO_LARGE, \
+    ICE_UTF8_TOO_SHORT, ICE_UTF8_TOO_SHORT, ICE_UTF8_TOO_SHORT, ICE_UTF8_TOO_SHORT
+
+static const uint8_t ice_utf8_byte_1_high[32] = {ICE_UTF8_BYTE_1_HIGH, ICE_UTF8_BYTE_1_HIGH};
+static const uint8_t ice_utf8_byte_1_low[32] = {ICE_UTF8_BYTE_1_LOW, ICE_UTF8_BYTE_1_LOW};
+static const uint8_t ice_utf8_byte_2_high[32] = {ICE_UTF8_BYTE_2_HIGH, ICE_UTF8_BYTE_2_HIGH};
+
+// A block is incomplete if one of its last bytes starts a sequence which
+// doesn't fit into the block
+static const uint8_t ice_utf8_max_value[32] = {
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0xf0 - 1, 0xe0 - 1, 0xc0 - 1
+};
+
+#endif
+
+#if defined(ICE_SIMD_X86)
+
+// --- AVX2 kernels
+
+ICE_TARGET_AVX2 static size_t ice_utf8_count_avx2(const char * s, size_t nb) {
+    // Signed compare: continuation bytes are -128..-65
+    const __m256i limit = _mm256_set1_epi8(-65);
+    const __m256i zero = _mm256_setzero_si256();
+    size_t count = 0;
+    size_t i = 0;
+    while (i + 32 <= nb) {
+        // The byte counters overflow after 255 blocks
+        size_t blocks = (nb - i) / 32;
+        blocks = blocks > 255 ? 255 : blocks;
+        __m256i acc = zero;
+        for (size_t b = 0; b < blocks; ++b, i += 32) {
+            const __m256i in = _mm256_loadu_si256((const __m256i *) (s + i));
+            acc = _mm256_sub_epi8(acc, _mm256_cmpgt_epi8(in, limit));
+        }
+        const __m256i sums = _mm256_sad_epu8(acc, zero);
+        count += (size_t) _mm256_extract_epi64(sums, 0) + (size_t) _mm256_extract_epi64(sums, 1)
+                 + (size_t) _mm256_extract_epi64(sums, 2) + (size_t) _mm256_extract_epi64(sums, 3);
+    }
+    return count + ice_utf8_count_scalar(s + i, nb - i);
+}
+
+ICE_TARGET_AVX2 static size_t ice_utf8_offset_avx2(const char * s, size_t nb, size_t k) {
+    const __m256i limit = _mm256_set1_epi8(-65);
+    size_t i = 0;
+    for (; i + 32 <= nb; i += 32) {
+        const __m256i in = _mm256_loadu_si256((const __m256i *) (s + i));
+        uint32_t mask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpgt_epi8(in, limit));
+        const size_t c = (size_t) __builtin_popcount(mask);
+        if (k < c) {
+            while (k--) {
+                mask &= mask - 1;
+            }
+            return i + (size_t) __builtin_ctz(mask);
+        }
+        k -= c;
+    }
+    return i + ice_utf8_offset_scalar(s + i, nb - i, k);
+}
+
+ICE_TARGET_AVX2 static inline __m256i ice_utf8_prev_avx2(__m256i in, __m256i prev_in, int n) {
+    // Shift in the last bytes of the previous block. alignr works per 128
+    // bit lane, so the lanes must be assembled first.
+    const __m256i carried = _mm256_permute2x128_si256(prev_in, in, 0x21);
+    switch (n) {
+        case 1: return _mm256_alignr_epi8(in, carried, 15);
+        case 2: return _mm256_alignr_epi8(in, carried, 14);
+        default: return _mm256_alignr_epi8(in, carried, 13);
+    }
+}
+
+ICE_TARGET_AVX2 static inline __m256i ice_utf8_lookup_avx2(__m256i table, __m256i nibbles) {
+    return _mm256_shuffle_epi8(table, nibbles);
+}
+
+ICE_TARGET_AVX2 static bool ice_utf8_valid_avx2(const char * s, size_t nb) {
+    const __m256i t1h = _mm256_loadu_si256((const __m256i *) ice_utf8_byte_1_high);
+    const __m256i t1l = _mm256_loadu_si256((const __m256i *) ice_utf8_byte_1_low);
+    const __m256i t2h = _mm256_loadu_si256((const __m256i *) ice_utf8_byte_2_high);
+    const __m256i max_value = _mm256_loadu_si256((const __m256i *) ice_utf8_max_value);
+    const __m256i low_nibble = _mm256_set1_epi8(0x0f);
+    const __m256i third = _mm256_set1_epi8((char) (0xe0 - 0x80));
+    const __m256i fourth = _mm256_set1_epi8((char) (0xf0 - 0x80));
+    const __m256i high_bit = _mm256_set1_epi8((char) 0x80);
+
+    __m256i error = _mm256_setzero_si256();
+    __m256i prev_in = _mm256_setzero_si256();
+    __m256i prev_incomplete = _mm256_setzero_si256();
+    // The zero padded tail also terminates a sequence truncated by the end
+    char tail[32] = {0};
+    size_t i = 0;
+    for (;;) {
+        __m256i in;
+        const bool last = i + 32 > nb;
+        if (last) {
+            memcpy(tail, s + i, nb - i);
+            in = _mm256_loadu_si256((const __m256i *) tail);
+        } else {
+            in = _mm256_loadu_si256((const __m256i *) (s + i));
+        }
+        if (_mm256_movemask_epi8(in) == 0) {
+            error = _mm256_or_si256(error, prev_incomplete);
+        } else {
+            const __m256i prev1 = ice_utf8_prev_avx2(in, prev_in, 1);
+            const __m256i b1h = ice_utf8_lookup_avx2(t1h, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), low_nibble));
+            const __m256i b1l = ice_utf8_lookup_avx2(t1l, _mm256_and_si256(prev1, low_nibble));
+            const __m256i b2h = ice_utf8_lookup_avx2(t2h, _mm256_and_si256(_mm256_srli_epi16(in, 4), low_nibble));
+            const __m256i special = _mm256_and_si256(_mm256_and_si256(b1h, b1l), b2h);
+            const __m256i is_third = _mm256_subs_epu8(ice_utf8_prev_avx2(in, prev_in, 2), third);
+            const __m256i is_fourth = _mm256_subs_epu8(ice_utf8_prev_avx2(in, prev_in, 3), fourth);
+            const __m256i must_cont = _mm256_and_si256(_mm256_or_si256(is_third, is_fourth), high_bit);
+            error = _mm256_or_si256(error, _mm256_xor_si256(must_cont, special));
+            prev_incomplete = _mm256_subs_epu8(in, max_value);
+        }
+        prev_in = in;
+        if (last) {
+            break;
+        }
+        i += 32;
+    }
+    return _mm256_testz_si256(error, error);
+}
+
+// Widens 32 bytes at a time while they are ASCII. Blocks starting with
+// ASCII are widened too to keep their ASCII prefix, the remaining
+// sequences are decoded alone.
+ICE_TARGET_AVX2 static size_t ice_utf8_to_utf32_avx2(const char * s, size_t nb, int32_t * dst, size_t * pCount) {
+    const unsigned char * p = (const unsigned char *) s;
+    size_t i = 0;
+    size_t k = 0;
+    // Every byte gives at most one codepoint, so k + 32 <= i + 32 <= nb
+    while (i + 32 <= nb) {
+        const __m256i in = _mm256_loadu_si256((const __m256i *) (p + i));
+        const uint32_t mask = (uint32_t) _mm256_movemask_epi8(in);
+        if ((mask & 1) == 0) {
+            for (size_t q = 0; q < 32; q += 8) {
+                const __m128i bytes = _mm_loadl_epi64((const __m128i *) (p + i + q));
+                _mm256_storeu_si256((__m256i *) (dst + k + q), _mm256_cvtepu8_epi32(bytes));
+            }
+        }
+        if (mask == 0) {
+            i += 32;
+            k += 32;
+            continue;
+        }
+        // Keep the widened ASCII prefix and decode the rest of the block
+        const size_t block_end = i + 32;
+        const size_t ascii = (size_t) __builtin_ctz(mask);
+        i += ascii;
+        k += ascii;
+        while (i < block_end) {
+            const size_t len = ice_utf8_decode_one(p + i, nb - i, dst + k);
+            if (len == 0) {
+                *pCount = k;
+                return i;
+            }
+            i += len;
+            k++;
+        }
+    }
+    size_t tail;
+    const size_t end = i + ice_utf8_to_utf32_scalar(s + i, nb - i, dst + k, &tail);
+    *pCount = k + tail;
+    return end;
+}
+
+// Narrows 16 codepoints at a time if they are all ASCII
+ICE_TARGET_AVX2 static size_t ice_utf32_to_utf8_avx2(const int32_t * src, size_t n, char * dst) {
+    const __m256i non_ascii = _mm256_set1_epi32((int32_t) 0xffffff80);
+    size_t nb = 0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m256i a = _mm256_loadu_si256((const __m256i *) (src + i));
+        const __m256i b = _mm256_loadu_si256((const __m256i *) (src + i + 8));
+        if (!_mm256_testz_si256(_mm256_or_si256(a, b), non_ascii)) {
+            nb += ice_utf32_to_utf8_scalar(src + i, 16, dst + nb);
+            continue;
+        }
+        // packus works per 128 bit lane, reorder the 64 bit halves to a0-7, b0-7
+        const __m256i words = _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), 0xd8);
+        const __m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+        _mm_storeu_si128((__m128i *) (dst + nb), bytes);
+        nb += 16;
+    }
+    return nb + ice_utf32_to_utf8_scalar(src + i, n - i, dst + nb);
+}
+
+// --- SSE4 kernels
+
+ICE_TARGET_SSE4 static size_t ice_utf8_count_sse4(const char * s, size_t nb) {
+    const __m128i limit = _mm_set1_epi8(-65);
+    const __m128i zero = _mm_setzero_si128();
+    size_t count = 0;
+    size_t i = 0;
+    while (i + 16 <= nb) {
+        size_t blocks = (nb - i) / 16;
+        blocks = blocks > 255 ? 255 : blocks;
+        __m128i acc = zero;
+        for (size_t b = 0; b < blocks; ++b, i += 16) {
+            const __m128i in = _mm_loadu_si128((const __m128i *) (s + i));
+            acc = _mm_sub_epi8(acc, _mm_cmpgt_epi8(in, limit));
+        }
+        const __m128i sums = _mm_sad_epu8(acc, zero);
+        count += (size_t) _mm_extract_epi64(sums, 0) + (size_t) _mm_extract_epi64(sums, 1);
+    }
+    return count + ice_utf8_count_scalar(s + i, nb - i);
+}
+
+ICE_TARGET_SSE4 static size_t ice_utf8_offset_sse4(const char * s, size_t nb, size_t k) {
+    const __m128i limit = _mm_set1_epi8(-65);
+    size_t i = 0;
+    for (; i + 16 <= nb; i += 16) {
+        const __m128i in = _mm_loadu_si128((const __m128i *) (s + i));
+        uint32_t mask = (uint32_t) _mm_movemask_epi8(_mm_cmpgt_epi8(in, limit));
+        const size_t c = (size_t) __builtin_popcount(mask);
+        if (k < c) {
+            while (k--) {
+                mask &= mask - 1;
+            }
+            return i + (size_t) __builtin_ctz(mask);
+        }
+        k -= c;
+    }
+    return i + ice_utf8_offset_scalar(s + i, nb - i, k);
+}
+
+ICE_TARGET_SSE4 static bool ice_utf8_valid_sse4(const char * s, size_t nb) {
+    const __m128i t1h = _mm_loadu_si128((const __m128i *) ice_utf8_byte_1_high);
+    const __m128i t1l = _mm_loadu_si128((const __m128i *) ice_utf8_byte_1_low);
+    const __m128i t2h = _mm_loadu_si128((const __m128i *) ice_utf8_byte_2_high);
+    const __m128i max_value = _mm_loadu_si128((const __m128i *) (ice_utf8_max_value + 16));
+    const __m128i low_nibble = _mm_set1_epi8(0x0f);
+    const __m128i third = _mm_set1_epi8((char) (0xe0 - 0x80));
+    const __m128i fourth = _mm_set1_epi8((char) (0xf0 - 0x80));
+    const __m128i high_bit = _mm_set1_epi8((char) 0x80);
+
+    __m128i error = _mm_setzero_si128();
+    __m128i prev_in = _mm_setzero_si128();
+    __m128i prev_incomplete = _mm_setzero_si128();
+    char tail[16] = {0};
+    size_t i = 0;
+    for (;;) {
+        __m128i in;
+        const bool last = i + 16 > nb;
+        if (last) {
+            memcpy(tail, s + i, nb - i);
+            in = _mm_loadu_si128((const __m128i *) tail);
+        } else {
+            in = _mm_loadu_si128((const __m128i *) (s + i));
+        }
+        if (_mm_movemask_epi8(in) == 0) {
+            error = _mm_or_si128(error, prev_incomplete);
+        } else {
+            const __m128i prev1 = _mm_alignr_epi8(in, prev_in, 15);
+            const __m128i b1h = _mm_shuffle_epi8(t1h, _mm_and_si128(_mm_srli_epi16(prev1, 4), low_nibble));
+            const __m128i b1l = _mm_shuffle_epi8(t1l, _mm_and_si128(prev1, low_nibble));
+            const __m128i b2h = _mm_shuffle_epi8(t2h, _mm_and_si128(_mm_srli_epi16(in, 4), low_nibble));
+            const __m128i special = _mm_and_si128(_mm_and_si128(b1h, b1l), b2h);
+            const __m128i is_third = _mm_subs_epu8(_mm_alignr_epi8(in, prev_in, 14), third);
+            const __m128i is_fourth = _mm_subs_epu8(_mm_alignr_epi8(in, prev_in, 13), fourth);
+            const __m128i must_cont = _mm_and_si128(_mm_or_si128(is_third, is_fourth), high_bit);
+            error = _mm_or_si128(error, _mm_xor_si128(must_cont, special));
+            prev_incomplete = _mm_subs_epu8(in, max_value);
+        }
+        prev_in = in;
+        if (last) {
+            break;
+        }
+        i += 16;
+    }
+    return _mm_testz_si128(error, error);
+}
+
+ICE_TARGET_SSE4 static size_t ice_utf8_to_utf32_sse4(const char * s, size_t nb, int32_t * dst, size_t * pCount) {
+    const unsigned char * p = (const unsigned char *) s;
+    size_t i = 0;
+    size_t k = 0;
+    while (i + 16 <= nb) {
+        const __m128i in = _mm_loadu_si128((const __m128i *) (p + i));
+        const uint32_t mask = (uint32_t) _mm_movemask_epi8(in);
+        if ((mask & 1) == 0) {
+            _mm_storeu_si128((__m128i *) (dst + k), _mm_cvtepu8_epi32(in));
+            _mm_storeu_si128((__m128i *) (dst + k + 4), _mm_cvtepu8_epi32(_mm_srli_si128(in, 4)));
+            _mm_storeu_si128((__m128i *) (dst + k + 8), _mm_cvtepu8_epi32(_mm_srli_si128(in, 8)));
+            _mm_storeu_si128((__m128i *) (dst + k + 12), _mm_cvtepu8_epi32(_mm_srli_si128(in, 12)));
+        }
+        if (mask == 0) {
+            i += 16;
+            k += 16;
+            continue;
+        }
+        // Keep the widened ASCII prefix and decode the rest of the block
+        const size_t block_end = i + 16;
+        const size_t ascii = (size_t) __builtin_ctz(mask);
+        i += ascii;
+        k += ascii;
+        while (i < block_end) {
+            const size_t len = ice_utf8_decode_one(p + i, nb - i, dst + k);
+            if (len == 0) {
+                *pCount = k;
+                return i;
+            }
+            i += len;
+            k++;
+        }
+    }
+    size_t tail;
+    const size_t end = i + ice_utf8_to_utf32_scalar(s + i, nb - i, dst + k, &tail);
+    *pCount = k + tail;
+    return end;
+}
+
+ICE_TARGET_SSE4 static size_t ice_utf32_to_utf8_sse4(const int32_t * src, size_t n, char * dst) {
+    const __m128i non_ascii = _mm_set1_epi32((int32_t) 0xffffff80);
+    size_t nb = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m128i a = _mm_loadu_si128((const __m128i *) (src + i));
+        const __m128i b = _mm_loadu_si128((const __m128i *) (src + i + 4));
+        if (!_mm_testz_si128(_mm_or_si128(a, b), non_ascii)) {
+            nb += ice_utf32_to_utf8_scalar(src + i, 8, dst + nb);
+            continue;
+        }
+        const __m128i words = _mm_packus_epi32(a, b);
+        _mm_storel_epi64((__m128i *) (dst + nb), _mm_packus_epi16(words, words));
+        nb += 8;
+    }
+    return nb + ice_utf32_to_utf8_scalar(src + i, n - i, dst + nb);
+}
+
+#elif defined(ICE_SIMD_NEON)
+
+// --- NEON kernels
+
+static size_t ice_utf8_count_neon(const char * s, size_t nb) {
+    const int8x16_t limit = vdupq_n_s8(-65);
+    size_t count = 0;
+    size_t i = 0;
+    while (i + 16 <= nb) {
+        size_t blocks = (nb - i) / 16;
+        blocks = blocks > 255 ? 255 : blocks;
+        uint8x16_t acc = vdupq_n_u8(0);
+        for (size_t b = 0; b < blocks; ++b, i += 16) {
+            const int8x16_t in = vld1q_s8((const int8_t *) (s + i));
+            acc = vsubq_u8(acc, vcgtq_s8(in, limit));
+        }
+        count += (size_t) vaddlvq_u8(acc);
+    }
+    return count + ice_utf8_count_scalar(s + i, nb - i);
+}
+
+static size_t ice_utf8_offset_neon(const char * s, size_t nb, size_t k) {
+    const int8x16_t limit = vdupq_n_s8(-65);
+    size_t i = 0;
+    for (; i + 16 <= nb; i += 16) {
+        const int8x16_t in = vld1q_s8((const int8_t *) (s + i));
+        const size_t c = (size_t) vaddlvq_u8(vandq_u8(vcgtq_s8(in, limit), vdupq_n_u8(1)));
+        if (k < c) {
+            return i + ice_utf8_offset_scalar(s + i, 16, k);
+        }
+        k -= c;
+    }
+    return i + ice_utf8_offset_scalar(s + i, nb - i, k);
+}
+
+static bool ice_utf8_valid_neon(const char * s, size_t nb) {
+    const uint8x16_t t1h = vld1q_u8(ice_utf8_byte_1_high);
+    const uint8x16_t t1l = vld1q_u8(ice_utf8_byte_1_low);
+    const uint8x16_t t2h = vld1q_u8(ice_utf8_byte_2_high);
+    const uint8x16_t max_value = vld1q_u8(ice_utf8_max_value + 16);
+    const uint8x16_t low_nibble = vdupq_n_u8(0x0f);
+    const uint8x16_t third = vdupq_n_u8(0xe0 - 0x80);
+    const uint8x16_t fourth = vdupq_n_u8(0xf0 - 0x80);
+    const uint8x16_t high_bit = vdupq_n_u8(0x80);
+
+    uint8x16_t error = vdupq_n_u8(0);
+    uint8x16_t prev_in = vdupq_n_u8(0);
+    uint8x16_t prev_incomplete = vdupq_n_u8(0);
+    uint8_t tail[16] = {0};
+    size_t i = 0;
+    for (;;) {
+        uint8x16_t in;
+        const bool last = i + 16 > nb;
+        if (last) {
+            memcpy(tail, s + i, nb - i);
+            in = vld1q_u8(tail);
+        } else {
+            in = vld1q_u8((const uint8_t *) (s + i));
+        }
+        if (vmaxvq_u8(in) < 0x80) {
+            error = vorrq_u8(error, prev_incomplete);
+        } else {
+            const uint8x16_t prev1 = vextq_u8(prev_in, in, 15);
+            const uint8x16_t b1h = vqtbl1q_u8(t1h, vshrq_n_u8(prev1, 4));
+            const uint8x16_t b1l = vqtbl1q_u8(t1l, vandq_u8(prev1, low_nibble));
+            const uint8x16_t b2h = vqtbl1q_u8(t2h, vshrq_n_u8(in, 4));
+            const uint8x16_t special = vandq_u8(vandq_u8(b1h, b1l), b2h);
+            const uint8x16_t is_third = vqsubq_u8(vextq_u8(prev_in, in, 14), third);
+            const uint8x16_t is_fourth = vqsubq_u8(vextq_u8(prev_in, in, 13), fourth);
+            const uint8x16_t must_cont = vandq_u8(vorrq_u8(is_third, is_fourth), high_bit);
+            error = vorrq_u8(error, veorq_u8(must_cont, special));
+            prev_incomplete = vqsubq_u8(in, max_value);
+        }
+        prev_in = in;
+        if (last) {
+            break;
+        }
+        i += 16;
+    }
+    return vmaxvq_u8(error) == 0;
+}
+
+static size_t ice_utf8_to_utf32_neon(const char * s, size_t nb, int32_t * dst, size_t * pCount) {
+    const unsigned char * p = (const unsigned char *) s;
+    size_t i = 0;
+    size_t k = 0;
+    while (i + 16 <= nb) {
+        const uint8x16_t in = vld1q_u8(p + i);
+        if (vmaxvq_u8(in) >= 0x80) {
+            const size_t block_end = i + 16;
+            while (i < block_end) {
+                const size_t len = ice_utf8_decode_one(p + i, nb - i, dst + k);
+                if (len == 0) {
+                    *pCount = k;
+                    return i;
+                }
+                i += len;
+                k++;
+            }
+            continue;
+        }
+        const uint16x8_t lo = vmovl_u8(vget_low_u8(in));
+        const uint16x8_t hi = vmovl_u8(vget_high_u8(in));
+        vst1q_u32((uint32_t *) (dst + k), vmovl_u16(vget_low_u16(lo)));
+        vst1q_u32((uint32_t *) (dst + k + 4), vmovl_u16(vget_high_u16(lo)));
+        vst1q_u32((uint32_t *) (dst + k + 8), vmovl_u16(vget_low_u16(hi)));
+        vst1q_u32((uint32_t *) (dst + k + 12), vmovl_u16(vget_high_u16(hi)));
+        i += 16;
+        k += 16;
+    }
+    size_t tail;
+    const size_t end = i + ice_utf8_to_utf32_scalar(s + i, nb - i, dst + k, &tail);
+    *pCount = k + tail;
+    return end;
+}
+
+static size_t ice_utf32_to_utf8_neon(const int32_t * src, size_t n, char * dst) {
+    size_t nb = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const uint32x4_t a = vld1q_u32((const uint32_t *) (src + i));
+        const uint32x4_t b = vld1q_u32((const uint32_t *) (src + i + 4));
+        // Negative codepoints are large as unsigned
+        if (vmaxvq_u32(vorrq_u32(a, b)) >= 0x80) {
+            nb += ice_utf32_to_utf8_scalar(src + i, 8, dst + nb);
+            continue;
+        }
+        const uint16x8_t words = vcombine_u16(vmovn_u32(a), vmovn_u32(b));
+        vst1_u8((uint8_t *) (dst + nb), vmovn_u16(words));
+        nb += 8;
+    }
+    return nb + ice_utf32_to_utf8_scalar(src + i, n - i, dst + nb);
+}
+
+#endif
+
+// --- Dispatch
+
+size_t ice_utf8_count(const char * s, size_t nb) {
+#if defined(ICE_SIMD_X86)
+    if (ice_cpu_has_avx2()) {
+        return ice_utf8_count_avx2(s, nb);
+    } else if (ice_cpu_has_sse4()) {
+        return ice_utf8_count_sse4(s, nb);
+    }
+#elif defined(ICE_SIMD_NEON)
+    return ice_utf8_count_neon(s, nb);
+#endif
+    return ice_utf8_count_scalar(s, nb);
+}
+
+size_t ice_utf8_offset(const char * s, size_t nb, size_t k) {
+#if defined(ICE_SIMD_X86)
+    if (ice_cpu_has_avx2()) {
+        return ice_utf8_offset_avx2(s, nb, k);
+    } else if (ice_cpu_has_sse4()) {
+        return ice_utf8_offset_sse4(s, nb, k);
+    }
+#elif defined(ICE_SIMD_NEON)
+    return ice_utf8_offset_neon(s, nb, k);
+#endif
+    return ice_utf8_offset_scalar(s, nb, k);
+}
+
+static bool ice_utf8_valid_kernel(const char * s, size_t nb) {
+#if defined(ICE_SIMD_X86)
+    if (ice_cpu_has_avx2()) {
+        return ice_utf8_valid_avx2(s, nb);
+    } else if (ice_cpu_has_sse4()) {
+        return ice_utf8_valid_sse4(s, nb);
+    }
+#elif defined(ICE_SIMD_NEON)
+    return ice_utf8_valid_neon(s, nb);
+#endif
+    return ice_utf8_error_offset_scalar(s, nb) == nb;
+}
+
+bool ice_utf8_valid(const char * s, size_t nb, size_t * pErrorOffset) {
+    if (ice_utf8_valid_kernel(s, nb)) {
+        return true;
+    }
+    // Invalid input is the exception, locate the error with the scalar code
+    if (pErrorOffset != NULL) {
+        *pErrorOffset = ice_utf8_error_offset_scalar(s, nb);
+    }
+    return false;
+}
+
+bool ice_utf8_to_utf32(const char * s, size_t nb, int32_t * dst, size_t * pCount, size_t * pErrorOffset) {
+    size_t end;
+#if defined(ICE_SIMD_X86)
+    if (ice_cpu_has_avx2()) {
+        end = ice_utf8_to_utf32_avx2(s, nb, dst, pCount);
+    } else if (ice_cpu_has_sse4()) {
+        end = ice_utf8_to_utf32_sse4(s, nb, dst, pCount);
+    } else {
+        end = ice_utf8_to_utf32_scalar(s, nb, dst, pCount);
+    }
+#elif defined(ICE_SIMD_NEON)
+    end = ice_utf8_to_utf32_neon(s, nb, dst, pCount);
+#else
+    end = ice_utf8_to_utf32_scalar(s, nb, dst, pCount);
+#endif
+    if (end == nb) {
+        return true;
+    }
+    if (pErrorOffset != NULL) {
+        *pErrorOffset = end;
+    }
+    return false;
+}
+
+bool ice_utf32_utf8_size(const int32_t * src, size_t n, size_t * pSize, size_t * pErrorIndex) {
+    // Branch free, so the loop vectorizes, the error is located afterwards
+    size_t size = 0;
+    uint32_t invalid = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const uint32_t c = (uint32_t) src[i];
+        invalid |= (c > 0x10ffff) | (c - 0xd800 < 0x800);
+        size += 1 + (c >= 0x80) + (c >= 0x800) + (c >= 0x10000);
+    }
+    if (!invalid) {
+        *pSize = size;
+        return true;
+    }
+    if (pErrorIndex != NULL) {
+        for (size_t i = 0; i < n; ++i) {
+            const uint32_t c = (uint32_t) src[i];
+            if (c > 0x10ffff || c - 0xd800 < 0x800) {
+                *pErrorIndex = i;
+                break;
+            }
+        }
+    }
+    return false;
+}
+
+size_t ice_utf32_to_utf8(const int32_t * src, size_t n, char * dst) {
+#if defined(ICE_SIMD_X86)
+    if (ice_cpu_has_avx2()) {
+        return ice_utf32_to_utf8_avx2(src, n, dst);
+    } else if (ice_cpu_has_sse4()) {
+        return ice_utf32_to_utf8_sse4(src, n, dst);
+    }
+#elif defined(ICE_SIMD_NEON)
+    return ice_utf32_to_utf8_neon(src, n, dst);
+#endif
+    return ice_utf32_to_utf8_scalar(src, n, dst);
+}
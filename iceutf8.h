@@ -0,0 +1,136 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+#ifndef IEW_C_ESSENTIALS_ICEUTF8_H
+#define IEW_C_ESSENTIALS_ICEUTF8_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * UTF-8 kernels working on nb bytes at s, the bytes don't need to be '\0'
+ * terminated. With IEW_ENABLE_SIMD the kernels use AVX2, SSE4 or NEON
+ * selected at runtime, otherwise they fall back to scalar code.
+ *
+ * ice_utf8_count and ice_utf8_offset expect valid UTF-8, they only look
+ * at the leading bytes of the codepoints.
+ */
+
+/**
+ * The number of codepoints, i.e. the number of bytes which aren't
+ * continuation bytes (0b10xxxxxx).
+ */
+size_t ice_utf8_count(const char * s, size_t nb);
+
+/**
+ * Byte offset of the codepoint with index k or nb if there are k or less
+ * codepoints.
+ */
+size_t ice_utf8_offset(const char * s, size_t nb, size_t k);
+
+/**
+ * Check if s is valid UTF-8. Overlong encodings, surrogates, codepoints
+ * above U+10FFFF and truncated sequences are invalid.
+ *
+ * @param pErrorOffset Set to the offset of the first invalid sequence if
+ * s is invalid, may be NULL
+ * @return true if s is valid UTF-8
+ */
+bool ice_utf8_valid(const char * s, size_t nb, size_t * pErrorOffset);
+
+/**
+ * Encode a valid codepoint into 1 to 4 bytes at dst.
+ *
+ * @return The number of bytes written
+ */
+static inline size_t ice_utf8_encode_rune(int32_t rune, char * dst) {
+    if (0 == (0xffffff80 & rune)) {
+        // 1-byte/7-bit ascii (0b0xxxxxxx)
+        dst[0] = (char) rune;
+        return 1;
+    } else if (0 == (0xfffff800 & rune)) {
+        // 2-byte/11-bit utf8 code point (0b110xxxxx 0b10xxxxxx)
+        dst[0] = (char) (0xc0 | (rune >> 6));
+        dst[1] = (char) (0x80 | (rune & 0x3f));
+        return 2;
+    } else if (0 == (0xffff0000 & rune)) {
+        // 3-byte/16-bit utf8 code point (0b1110xxxx 0b10xxxxxx 0b10xxxxxx)
+        dst[0] = (char) (0xe0 | (rune >> 12));
+        dst[1] = (char) (0x80 | ((rune >> 6) & 0x3f));
+        dst[2] = (char) (0x80 | (rune & 0x3f));
+        return 3;
+    } else {
+        // 4-byte/21-bit utf8 code point (0b11110xxx 0b10xxxxxx 0b10xxxxxx 0b10xxxxxx)
+        dst[0] = (char) (0xf0 | (rune >> 18));
+        dst[1] = (char) (0x80 | ((rune >> 12) & 0x3f));
+        dst[2] = (char) (0x80 | ((rune >> 6) & 0x3f));
+        dst[3] = (char) (0x80 | (rune & 0x3f));
+        return 4;
+    }
+}
+
+/**
+ * Decode UTF-8 to codepoints. ASCII runs are widened 16 or 32 bytes at a
+ * time.
+ *
+ * @param dst Room for nb codepoints
+ * @param pCount Set to the number of codepoints written, on error the
+ * codepoints before the invalid sequence
+ * @param pErrorOffset Set to the offset of the first invalid sequence if
+ * s is invalid, may be NULL
+ * @return true if s is valid UTF-8
+ */
+bool ice_utf8_to_utf32(const char * s, size_t nb, int32_t * dst, size_t * pCount, size_t * pErrorOffset);
+
+/**
+ * The number of bytes of the UTF-8 encoding of n codepoints.
+ *
+ * @param pErrorIndex Set to the index of the first negative, surrogate or
+ * above U+10FFFF codepoint if there is one, may be NULL
+ * @return true if all codepoints can be encoded
+ */
+bool ice_utf32_utf8_size(const int32_t * src, size_t n, size_t * pSize, size_t * pErrorIndex);
+
+/**
+ * Encode n codepoints checked by ice_utf32_utf8_size. ASCII runs are
+ * narrowed 8 or 16 codepoints at a time.
+ *
+ * @param dst Room for the size returned by ice_utf32_utf8_size
+ * @return The number of bytes written
+ */
+size_t ice_utf32_to_utf8(const int32_t * src, size_t n, char * dst);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //IEW_C_ESSENTIALS_ICEUTF8_H
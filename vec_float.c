@@ -26,5 +26,406 @@
  */
 
 #include "vec_float.h"
+#include "ice_cpu.h"
+#include "ice_sort.h"
 
 makeVecOfTypeImpl(float, float)
+makeVecSortedImpl(float, float, VEC_DEFAULT_LESS)
+makeHeapOfTypeImpl(float, float, VEC_DEFAULT_LESS)
+
+// --- Scalar kernels
+
+static size_t vec_float_find_scalar(const float * data, size_t n, float val) {
+    for (size_t i = 0; i < n; ++i) {
+        if (data[i] == val) {
+            return i;
+        }
+    }
+    return n;
+}
+
+static size_t vec_float_count_scalar(const float * data, size_t n, float val) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        count += (data[i] == val);
+    }
+    return count;
+}
+
+static float vec_float_min_scalar(const float * data, size_t n, float res) {
+    for (size_t i = 0; i < n; ++i) {
+        res = data[i] < res ? data[i] : res;
+    }
+    return res;
+}
+
+static float vec_float_max_scalar(const float * data, size_t n, float res) {
+    for (size_t i = 0; i < n; ++i) {
+        res = data[i] > res ? data[i] : res;
+    }
+    return res;
+}
+
+static float vec_float_sum_scalar(const float * data, size_t n) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        sum += data[i];
+    }
+    return sum;
+}
+
+static float vec_float_dot_scalar(const float * a, const float * b, size_t n) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+#if defined(ICE_SIMD_X86)
+
+// --- AVX2 kernels
+
+ICE_TARGET_AVX2 static size_t vec_float_find_avx2(const float * data, size_t n, float val) {
+    const __m256 needle = _mm256_set1_ps(val);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const int mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(data + i), needle, _CMP_EQ_OQ));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + vec_float_find_scalar(data + i, n - i, val);
+}
+
+ICE_TARGET_AVX2 static size_t vec_float_count_avx2(const float * data, size_t n, float val) {
+    const __m256 needle = _mm256_set1_ps(val);
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 eq = _mm256_cmp_ps(_mm256_loadu_ps(data + i), needle, _CMP_EQ_OQ);
+        acc = _mm256_sub_epi32(acc, _mm256_castps_si256(eq));
+    }
+    uint32_t lanes[8];
+    _mm256_storeu_si256((__m256i *) lanes, acc);
+    size_t count = 0;
+    for (int l = 0; l < 8; ++l) {
+        count += lanes[l];
+    }
+    return count + vec_float_count_scalar(data + i, n - i, val);
+}
+
+ICE_TARGET_AVX2 static float vec_float_min_avx2(const float * data, size_t n) {
+    __m256 acc = _mm256_set1_ps(data[0]);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc = _mm256_min_ps(acc, _mm256_loadu_ps(data + i));
+    }
+    float lanes[8];
+    _mm256_storeu_ps(lanes, acc);
+    return vec_float_min_scalar(data + i, n - i, vec_float_min_scalar(lanes, 8, lanes[0]));
+}
+
+ICE_TARGET_AVX2 static float vec_float_max_avx2(const float * data, size_t n) {
+    __m256 acc = _mm256_set1_ps(data[0]);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc = _mm256_max_ps(acc, _mm256_loadu_ps(data + i));
+    }
+    float lanes[8];
+    _mm256_storeu_ps(lanes, acc);
+    return vec_float_max_scalar(data + i, n - i, vec_float_max_scalar(lanes, 8, lanes[0]));
+}
+
+ICE_TARGET_AVX2 static float vec_float_sum_avx2(const float * data, size_t n) {
+    __m256 acc = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc = _mm256_add_ps(acc, _mm256_loadu_ps(data + i));
+    }
+    float lanes[8];
+    _mm256_storeu_ps(lanes, acc);
+    return vec_float_sum_scalar(lanes, 8) + vec_float_sum_scalar(data + i, n - i);
+}
+
+ICE_TARGET_AVX2 static float vec_float_dot_avx2(const float * a, const float * b, size_t n) {
+    __m256 acc = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+    float lanes[8];
+    _mm256_storeu_ps(lanes, acc);
+    return vec_float_sum_scalar(lanes, 8) + vec_float_dot_scalar(a + i, b + i, n - i);
+}
+
+// --- SSE4 kernels
+
+ICE_TARGET_SSE4 static size_t vec_float_find_sse4(const float * data, size_t n, float val) {
+    const __m128 needle = _mm_set1_ps(val);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const int mask = _mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(data + i), needle));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + vec_float_find_scalar(data + i, n - i, val);
+}
+
+ICE_TARGET_SSE4 static size_t vec_float_count_sse4(const float * data, size_t n, float val) {
+    const __m128 needle = _mm_set1_ps(val);
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128 eq = _mm_cmpeq_ps(_mm_loadu_ps(data + i), needle);
+        acc = _mm_sub_epi32(acc, _mm_castps_si128(eq));
+    }
+    uint32_t lanes[4];
+    _mm_storeu_si128((__m128i *) lanes, acc);
+    return (size_t) lanes[0] + lanes[1] + lanes[2] + lanes[3] + vec_float_count_scalar(data + i, n - i, val);
+}
+
+ICE_TARGET_SSE4 static float vec_float_min_sse4(const float * data, size_t n) {
+    __m128 acc = _mm_set1_ps(data[0]);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc = _mm_min_ps(acc, _mm_loadu_ps(data + i));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    return vec_float_min_scalar(data + i, n - i, vec_float_min_scalar(lanes, 4, lanes[0]));
+}
+
+ICE_TARGET_SSE4 static float vec_float_max_sse4(const float * data, size_t n) {
+    __m128 acc = _mm_set1_ps(data[0]);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc = _mm_max_ps(acc, _mm_loadu_ps(data + i));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    return vec_float_max_scalar(data + i, n - i, vec_float_max_scalar(lanes, 4, lanes[0]));
+}
+
+ICE_TARGET_SSE4 static float vec_float_sum_sse4(const float * data, size_t n) {
+    __m128 acc = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc = _mm_add_ps(acc, _mm_loadu_ps(data + i));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    return vec_float_sum_scalar(lanes, 4) + vec_float_sum_scalar(data + i, n - i);
+}
+
+ICE_TARGET_SSE4 static float vec_float_dot_sse4(const float * a, const float * b, size_t n) {
+    __m128 acc = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    return vec_float_sum_scalar(lanes, 4) + vec_float_dot_scalar(a + i, b + i, n - i);
+}
+
+#elif defined(ICE_SIMD_NEON)
+
+// --- NEON kernels
+
+static size_t vec_float_find_neon(const float * data, size_t n, float val) {
+    const float32x4_t needle = vdupq_n_f32(val);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        if (vmaxvq_u32(vceqq_f32(vld1q_f32(data + i), needle)) != 0) {
+            break;
+        }
+    }
+    return i + vec_float_find_scalar(data + i, n - i, val);
+}
+
+static size_t vec_float_count_neon(const float * data, size_t n, float val) {
+    const float32x4_t needle = vdupq_n_f32(val);
+    uint32x4_t acc = vdupq_n_u32(0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc = vsubq_u32(acc, vceqq_f32(vld1q_f32(data + i), needle));
+    }
+    return (size_t) vaddlvq_u32(acc) + vec_float_count_scalar(data + i, n - i, val);
+}
+
+static float vec_float_min_neon(const float * data, size_t n) {
+    float32x4_t acc = vdupq_n_f32(data[0]);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc = vminq_f32(acc, vld1q_f32(data + i));
+    }
+    return vec_float_min_scalar(data + i, n - i, vminvq_f32(acc));
+}
+
+static float vec_float_max_neon(const float * data, size_t n) {
+    float32x4_t acc = vdupq_n_f32(data[0]);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc = vmaxq_f32(acc, vld1q_f32(data + i));
+    }
+    return vec_float_max_scalar(data + i, n - i, vmaxvq_f32(acc));
+}
+
+static float vec_float_sum_neon(const float * data, size_t n) {
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc = vaddq_f32(acc, vld1q_f32(data + i));
+    }
+    return vaddvq_f32(acc) + vec_float_sum_scalar(data + i, n - i);
+}
+
+static float vec_float_dot_neon(const float * a, const float * b, size_t n) {
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc = vfmaq_f32(acc, vld1q_f32(a + i), vld1q_f32(b + i));
+    }
+    return vaddvq_f32(acc) + vec_float_dot_scalar(a + i, b + i, n - i);
+}
+
+#endif
+
+// --- Dispatch
+
+size_t vec_float_find(vec_float v, float val) {
+#if defined(ICE_SIMD_X86)
+    if (ice_cpu_has_avx2()) {
+        return vec_float_find_avx2(v->data, v->len, val);
+    } else if (ice_cpu_has_sse4()) {
+        return vec_float_find_sse4(v->data, v->len, val);
+    }
+#elif defined(ICE_SIMD_NEON)
+    return vec_float_find_neon(v->data, v->len, val);
+#endif
+    return vec_float_find_scalar(v->data, v->len, val);
+}
+
+size_t vec_float_count(vec_float v, float val) {
+#if defined(ICE_SIMD_X86)
+    if (ice_cpu_has_avx2()) {
+        return vec_float_count_avx2(v->data, v->len, val);
+    } else if (ice_cpu_has_sse4()) {
+        return vec_float_count_sse4(v->data, v->len, val);
+    }
+#elif defined(ICE_SIMD_NEON)
+    return vec_float_count_neon(v->data, v->len, val);
+#endif
+    return vec_float_count_scalar(v->data, v->len, val);
+}
+
+col_error_t vec_float_min(vec_float v, float * res) {
+    if (v->len <= 0) {
+        return COL_ERR_UNDERFLOW;
+    }
+#if defined(ICE_SIMD_X86)
+    if (ice_cpu_has_avx2()) {
+        *res = vec_float_min_avx2(v->data, v->len);
+        return COL_OK;
+    } else if (ice_cpu_has_sse4()) {
+        *res = vec_float_min_sse4(v->data, v->len);
+        return COL_OK;
+    }
+#elif defined(ICE_SIMD_NEON)
+    *res = vec_float_min_neon(v->data, v->len);
+    return COL_OK;
+#endif
+    *res = vec_float_min_scalar(v->data, v->len, v->data[0]);
+    return COL_OK;
+}
+
+col_error_t vec_float_max(vec_float v, float * res) {
+    if (v->len <= 0) {
+        return COL_ERR_UNDERFLOW;
+    }
+#if defined(ICE_SIMD_X86)
+    if (ice_cpu_has_avx2()) {
+        *res = vec_float_max_avx2(v->data, v->len);
+        return COL_OK;
+    } else if (ice_cpu_has_sse4()) {
+        *res = vec_float_max_sse4(v->data, v->len);
+        return COL_OK;
+    }
+#elif defined(ICE_SIMD_NEON)
+    *res = vec_float_max_neon(v->data, v->len);
+    return COL_OK;
+#endif
+    *res = vec_float_max_scalar(v->data, v->len, v->data[0]);
+    return COL_OK;
+}
+
+float vec_float_sum(vec_float v) {
+#if defined(ICE_SIMD_X86)
+    if (ice_cpu_has_avx2()) {
+        return vec_float_sum_avx2(v->data, v->len);
+    } else if (ice_cpu_has_sse4()) {
+        return vec_float_sum_sse4(v->data, v->len);
+    }
+#elif defined(ICE_SIMD_NEON)
+    return vec_float_sum_neon(v->data, v->len);
+#endif
+    return vec_float_sum_scalar(v->data, v->len);
+}
+
+col_error_t vec_float_dot(vec_float a, vec_float b, float * res) {
+    if (a->len != b->len) {
+        return COL_ERR_ILLEGAL_ARGUMENT;
+    }
+#if defined(ICE_SIMD_X86)
+    if (ice_cpu_has_avx2()) {
+        *res = vec_float_dot_avx2(a->data, b->data, a->len);
+        return COL_OK;
+    } else if (ice_cpu_has_sse4()) {
+        *res = vec_float_dot_sse4(a->data, b->data, a->len);
+        return COL_OK;
+    }
+#elif defined(ICE_SIMD_NEON)
+    *res = vec_float_dot_neon(a->data, b->data, a->len);
+    return COL_OK;
+#endif
+    *res = vec_float_dot_scalar(a->data, b->data, a->len);
+    return COL_OK;
+}
+
+// --- Sort
+
+/*
+ * Maps the float bits onto unsigned integers with the same order:
+ * negative floats get all bits flipped (reverses their order), positive
+ * floats get the sign bit set (moves them above the negative ones).
+ */
+static inline void vec_float_to_sort_keys(float * data, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t bits;
+        memcpy(&bits, &data[i], sizeof(bits));
+        bits ^= (uint32_t) (-(int32_t) (bits >> 31)) | 0x80000000u;
+        memcpy(&data[i], &bits, sizeof(bits));
+    }
+}
+
+static inline void vec_float_from_sort_keys(float * data, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t bits;
+        memcpy(&bits, &data[i], sizeof(bits));
+        bits ^= ((bits >> 31) - 1) | 0x80000000u;
+        memcpy(&data[i], &bits, sizeof(bits));
+    }
+}
+
+col_error_t vec_float_sort(vec_float v) {
+    return vec_float_sort_kv(v, NULL, 0);
+}
+
+col_error_t vec_float_sort_kv(vec_float v, void * payload, size_t payload_size) {
+    vec_float_to_sort_keys(v->data, v->len);
+    const col_error_t err = ice_radix_sort_u32((uint32_t *) v->data, v->len, payload, payload_size);
+    vec_float_from_sort_keys(v->data, v->len);
+    return err;
+}
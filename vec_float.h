@@ -35,6 +35,61 @@ extern "C" {
 #include "vec_macros.h"
 
 makeVecOfTypeApi(float, float)
+makeVecSortedApi(float, float)
+makeHeapOfTypeApi(float, float)
+
+/**
+ * The following functions are SIMD kernels selected by runtime CPU
+ * dispatch (AVX2, SSE4, NEON or a scalar fallback). Results for vectors
+ * containing NaN values are unspecified.
+ */
+
+/**
+ * Index of the first element equal to val or vec_float_len(v) if
+ * there is no such element.
+ */
+size_t vec_float_find(vec_float v, float val);
+
+/**
+ * Number of elements equal to val.
+ */
+size_t vec_float_count(vec_float v, float val);
+
+/**
+ * Smallest element of v. Returns COL_ERR_UNDERFLOW if v is empty.
+ */
+col_error_t vec_float_min(vec_float v, float* res);
+
+/**
+ * Largest element of v. Returns COL_ERR_UNDERFLOW if v is empty.
+ */
+col_error_t vec_float_max(vec_float v, float* res);
+
+/**
+ * Sum of all elements. Elements are summed in several lanes so the
+ * rounding might differ from a sequential sum.
+ */
+float vec_float_sum(vec_float v);
+
+/**
+ * Dot product of a and b. Returns COL_ERR_ILLEGAL_ARGUMENT if a and b
+ * have different lengths.
+ */
+col_error_t vec_float_dot(vec_float a, vec_float b, float* res);
+
+/**
+ * Sort the vector ascending using a LSD radix sort. Negative zero is
+ * ordered before positive zero. Large vectors are sorted by several
+ * threads, see ice_sort.h.
+ */
+col_error_t vec_float_sort(vec_float v);
+
+/**
+ * Sort the vector ascending and permute a parallel payload the same way.
+ * payload points to vec_float_len(v) elements of payload_size bytes, e.g.
+ * vec_uintptr_data(values). Elements with equal keys keep their order.
+ */
+col_error_t vec_float_sort_kv(vec_float v, void* payload, size_t payload_size);
 
 #ifdef __cplusplus
 };
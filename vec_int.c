@@ -26,5 +26,340 @@
  */
 
 #include "vec_int.h"
+#include "ice_cpu.h"
+#include "ice_sort.h"
 
 makeVecOfTypeImpl(int, int)
+makeVecSortedImpl(int, int, VEC_DEFAULT_LESS)
+makeHeapOfTypeImpl(int, int, VEC_DEFAULT_LESS)
+makeDequeOfTypeImpl(int, int)
+
+// --- Scalar kernels
+
+static size_t vec_int_find_scalar(const int * data, size_t n, int val) {
+    for (size_t i = 0; i < n; ++i) {
+        if (data[i] == val) {
+            return i;
+        }
+    }
+    return n;
+}
+
+static size_t vec_int_count_scalar(const int * data, size_t n, int val) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        count += (data[i] == val);
+    }
+    return count;
+}
+
+static int vec_int_min_scalar(const int * data, size_t n, int res) {
+    for (size_t i = 0; i < n; ++i) {
+        res = data[i] < res ? data[i] : res;
+    }
+    return res;
+}
+
+static int vec_int_max_scalar(const int * data, size_t n, int res) {
+    for (size_t i = 0; i < n; ++i) {
+        res = data[i] > res ? data[i] : res;
+    }
+    return res;
+}
+
+static int64_t vec_int_sum_scalar(const int * data, size_t n) {
+    int64_t sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += data[i];
+    }
+    return sum;
+}
+
+#if defined(ICE_SIMD_X86)
+
+// --- AVX2 kernels
+
+ICE_TARGET_AVX2 static size_t vec_int_find_avx2(const int * data, size_t n, int val) {
+    const __m256i needle = _mm256_set1_epi32(val);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i x = _mm256_loadu_si256((const __m256i *) (data + i));
+        const int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(x, needle)));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + vec_int_find_scalar(data + i, n - i, val);
+}
+
+ICE_TARGET_AVX2 static size_t vec_int_count_avx2(const int * data, size_t n, int val) {
+    const __m256i needle = _mm256_set1_epi32(val);
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i x = _mm256_loadu_si256((const __m256i *) (data + i));
+        // A match is -1, subtracting it counts up
+        acc = _mm256_sub_epi32(acc, _mm256_cmpeq_epi32(x, needle));
+    }
+    uint32_t lanes[8];
+    _mm256_storeu_si256((__m256i *) lanes, acc);
+    size_t count = 0;
+    for (int l = 0; l < 8; ++l) {
+        count += lanes[l];
+    }
+    return count + vec_int_count_scalar(data + i, n - i, val);
+}
+
+ICE_TARGET_AVX2 static int vec_int_min_avx2(const int * data, size_t n) {
+    __m256i acc = _mm256_set1_epi32(data[0]);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc = _mm256_min_epi32(acc, _mm256_loadu_si256((const __m256i *) (data + i)));
+    }
+    int lanes[8];
+    _mm256_storeu_si256((__m256i *) lanes, acc);
+    return vec_int_min_scalar(data + i, n - i, vec_int_min_scalar(lanes, 8, lanes[0]));
+}
+
+ICE_TARGET_AVX2 static int vec_int_max_avx2(const int * data, size_t n) {
+    __m256i acc = _mm256_set1_epi32(data[0]);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc = _mm256_max_epi32(acc, _mm256_loadu_si256((const __m256i *) (data + i)));
+    }
+    int lanes[8];
+    _mm256_storeu_si256((__m256i *) lanes, acc);
+    return vec_int_max_scalar(data + i, n - i, vec_int_max_scalar(lanes, 8, lanes[0]));
+}
+
+ICE_TARGET_AVX2 static int64_t vec_int_sum_avx2(const int * data, size_t n) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i x = _mm256_loadu_si256((const __m256i *) (data + i));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(x)));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(x, 1)));
+    }
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i *) lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + vec_int_sum_scalar(data + i, n - i);
+}
+
+// --- SSE4 kernels
+
+ICE_TARGET_SSE4 static size_t vec_int_find_sse4(const int * data, size_t n, int val) {
+    const __m128i needle = _mm_set1_epi32(val);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128i x = _mm_loadu_si128((const __m128i *) (data + i));
+        const int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(x, needle)));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + vec_int_find_scalar(data + i, n - i, val);
+}
+
+ICE_TARGET_SSE4 static size_t vec_int_count_sse4(const int * data, size_t n, int val) {
+    const __m128i needle = _mm_set1_epi32(val);
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128i x = _mm_loadu_si128((const __m128i *) (data + i));
+        acc = _mm_sub_epi32(acc, _mm_cmpeq_epi32(x, needle));
+    }
+    uint32_t lanes[4];
+    _mm_storeu_si128((__m128i *) lanes, acc);
+    return (size_t) lanes[0] + lanes[1] + lanes[2] + lanes[3] + vec_int_count_scalar(data + i, n - i, val);
+}
+
+ICE_TARGET_SSE4 static int vec_int_min_sse4(const int * data, size_t n) {
+    __m128i acc = _mm_set1_epi32(data[0]);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc = _mm_min_epi32(acc, _mm_loadu_si128((const __m128i *) (data + i)));
+    }
+    int lanes[4];
+    _mm_storeu_si128((__m128i *) lanes, acc);
+    return vec_int_min_scalar(data + i, n - i, vec_int_min_scalar(lanes, 4, lanes[0]));
+}
+
+ICE_TARGET_SSE4 static int vec_int_max_sse4(const int * data, size_t n) {
+    __m128i acc = _mm_set1_epi32(data[0]);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc = _mm_max_epi32(acc, _mm_loadu_si128((const __m128i *) (data + i)));
+    }
+    int lanes[4];
+    _mm_storeu_si128((__m128i *) lanes, acc);
+    return vec_int_max_scalar(data + i, n - i, vec_int_max_scalar(lanes, 4, lanes[0]));
+}
+
+ICE_TARGET_SSE4 static int64_t vec_int_sum_sse4(const int * data, size_t n) {
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128i x = _mm_loadu_si128((const __m128i *) (data + i));
+        acc = _mm_add_epi64(acc, _mm_cvtepi32_epi64(x));
+        acc = _mm_add_epi64(acc, _mm_cvtepi32_epi64(_mm_unpackhi_epi64(x, x)));
+    }
+    int64_t lanes[2];
+    _mm_storeu_si128((__m128i *) lanes, acc);
+    return lanes[0] + lanes[1] + vec_int_sum_scalar(data + i, n - i);
+}
+
+#elif defined(ICE_SIMD_NEON)
+
+// --- NEON kernels
+
+static size_t vec_int_find_neon(const int * data, size_t n, int val) {
+    const int32x4_t needle = vdupq_n_s32(val);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        if (vmaxvq_u32(vceqq_s32(vld1q_s32(data + i), needle)) != 0) {
+            break;
+        }
+    }
+    return i + vec_int_find_scalar(data + i, n - i, val);
+}
+
+static size_t vec_int_count_neon(const int * data, size_t n, int val) {
+    const int32x4_t needle = vdupq_n_s32(val);
+    uint32x4_t acc = vdupq_n_u32(0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc = vsubq_u32(acc, vceqq_s32(vld1q_s32(data + i), needle));
+    }
+    return (size_t) vaddlvq_u32(acc) + vec_int_count_scalar(data + i, n - i, val);
+}
+
+static int vec_int_min_neon(const int * data, size_t n) {
+    int32x4_t acc = vdupq_n_s32(data[0]);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc = vminq_s32(acc, vld1q_s32(data + i));
+    }
+    return vec_int_min_scalar(data + i, n - i, vminvq_s32(acc));
+}
+
+static int vec_int_max_neon(const int * data, size_t n) {
+    int32x4_t acc = vdupq_n_s32(data[0]);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc = vmaxq_s32(acc, vld1q_s32(data + i));
+    }
+    return vec_int_max_scalar(data + i, n - i, vmaxvq_s32(acc));
+}
+
+static int64_t vec_int_sum_neon(const int * data, size_t n) {
+    int64x2_t acc = vdupq_n_s64(0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc = vpadalq_s32(acc, vld1q_s32(data + i));
+    }
+    return vaddvq_s64(acc) + vec_int_sum_scalar(data + i, n - i);
+}
+
+#endif
+
+// --- Dispatch
+
+size_t vec_int_find(vec_int v, int val) {
+#if defined(ICE_SIMD_X86)
+    if (ice_cpu_has_avx2()) {
+        return vec_int_find_avx2(v->data, v->len, val);
+    } else if (ice_cpu_has_sse4()) {
+        return vec_int_find_sse4(v->data, v->len, val);
+    }
+#elif defined(ICE_SIMD_NEON)
+    return vec_int_find_neon(v->data, v->len, val);
+#endif
+    return vec_int_find_scalar(v->data, v->len, val);
+}
+
+size_t vec_int_count(vec_int v, int val) {
+#if defined(ICE_SIMD_X86)
+    if (ice_cpu_has_avx2()) {
+        return vec_int_count_avx2(v->data, v->len, val);
+    } else if (ice_cpu_has_sse4()) {
+        return vec_int_count_sse4(v->data, v->len, val);
+    }
+#elif defined(ICE_SIMD_NEON)
+    return vec_int_count_neon(v->data, v->len, val);
+#endif
+    return vec_int_count_scalar(v->data, v->len, val);
+}
+
+col_error_t vec_int_min(vec_int v, int * res) {
+    if (v->len <= 0) {
+        return COL_ERR_UNDERFLOW;
+    }
+#if defined(ICE_SIMD_X86)
+    if (ice_cpu_has_avx2()) {
+        *res = vec_int_min_avx2(v->data, v->len);
+        return COL_OK;
+    } else if (ice_cpu_has_sse4()) {
+        *res = vec_int_min_sse4(v->data, v->len);
+        return COL_OK;
+    }
+#elif defined(ICE_SIMD_NEON)
+    *res = vec_int_min_neon(v->data, v->len);
+    return COL_OK;
+#endif
+    *res = vec_int_min_scalar(v->data, v->len, v->data[0]);
+    return COL_OK;
+}
+
+col_error_t vec_int_max(vec_int v, int * res) {
+    if (v->len <= 0) {
+        return COL_ERR_UNDERFLOW;
+    }
+#if defined(ICE_SIMD_X86)
+    if (ice_cpu_has_avx2()) {
+        *res = vec_int_max_avx2(v->data, v->len);
+        return COL_OK;
+    } else if (ice_cpu_has_sse4()) {
+        *res = vec_int_max_sse4(v->data, v->len);
+        return COL_OK;
+    }
+#elif defined(ICE_SIMD_NEON)
+    *res = vec_int_max_neon(v->data, v->len);
+    return COL_OK;
+#endif
+    *res = vec_int_max_scalar(v->data, v->len, v->data[0]);
+    return COL_OK;
+}
+
+int64_t vec_int_sum(vec_int v) {
+#if defined(ICE_SIMD_X86)
+    if (ice_cpu_has_avx2()) {
+        return vec_int_sum_avx2(v->data, v->len);
+    } else if (ice_cpu_has_sse4()) {
+        return vec_int_sum_sse4(v->data, v->len);
+    }
+#elif defined(ICE_SIMD_NEON)
+    return vec_int_sum_neon(v->data, v->len);
+#endif
+    return vec_int_sum_scalar(v->data, v->len);
+}
+
+// --- Sort
+
+// Flipping the sign bit maps the signed order onto the unsigned order
+#define VEC_INT_SORT_FLIP 0x80000000u
+
+col_error_t vec_int_sort(vec_int v) {
+    return vec_int_sort_kv(v, NULL, 0);
+}
+
+col_error_t vec_int_sort_kv(vec_int v, void * payload, size_t payload_size) {
+    uint32_t * keys = (uint32_t *) v->data;
+    for (size_t i = 0; i < v->len; ++i) {
+        keys[i] ^= VEC_INT_SORT_FLIP;
+    }
+    const col_error_t err = ice_radix_sort_u32(keys, v->len, payload, payload_size);
+    for (size_t i = 0; i < v->len; ++i) {
+        keys[i] ^= VEC_INT_SORT_FLIP;
+    }
+    return err;
+}
@@ -35,6 +35,54 @@ extern "C" {
 #include "vec_macros.h"
 
 makeVecOfTypeApi(int, int)
+makeVecSortedApi(int, int)
+makeHeapOfTypeApi(int, int)
+makeDequeOfTypeApi(int, int)
+
+/**
+ * The following functions are SIMD kernels selected by runtime CPU
+ * dispatch (AVX2, SSE4, NEON or a scalar fallback).
+ */
+
+/**
+ * Index of the first element equal to val or vec_int_len(v) if
+ * there is no such element.
+ */
+size_t vec_int_find(vec_int v, int val);
+
+/**
+ * Number of elements equal to val.
+ */
+size_t vec_int_count(vec_int v, int val);
+
+/**
+ * Smallest element of v. Returns COL_ERR_UNDERFLOW if v is empty.
+ */
+col_error_t vec_int_min(vec_int v, int* res);
+
+/**
+ * Largest element of v. Returns COL_ERR_UNDERFLOW if v is empty.
+ */
+col_error_t vec_int_max(vec_int v, int* res);
+
+/**
+ * Sum of all elements. Elements are widened to 64bit so the sum
+ * does not overflow.
+ */
+int64_t vec_int_sum(vec_int v);
+
+/**
+ * Sort the vector ascending using a LSD radix sort. Large vectors are
+ * sorted by several threads, see ice_sort.h.
+ */
+col_error_t vec_int_sort(vec_int v);
+
+/**
+ * Sort the vector ascending and permute a parallel payload the same way.
+ * payload points to vec_int_len(v) elements of payload_size bytes, e.g.
+ * vec_uintptr_data(values). Elements with equal keys keep their order.
+ */
+col_error_t vec_int_sort_kv(vec_int v, void* payload, size_t payload_size);
 
 #ifdef __cplusplus
 };
@@ -40,6 +40,7 @@ extern "C" {
 #include "col_error.h"
 #include "icemalloc.h"
 #include "icelogging.h"
+#include "ice_thread_pool.h"
 
 #define makeVecOfTypeApi(name, type) \
     typedef type* iter_##name;       \
@@ -53,6 +54,7 @@ extern "C" {
     typedef struct vec__##name* vec_##name; \
     typedef col_error_t (*PFN_vec_##name##_each)(vec_##name v, size_t i, void * pUserData); \
     typedef col_error_t (*PFN_vec_##name##_pred)(vec_##name v, size_t i, bool * pMatch, void * pUserData); \
+    typedef col_error_t (*PFN_vec_##name##_reduce)(vec_##name v, size_t first, size_t last, void * pPartial, void * pUserData); \
     vec_##name vec_##name##_new();   \
     void vec_##name##_free(vec_##name v);                                            \
     col_error_t vec_##name##_reserve(vec_##name v, size_t new_cap);                         \
@@ -74,7 +76,36 @@ extern "C" {
                                     size_t *pIndex,                                         \
                                     void * pUserData);                                      \
     iter_ ## name vec_ ## name ## _begin(vec_ ## name v ) ;                                 \
-    iter_ ## name vec_ ## name ## _end(vec_ ## name v ) ;
+    iter_ ## name vec_ ## name ## _end(vec_ ## name v ) ;                                   \
+    col_error_t vec_##name##_append(vec_##name v, type const* src, size_t n);               \
+    col_error_t vec_##name##_resize(vec_##name v, size_t n, type fill);                     \
+    col_error_t vec_##name##_erase_range(vec_##name v, size_t first, size_t last);          \
+    col_error_t vec_##name##_swap_remove(vec_##name v, size_t i);                           \
+    col_error_t vec_##name##_shrink_to_fit(vec_##name v);                                   \
+    col_error_t vec_##name##_parallel_each(vec_##name v, ice_thread_pool pool, size_t grain,   \
+                                           PFN_vec_##name##_each cb, void * pUserData);    \
+    col_error_t vec_##name##_parallel_reduce(vec_##name v, ice_thread_pool pool, size_t grain, \
+                                             void * pResult, size_t result_size,           \
+                                             PFN_vec_##name##_reduce reduce,               \
+                                             PFN_ice_parallel_combine combine,             \
+                                             void * pUserData);                            \
+    /* Unchecked element access. The index is only verified in debug builds. */              \
+    static inline type vec_##name##_at(vec_##name v, size_t i) {                            \
+        IVK_ASSERT(i < v->len, "index must be less than len")                               \
+        return v->data[i];                                                                  \
+    }                                                                                       \
+    /* Inlined push_back. Calls the out-of-line reserve only if the vector is full. */      \
+    static inline col_error_t vec_##name##_push_back_unchecked(vec_##name v, type val) {    \
+        if (v->len == v->cap) {                                                             \
+            col_error_t err = vec_##name##_reserve(v, v->len + 1);                          \
+            if (err != COL_OK) {                                                            \
+                return err;                                                                 \
+            }                                                                               \
+        }                                                                                   \
+        v->data[v->len++] = val;                                                            \
+        v->end = NULL;                                                                      \
+        return COL_OK;                                                                      \
+    }
 
 #define makeVecOfTypeImpl(name, type) \
 vec_##name vec_##name##_new() {          \
@@ -120,7 +151,7 @@ col_error_t vec_##name##_reserve(vec_##name v, size_t new_cap) { \
                                       \
     ltrace("[vec_reserve] - cur_cap=%ld, lim=%ld, new_cap=%ld, old_size_bytes=%ld, new_size_bytes=%ld", v->cap, v->len, new_cap, old_size_bytes, new_size_bytes); \
     ltrace("[vec_reserve] - currentCap=%d, len=%d, new cap=%d", v->cap, v->len, new_cap); \
-    void * data = ice_aligned_realloc(v->data, PTR_ALIGN, old_size_bytes, new_size_bytes);\
+    void * data = ice_aligned_realloc(v->data, CACHE_LINE_SIZE, old_size_bytes, new_size_bytes);\
                                          \
     if (data == NULL) {                  \
         return COL_ERR_BAD_ALLOC;        \
@@ -280,6 +311,787 @@ col_error_t vec_##name##_search(vec_##name v,                    \
     }                                 \
     *pIndex = v->len;                 \
     return err;                       \
+}                                     \
+                                      \
+col_error_t vec_##name##_append(vec_##name v, type const* src, size_t n) {                \
+    if (n == 0) {                     \
+        return COL_OK;                \
+    }                                 \
+    if (src == NULL || n > SIZE_MAX - v->len) {                  \
+        return COL_ERR_ILLEGAL_ARGUMENT;                         \
+    }                                 \
+    /* src may point into the vector, reserve can move the data */ \
+    const uintptr_t src_addr = (uintptr_t) src;                  \
+    const uintptr_t data_addr = (uintptr_t) v->data;             \
+    const bool aliased = v->len > 0 && src_addr >= data_addr     \
+                         && src_addr < data_addr + v->len * sizeof(type); \
+    col_error_t err = COL_OK;         \
+    if ((err = vec_##name##_reserve(v, v->len + n)) != COL_OK) { \
+        return err;                   \
+    }                                 \
+    if (aliased) {                    \
+        src = (type const*) ((uintptr_t) v->data + (src_addr - data_addr)); \
+    }                                 \
+    memcpy(v->data + v->len, src, n * sizeof(type));             \
+    v->len += n;                      \
+    v->end = NULL;                    \
+    return COL_OK;                    \
+}                                     \
+                                      \
+col_error_t vec_##name##_resize(vec_##name v, size_t n, type fill) {                      \
+    if (n > v->len) {                 \
+        col_error_t err = COL_OK;     \
+        if ((err = vec_##name##_reserve(v, n)) != COL_OK) {      \
+            return err;               \
+        }                             \
+        for (size_t i = v->len; i < n; ++i) {                    \
+            v->data[i] = fill;        \
+        }                             \
+    }                                 \
+    v->len = n;                       \
+    v->end = NULL;                    \
+    return COL_OK;                    \
+}                                     \
+                                      \
+col_error_t vec_##name##_erase_range(vec_##name v, size_t first, size_t last) {           \
+    if (first > last || last > v->len) {                         \
+        return COL_ERR_ILLEGAL_ARGUMENT;                         \
+    }                                 \
+    if (first == last) {              \
+        return COL_OK;                \
+    }                                 \
+    memmove(v->data + first, v->data + last, (v->len - last) * sizeof(type));          \
+    v->len -= (last - first);         \
+    v->end = NULL;                    \
+    return COL_OK;                    \
+}                                     \
+                                      \
+col_error_t vec_##name##_swap_remove(vec_##name v, size_t i) {                            \
+    if (i >= v->len) {                \
+        return COL_ERR_ILLEGAL_ARGUMENT;                         \
+    }                                 \
+    v->len --;                        \
+    v->data[i] = v->data[v->len];     \
+    v->end = NULL;                    \
+    return COL_OK;                    \
+}                                     \
+                                      \
+col_error_t vec_##name##_shrink_to_fit(vec_##name v) {                                    \
+    if (v->len == v->cap) {           \
+        return COL_OK;                \
+    }                                 \
+    type* data = NULL;                \
+    if (v->len > 0) {                 \
+        /* ice_aligned_realloc never shrinks, so copy into a block of exact size */      \
+        if ((data = ice_aligned_malloc(CACHE_LINE_SIZE, v->len * sizeof(type))) == NULL) {\
+            return COL_ERR_BAD_ALLOC; \
+        }                             \
+        memcpy(data, v->data, v->len * sizeof(type));            \
+    }                                 \
+    ice_aligned_free(v->data);        \
+    v->data = data;                   \
+    v->cap = v->len;                  \
+    v->begin = NULL;                  \
+    v->end = NULL;                    \
+    return COL_OK;                    \
+} \
+struct vec_##name##_parallel_ctx {    \
+    vec_##name v;                     \
+    PFN_vec_##name##_each each;       \
+    PFN_vec_##name##_reduce reduce;   \
+    void * pUserData;                 \
+};                                    \
+static col_error_t vec_##name##_parallel_each_chunk(size_t first, size_t last, size_t chunk, void * pArg) {      \
+    struct vec_##name##_parallel_ctx * ctx = (struct vec_##name##_parallel_ctx *) pArg;                        \
+    (void) chunk;                     \
+    col_error_t err = COL_OK;         \
+    for (size_t i = first; i < last; ++i) {                      \
+        if ((err = ctx->each(ctx->v, i, ctx->pUserData)) != COL_OK) {                                          \
+            return err;               \
+        }                             \
+    }                                 \
+    return COL_OK;                    \
+}                                     \
+static col_error_t vec_##name##_parallel_reduce_chunk(size_t first, size_t last, void * pPartial, void * pArg) { \
+    struct vec_##name##_parallel_ctx * ctx = (struct vec_##name##_parallel_ctx *) pArg;                        \
+    return ctx->reduce(ctx->v, first, last, pPartial, ctx->pUserData);                                         \
+}                                     \
+col_error_t vec_##name##_parallel_each(vec_##name v, ice_thread_pool pool, size_t grain,                         \
+                                       PFN_vec_##name##_each cb, void * pUserData) {                          \
+    struct vec_##name##_parallel_ctx ctx = {v, cb, NULL, pUserData};                                           \
+    return ice_thread_pool_parallel_for(pool, v->len, ice_parallel_grain(grain, sizeof(type)),                 \
+                                        vec_##name##_parallel_each_chunk, &ctx);                               \
+}                                     \
+col_error_t vec_##name##_parallel_reduce(vec_##name v, ice_thread_pool pool, size_t grain,                       \
+                                         void * pResult, size_t result_size,                                   \
+                                         PFN_vec_##name##_reduce reduce,                                       \
+                                         PFN_ice_parallel_combine combine,                                     \
+                                         void * pUserData) {                                                   \
+    struct vec_##name##_parallel_ctx ctx = {v, NULL, reduce, pUserData};                                       \
+    return ice_thread_pool_parallel_reduce(pool, v->len, ice_parallel_grain(grain, sizeof(type)),              \
+                                           pResult, result_size,                                               \
+                                           vec_##name##_parallel_reduce_chunk, combine, &ctx);                 \
+}
+
+/**
+ * Binary search on sorted vectors. Requires the vector api of the same
+ * name. fnLess(a, b) must return true if a is ordered before b and the
+ * vector must be sorted by fnLess, e.g. by vec_<name>_sort.
+ *
+ * vec_<name>_lower_bound returns the index of the first element not
+ * less than val, vec_<name>_upper_bound the index of the first element
+ * greater than val. Both return vec_<name>_len if there is no such
+ * element. The searches are branchless.
+ *
+ * For large read-mostly vectors vec_<name>_eytzinger copies the sorted
+ * vector into res using the cache friendly Eytzinger (BFS) layout.
+ * vec_<name>_eytzinger_lower_bound then returns the index in res of the
+ * first element not less than val or vec_<name>_len(res).
+ *
+ * https://algorithmica.org/en/eytzinger
+ */
+#define VEC_DEFAULT_LESS(a, b) ((a) < (b))
+
+#define makeVecSortedApi(name, type) \
+    size_t vec_##name##_lower_bound(vec_##name v, type val);                                \
+    size_t vec_##name##_upper_bound(vec_##name v, type val);                                \
+    bool vec_##name##_binary_search(vec_##name v, type val, size_t *pIndex);                \
+    col_error_t vec_##name##_eytzinger(vec_##name v, vec_##name res);                       \
+    size_t vec_##name##_eytzinger_lower_bound(vec_##name v, type val);
+
+#define makeVecSortedImpl(name, type, fnLess) \
+size_t vec_##name##_lower_bound(vec_##name v, type val) {         \
+    if (v->len == 0) {                \
+        return 0;                     \
+    }                                 \
+    const type* base = v->data;       \
+    size_t n = v->len;                \
+    while (n > 1) {                   \
+        const size_t half = n / 2;    \
+        base = fnLess(base[half], val) ? base + half : base;     \
+        n -= half;                    \
+    }                                 \
+    return (size_t) (base - v->data) + fnLess(*base, val);       \
+}                                     \
+                                      \
+size_t vec_##name##_upper_bound(vec_##name v, type val) {         \
+    if (v->len == 0) {                \
+        return 0;                     \
+    }                                 \
+    const type* base = v->data;       \
+    size_t n = v->len;                \
+    while (n > 1) {                   \
+        const size_t half = n / 2;    \
+        base = fnLess(val, base[half]) ? base : base + half;     \
+        n -= half;                    \
+    }                                 \
+    return (size_t) (base - v->data) + !fnLess(val, *base);      \
+}                                     \
+                                      \
+bool vec_##name##_binary_search(vec_##name v, type val, size_t *pIndex) {                 \
+    const size_t i = vec_##name##_lower_bound(v, val);           \
+    if (pIndex != NULL) {             \
+        *pIndex = i;                  \
+    }                                 \
+    return i < v->len && !fnLess(val, v->data[i]);               \
+}                                     \
+                                      \
+static size_t vec_##name##_eytzinger_fill(const type* src, type* dst, size_t i, size_t k, size_t n) { \
+    if (k <= n) {                     \
+        i = vec_##name##_eytzinger_fill(src, dst, i, 2 * k, n);  \
+        dst[k - 1] = src[i++];        \
+        i = vec_##name##_eytzinger_fill(src, dst, i, 2 * k + 1, n);                        \
+    }                                 \
+    return i;                         \
+}                                     \
+                                      \
+col_error_t vec_##name##_eytzinger(vec_##name v, vec_##name res) {                        \
+    if (v == res) {                   \
+        return COL_ERR_ILLEGAL_ARGUMENT;                         \
+    }                                 \
+    col_error_t err = COL_OK;         \
+    if ((err = vec_##name##_reserve(res, v->len)) != COL_OK) {   \
+        return err;                   \
+    }                                 \
+    vec_##name##_eytzinger_fill(v->data, res->data, 0, 1, v->len);                         \
+    res->len = v->len;                \
+    res->end = NULL;                  \
+    return COL_OK;                    \
+}                                     \
+                                      \
+size_t vec_##name##_eytzinger_lower_bound(vec_##name v, type val) {                       \
+    const size_t n = v->len;          \
+    size_t k = 1;                     \
+    while (k <= n) {                  \
+        /* The 16 descendants four levels down share one cache line for 4 byte types */    \
+        __builtin_prefetch(v->data + (16 * k - 1 < n ? 16 * k - 1 : 0));                   \
+        k = 2 * k + fnLess(v->data[k - 1], val);                 \
+    }                                 \
+    /* Strip the trailing right turns (1 bits) and the last left turn */                  \
+    k >>= __builtin_ffsll((long long) ~k);                       \
+    return k == 0 ? n : k - 1;        \
+}
+
+/**
+ * Macros to define double ended queues. A deque_<name> is a growable
+ * circular buffer with a power of two capacity. Pushing and popping at
+ * both ends is O(1) amortized, indexed access is O(1).
+ *
+ * Index 0 is the front. Element addresses change when the deque grows or
+ * is linearized.
+ *
+ * deque_<name>_begin and deque_<name>_end return plain element pointers
+ * like iter_<name>. They linearize the deque first, i.e. rotate the
+ * elements so they are contiguous, which is O(n) once after the deque
+ * wrapped around.
+ */
+#define makeDequeOfTypeApi(name, type) \
+    struct deque__##name {                                                                  \
+        size_t head;                                                                        \
+        size_t len;                                                                         \
+        size_t cap;                                                                         \
+        type* data;                                                                         \
+    };                                                                                      \
+    typedef struct deque__##name* deque_##name;                                             \
+    typedef col_error_t (*PFN_deque_##name##_each)(deque_##name d, size_t i, void * pUserData); \
+    deque_##name deque_##name##_new();                                                      \
+    void deque_##name##_free(deque_##name d);                                               \
+    col_error_t deque_##name##_reserve(deque_##name d, size_t new_cap);                     \
+    col_error_t deque_##name##_push_back(deque_##name d, type val);                         \
+    col_error_t deque_##name##_push_front(deque_##name d, type val);                        \
+    col_error_t deque_##name##_pop_back(deque_##name d, type* res);                         \
+    col_error_t deque_##name##_pop_front(deque_##name d, type* res);                        \
+    col_error_t deque_##name##_front(deque_##name d, type* res);                            \
+    col_error_t deque_##name##_back(deque_##name d, type* res);                             \
+    col_error_t deque_##name##_get(deque_##name d, size_t i, type* res);                    \
+    col_error_t deque_##name##_set(deque_##name d, size_t i, type val);                     \
+    size_t deque_##name##_len(deque_##name d);                                              \
+    int deque_##name##_empty(deque_##name d);                                               \
+    void deque_##name##_clear(deque_##name d);                                              \
+    col_error_t deque_##name##_each(deque_##name d, PFN_deque_##name##_each cb, void * pUserData); \
+    type* deque_##name##_linearize(deque_##name d);                                         \
+    type* deque_##name##_begin(deque_##name d);                                             \
+    type* deque_##name##_end(deque_##name d);                                               \
+    /* Unchecked element access. The index is only verified in debug builds. */              \
+    static inline type deque_##name##_at(deque_##name d, size_t i) {                        \
+        IVK_ASSERT(i < d->len, "index must be less than len")                               \
+        return d->data[(d->head + i) & (d->cap - 1)];                                       \
+    }
+
+#define makeDequeOfTypeImpl(name, type) \
+deque_##name deque_##name##_new() {                                                         \
+    deque_##name d = (deque_##name) ice_aligned_malloc(PTR_ALIGN, sizeof(struct deque__##name)); \
+    if (d) {                                                                                \
+        d->head = 0;                                                                        \
+        d->len = 0;                                                                         \
+        d->cap = 0;                                                                         \
+        d->data = NULL;                                                                     \
+    }                                                                                       \
+    return d;                                                                               \
+}                                                                                           \
+void deque_##name##_free(deque_##name d) {                                                  \
+    if (d) {                                                                                \
+        ice_aligned_free(d->data);                                                          \
+        ice_aligned_free(d);                                                                \
+    }                                                                                       \
+}                                                                                           \
+/* Copies the elements in order to a new block, afterwards head is 0 */                   \
+static col_error_t deque_##name##_realloc(deque_##name d, size_t new_cap) {                 \
+    type* data = (type*) ice_aligned_malloc(CACHE_LINE_SIZE, new_cap * sizeof(type));      \
+    if (data == NULL) {                                                                     \
+        return COL_ERR_BAD_ALLOC;                                                           \
+    }                                                                                       \
+    if (d->len > 0) {                                                                       \
+        const size_t first = d->cap - d->head < d->len ? d->cap - d->head : d->len;          \
+        memcpy(data, d->data + d->head, first * sizeof(type));                              \
+        memcpy(data + first, d->data, (d->len - first) * sizeof(type));                     \
+    }                                                                                       \
+    ice_aligned_free(d->data);                                                              \
+    d->data = data;                                                                         \
+    d->cap = new_cap;                                                                       \
+    d->head = 0;                                                                            \
+    return COL_OK;                                                                          \
+}                                                                                           \
+col_error_t deque_##name##_reserve(deque_##name d, size_t new_cap) {                        \
+    if (new_cap <= d->cap) {                                                                \
+        return COL_OK;                                                                      \
+    }                                                                                       \
+    if (new_cap > (SIZE_MAX >> 1) / sizeof(type)) {                                         \
+        return COL_ERR_BAD_ALLOC;                                                           \
+    }                                                                                       \
+    /* Power of two capacities turn the index wrap into a mask */                           \
+    size_t cap = d->cap < 8 ? 8 : d->cap;                                                   \
+    while (cap < new_cap) {                                                                 \
+        cap <<= 1;                                                                          \
+    }                                                                                       \
+    ltrace("[deque_reserve] - len=%ld, cap=%ld, new cap=%ld", d->len, d->cap, cap);        \
+    return deque_##name##_realloc(d, cap);                                                  \
+}                                                                                           \
+col_error_t deque_##name##_push_back(deque_##name d, type val) {                            \
+    col_error_t err = COL_OK;                                                               \
+    if (d->len == d->cap && (err = deque_##name##_reserve(d, d->len + 1)) != COL_OK) {      \
+        return err;                                                                         \
+    }                                                                                       \
+    d->data[(d->head + d->len) & (d->cap - 1)] = val;                                       \
+    d->len++;                                                                               \
+    return COL_OK;                                                                          \
+}                                                                                           \
+col_error_t deque_##name##_push_front(deque_##name d, type val) {                           \
+    col_error_t err = COL_OK;                                                               \
+    if (d->len == d->cap && (err = deque_##name##_reserve(d, d->len + 1)) != COL_OK) {      \
+        return err;                                                                         \
+    }                                                                                       \
+    d->head = (d->head - 1) & (d->cap - 1);                                                 \
+    d->data[d->head] = val;                                                                 \
+    d->len++;                                                                               \
+    return COL_OK;                                                                          \
+}                                                                                           \
+col_error_t deque_##name##_pop_back(deque_##name d, type* res) {                            \
+    if (d->len == 0) {                                                                      \
+        return COL_ERR_UNDERFLOW;                                                           \
+    }                                                                                       \
+    d->len--;                                                                               \
+    if (res != NULL) {                                                                      \
+        *res = d->data[(d->head + d->len) & (d->cap - 1)];                                  \
+    }                                                                                       \
+    return COL_OK;                                                                          \
+}                                                                                           \
+col_error_t deque_##name##_pop_front(deque_##name d, type* res) {                           \
+    if (d->len == 0) {                                                                      \
+        return COL_ERR_UNDERFLOW;                                                           \
+    }                                                                                       \
+    if (res != NULL) {                                                                      \
+        *res = d->data[d->head];                                                            \
+    }                                                                                       \
+    d->head = (d->head + 1) & (d->cap - 1);                                                 \
+    d->len--;                                                                               \
+    return COL_OK;                                                                          \
+}                                                                                           \
+col_error_t deque_##name##_front(deque_##name d, type* res) {                               \
+    if (d->len == 0) {                                                                      \
+        return COL_ERR_UNDERFLOW;                                                           \
+    }                                                                                       \
+    *res = d->data[d->head];                                                                \
+    return COL_OK;                                                                          \
+}                                                                                           \
+col_error_t deque_##name##_back(deque_##name d, type* res) {                                \
+    if (d->len == 0) {                                                                      \
+        return COL_ERR_UNDERFLOW;                                                           \
+    }                                                                                       \
+    *res = d->data[(d->head + d->len - 1) & (d->cap - 1)];                                  \
+    return COL_OK;                                                                          \
+}                                                                                           \
+col_error_t deque_##name##_get(deque_##name d, size_t i, type* res) {                       \
+    if (i >= d->len) {                                                                      \
+        return COL_ERR_ILLEGAL_ARGUMENT;                                                    \
+    }                                                                                       \
+    *res = d->data[(d->head + i) & (d->cap - 1)];                                           \
+    return COL_OK;                                                                          \
+}                                                                                           \
+col_error_t deque_##name##_set(deque_##name d, size_t i, type val) {                        \
+    if (i >= d->len) {                                                                      \
+        return COL_ERR_ILLEGAL_ARGUMENT;                                                    \
+    }                                                                                       \
+    d->data[(d->head + i) & (d->cap - 1)] = val;                                            \
+    return COL_OK;                                                                          \
+}                                                                                           \
+size_t deque_##name##_len(deque_##name d) {                                                 \
+    return d->len;                                                                          \
+}                                                                                           \
+int deque_##name##_empty(deque_##name d) {                                                  \
+    return d->len == 0;                                                                     \
+}                                                                                           \
+void deque_##name##_clear(deque_##name d) {                                                 \
+    d->head = 0;                                                                            \
+    d->len = 0;                                                                             \
+}                                                                                           \
+col_error_t deque_##name##_each(deque_##name d, PFN_deque_##name##_each cb, void * pUserData) { \
+    col_error_t err = COL_OK;                                                               \
+    for (size_t i = 0; i < d->len; ++i) {                                                   \
+        if ((err = cb(d, i, pUserData)) != COL_OK) {                                        \
+            return err;                                                                     \
+        }                                                                                   \
+    }                                                                                       \
+    return COL_OK;                                                                          \
+}                                                                                           \
+type* deque_##name##_linearize(deque_##name d) {                                            \
+    if (d->head + d->len <= d->cap) {                                                       \
+        return d->data + d->head;                                                           \
+    }                                                                                       \
+    /* The elements wrap around: the front part is at [head, cap), the                     \
+     * back part at [0, second). Park the smaller part in a temporary                       \
+     * block and move the larger one to its final place. */                                 \
+    const size_t first = d->cap - d->head;                                                  \
+    const size_t second = d->len - first;                                                   \
+    const size_t smaller = first < second ? first : second;                                 \
+    type* tmp = (type*) ice_aligned_malloc(PTR_ALIGN, smaller * sizeof(type));             \
+    if (tmp == NULL) {                                                                      \
+        return NULL;                                                                        \
+    }                                                                                       \
+    if (second <= first) {                                                                  \
+        memcpy(tmp, d->data, second * sizeof(type));                                        \
+        memmove(d->data, d->data + d->head, first * sizeof(type));                          \
+        memcpy(d->data + first, tmp, second * sizeof(type));                                \
+    } else {                                                                                \
+        memcpy(tmp, d->data + d->head, first * sizeof(type));                               \
+        memmove(d->data + first, d->data, second * sizeof(type));                           \
+        memcpy(d->data, tmp, first * sizeof(type));                                         \
+    }                                                                                       \
+    ice_aligned_free(tmp);                                                                  \
+    d->head = 0;                                                                            \
+    return d->data;                                                                         \
+}                                                                                           \
+type* deque_##name##_begin(deque_##name d) {                                                \
+    return deque_##name##_linearize(d);                                                     \
+}                                                                                           \
+type* deque_##name##_end(deque_##name d) {                                                  \
+    type* begin = deque_##name##_linearize(d);                                              \
+    return begin == NULL ? NULL : begin + d->len;                                           \
+}
+
+/**
+ * Macros to define priority queues on top of the vector of the same
+ * name, i.e. makeVecOfTypeApi(name, type) must be expanded before
+ * makeHeapOfTypeApi(name, type).
+ *
+ * fnHigher(a, b) returns true if a must leave the heap before b, so
+ * VEC_DEFAULT_LESS gives a min-heap.
+ *
+ * The arity is 2 (binary heap) or 4. A 4-ary heap is half as deep and
+ * the 4 children of a node usually share a cache line, which pays off
+ * for large heaps with many pops.
+ *
+ * Heaps created with heap_<name>_new_indexed hand out a handle for every
+ * pushed element. The handle identifies the element until it's popped or
+ * removed and allows to change its key or to remove it in O(log n).
+ * Handles of popped and removed elements are reused.
+ */
+#define ICE_HEAP_FREE ((size_t) 1 << (sizeof(size_t) * 8 - 1))
+#define ICE_HEAP_NO_HANDLE SIZE_MAX
+
+#define makeHeapOfTypeApi(name, type) \
+    struct heap__##name {                                                                   \
+        vec_##name v;                                                                       \
+        unsigned shift;                                                                     \
+        /* indexed heaps only */                                                            \
+        size_t* slot_handle;                                                                \
+        size_t* handle_slot;                                                                \
+        size_t handle_cap;                                                                  \
+        size_t handle_len;                                                                  \
+        size_t free_handle;                                                                 \
+    };                                                                                      \
+    typedef struct heap__##name* heap_##name;                                               \
+    heap_##name heap_##name##_new(unsigned arity);                                          \
+    heap_##name heap_##name##_new_indexed(unsigned arity);                                  \
+    void heap_##name##_free(heap_##name h);                                                 \
+    col_error_t heap_##name##_push(heap_##name h, type val, size_t* pHandle);               \
+    col_error_t heap_##name##_top(heap_##name h, type* res);                                \
+    col_error_t heap_##name##_pop(heap_##name h, type* res);                                \
+    col_error_t heap_##name##_heapify(heap_##name h, type const* src, size_t n);            \
+    col_error_t heap_##name##_get(heap_##name h, size_t handle, type* res);                 \
+    col_error_t heap_##name##_update(heap_##name h, size_t handle, type val);               \
+    col_error_t heap_##name##_decrease_key(heap_##name h, size_t handle, type val);         \
+    col_error_t heap_##name##_remove(heap_##name h, size_t handle, type* res);              \
+    bool heap_##name##_contains(heap_##name h, size_t handle);                              \
+    size_t heap_##name##_len(heap_##name h);                                                \
+    int heap_##name##_empty(heap_##name h);                                                 \
+    void heap_##name##_clear(heap_##name h);
+
+#define makeHeapOfTypeImpl(name, type, fnHigher) \
+static heap_##name heap_##name##_create(unsigned arity, bool indexed) {                     \
+    if (arity != 2 && arity != 4) {                                                         \
+        return NULL;                                                                        \
+    }                                                                                       \
+    heap_##name h = (heap_##name) ice_aligned_malloc(PTR_ALIGN, sizeof(struct heap__##name)); \
+    if (h == NULL) {                                                                        \
+        return NULL;                                                                        \
+    }                                                                                       \
+    if ((h->v = vec_##name##_new()) == NULL) {                                              \
+        ice_aligned_free(h);                                                                \
+        return NULL;                                                                        \
+    }                                                                                       \
+    h->shift = arity == 2 ? 1 : 2;                                                          \
+    h->slot_handle = NULL;                                                                  \
+    h->handle_slot = NULL;                                                                  \
+    h->handle_cap = indexed ? 0 : ICE_HEAP_NO_HANDLE;                                       \
+    h->handle_len = 0;                                                                      \
+    h->free_handle = ICE_HEAP_NO_HANDLE;                                                    \
+    return h;                                                                               \
+}                                                                                           \
+heap_##name heap_##name##_new(unsigned arity) {                                             \
+    return heap_##name##_create(arity, false);                                              \
+}                                                                                           \
+heap_##name heap_##name##_new_indexed(unsigned arity) {                                     \
+    return heap_##name##_create(arity, true);                                               \
+}                                                                                           \
+void heap_##name##_free(heap_##name h) {                                                    \
+    if (h) {                                                                                \
+        vec_##name##_free(h->v);                                                            \
+        ice_aligned_free(h->slot_handle);                                                   \
+        ice_aligned_free(h->handle_slot);                                                   \
+        ice_aligned_free(h);                                                                \
+    }                                                                                       \
+}                                                                                           \
+static inline bool heap_##name##_indexed(heap_##name h) {                                   \
+    return h->handle_cap != ICE_HEAP_NO_HANDLE;                                             \
+}                                                                                           \
+static inline void heap_##name##_place(heap_##name h, type* data, size_t i, type val, size_t handle) { \
+    data[i] = val;                                                                          \
+    if (handle != ICE_HEAP_NO_HANDLE) {                                                     \
+        h->slot_handle[i] = handle;                                                         \
+        h->handle_slot[handle] = i;                                                         \
+    }                                                                                       \
+}                                                                                           \
+/* The sift functions are instantiated for both arities, so the child loops are unrolled */ \
+static inline void heap_##name##_sift_up_n(heap_##name h, size_t i, const unsigned shift) { \
+    type* data = h->v->data;                                                                \
+    const type val = data[i];                                                               \
+    const size_t handle = heap_##name##_indexed(h) ? h->slot_handle[i] : ICE_HEAP_NO_HANDLE; \
+    while (i > 0) {                                                                         \
+        const size_t parent = (i - 1) >> shift;                                             \
+        if (!fnHigher(val, data[parent])) {                                                 \
+            break;                                                                          \
+        }                                                                                   \
+        heap_##name##_place(h, data, i, data[parent],                                       \
+                            handle != ICE_HEAP_NO_HANDLE ? h->slot_handle[parent] : handle);\
+        i = parent;                                                                         \
+    }                                                                                       \
+    heap_##name##_place(h, data, i, val, handle);                                           \
+}                                                                                           \
+static inline void heap_##name##_sift_down_n(heap_##name h, size_t i, const unsigned shift) { \
+    type* data = h->v->data;                                                                \
+    const size_t n = h->v->len;                                                             \
+    const size_t arity = (size_t) 1 << shift;                                               \
+    const type val = data[i];                                                               \
+    const size_t handle = heap_##name##_indexed(h) ? h->slot_handle[i] : ICE_HEAP_NO_HANDLE; \
+    const size_t top = i;                                                                   \
+    for (;;) {                                                                              \
+        const size_t first = (i << shift) + 1;                                              \
+        size_t best = first;                                                                \
+        if (first + arity <= n) {                                                           \
+            for (size_t c = 1; c < arity; ++c) {                                            \
+                best = fnHigher(data[first + c], data[best]) ? first + c : best;            \
+            }                                                                               \
+        } else if (first < n) {                                                             \
+            for (size_t c = first + 1; c < n; ++c) {                                        \
+                best = fnHigher(data[c], data[best]) ? c : best;                            \
+            }                                                                               \
+        } else {                                                                            \
+            break;                                                                          \
+        }                                                                                   \
+        heap_##name##_place(h, data, i, data[best],                                         \
+                            handle != ICE_HEAP_NO_HANDLE ? h->slot_handle[best] : handle);  \
+        i = best;                                                                           \
+    }                                                                                       \
+    /* Bottom-up: the hole moved down to a leaf without comparing with val.                 \
+     * val usually comes from the bottom, so it only moves up a little. */                  \
+    while (i > top) {                                                                       \
+        const size_t parent = (i - 1) >> shift;                                             \
+        if (!fnHigher(val, data[parent])) {                                                 \
+            break;                                                                          \
+        }                                                                                   \
+        heap_##name##_place(h, data, i, data[parent],                                       \
+                            handle != ICE_HEAP_NO_HANDLE ? h->slot_handle[parent] : handle);\
+        i = parent;                                                                         \
+    }                                                                                       \
+    heap_##name##_place(h, data, i, val, handle);                                           \
+}                                                                                           \
+static void heap_##name##_sift_up(heap_##name h, size_t i) {                                \
+    if (h->shift == 1) {                                                                    \
+        heap_##name##_sift_up_n(h, i, 1);                                                   \
+    } else {                                                                                \
+        heap_##name##_sift_up_n(h, i, 2);                                                   \
+    }                                                                                       \
+}                                                                                           \
+static void heap_##name##_sift_down(heap_##name h, size_t i) {                              \
+    if (h->shift == 1) {                                                                    \
+        heap_##name##_sift_down_n(h, i, 1);                                                 \
+    } else {                                                                                \
+        heap_##name##_sift_down_n(h, i, 2);                                                 \
+    }                                                                                       \
+}                                                                                           \
+/* Makes room for n elements in the handle tables of an indexed heap */                     \
+static col_error_t heap_##name##_reserve_handles(heap_##name h, size_t n) {                 \
+    if (n <= h->handle_cap) {                                                               \
+        return COL_OK;                                                                      \
+    }                                                                                       \
+    size_t cap = h->handle_cap < 8 ? 8 : h->handle_cap;                                     \
+    while (cap < n) {                                                                       \
+        cap *= 2;                                                                           \
+    }                                                                                       \
+    size_t* slot_handle = (size_t*) ice_aligned_realloc(h->slot_handle, PTR_ALIGN,          \
+                                                        h->handle_cap * sizeof(size_t),     \
+                                                        cap * sizeof(size_t));              \
+    if (slot_handle == NULL) {                                                              \
+        return COL_ERR_BAD_ALLOC;                                                           \
+    }                                                                                       \
+    h->slot_handle = slot_handle;                                                           \
+    size_t* handle_slot = (size_t*) ice_aligned_realloc(h->handle_slot, PTR_ALIGN,          \
+                                                        h->handle_cap * sizeof(size_t),     \
+                                                        cap * sizeof(size_t));              \
+    if (handle_slot == NULL) {                                                              \
+        /* slot_handle already has the new capacity, that's harmless */                     \
+        return COL_ERR_BAD_ALLOC;                                                           \
+    }                                                                                       \
+    h->handle_slot = handle_slot;                                                           \
+    h->handle_cap = cap;                                                                    \
+    return COL_OK;                                                                          \
+}                                                                                           \
+static size_t heap_##name##_alloc_handle(heap_##name h) {                                   \
+    size_t handle = h->free_handle;                                                         \
+    if (handle != ICE_HEAP_NO_HANDLE) {                                                     \
+        const size_t next = h->handle_slot[handle] & ~ICE_HEAP_FREE;                        \
+        h->free_handle = next == (ICE_HEAP_NO_HANDLE & ~ICE_HEAP_FREE) ? ICE_HEAP_NO_HANDLE : next; \
+        return handle;                                                                      \
+    }                                                                                       \
+    return h->handle_len++;                                                                 \
+}                                                                                           \
+static void heap_##name##_release_handle(heap_##name h, size_t handle) {                    \
+    h->handle_slot[handle] = ICE_HEAP_FREE | h->free_handle;                                \
+    h->free_handle = handle;                                                                \
+}                                                                                           \
+col_error_t heap_##name##_push(heap_##name h, type val, size_t* pHandle) {                  \
+    col_error_t err = COL_OK;                                                               \
+    size_t handle = ICE_HEAP_NO_HANDLE;                                                     \
+    if (heap_##name##_indexed(h)) {                                                         \
+        /* handles are at most as many as elements ever held at once */                     \
+        if ((err = heap_##name##_reserve_handles(h, h->v->len + 1)) != COL_OK) {            \
+            return err;                                                                     \
+        }                                                                                   \
+        handle = heap_##name##_alloc_handle(h);                                             \
+    }                                                                                       \
+    if ((err = vec_##name##_push_back_unchecked(h->v, val)) != COL_OK) {                    \
+        if (handle != ICE_HEAP_NO_HANDLE) {                                                 \
+            heap_##name##_release_handle(h, handle);                                        \
+        }                                                                                   \
+        return err;                                                                         \
+    }                                                                                       \
+    if (handle != ICE_HEAP_NO_HANDLE) {                                                     \
+        h->slot_handle[h->v->len - 1] = handle;                                             \
+    }                                                                                       \
+    heap_##name##_sift_up(h, h->v->len - 1);                                                \
+    if (pHandle != NULL) {                                                                  \
+        *pHandle = handle;                                                                  \
+    }                                                                                       \
+    return COL_OK;                                                                          \
+}                                                                                           \
+col_error_t heap_##name##_top(heap_##name h, type* res) {                                   \
+    if (h->v->len == 0) {                                                                   \
+        return COL_ERR_UNDERFLOW;                                                           \
+    }                                                                                       \
+    *res = h->v->data[0];                                                                   \
+    return COL_OK;                                                                          \
+}                                                                                           \
+/* Removes the element in slot i and restores the heap order */                             \
+static void heap_##name##_remove_at(heap_##name h, size_t i, type* res) {                   \
+    type* data = h->v->data;                                                                \
+    const size_t last = h->v->len - 1;                                                      \
+    if (res != NULL) {                                                                      \
+        *res = data[i];                                                                     \
+    }                                                                                       \
+    if (heap_##name##_indexed(h)) {                                                         \
+        heap_##name##_release_handle(h, h->slot_handle[i]);                                 \
+        h->slot_handle[i] = h->slot_handle[last];                                           \
+    }                                                                                       \
+    data[i] = data[last];                                                                   \
+    vec_##name##_pop_back(h->v, NULL);                                                      \
+    if (i == last) {                                                                        \
+        return;                                                                             \
+    }                                                                                       \
+    if (i > 0 && fnHigher(data[i], data[(i - 1) >> h->shift])) {                            \
+        heap_##name##_sift_up(h, i);                                                        \
+    } else {                                                                                \
+        heap_##name##_sift_down(h, i);                                                      \
+    }                                                                                       \
+}                                                                                           \
+col_error_t heap_##name##_pop(heap_##name h, type* res) {                                   \
+    if (h->v->len == 0) {                                                                   \
+        return COL_ERR_UNDERFLOW;                                                           \
+    }                                                                                       \
+    heap_##name##_remove_at(h, 0, res);                                                     \
+    return COL_OK;                                                                          \
+}                                                                                           \
+col_error_t heap_##name##_heapify(heap_##name h, type const* src, size_t n) {               \
+    col_error_t err = COL_OK;                                                               \
+    heap_##name##_clear(h);                                                                 \
+    if ((err = vec_##name##_append(h->v, src, n)) != COL_OK) {                              \
+        return err;                                                                         \
+    }                                                                                       \
+    if (heap_##name##_indexed(h)) {                                                         \
+        if ((err = heap_##name##_reserve_handles(h, n)) != COL_OK) {                        \
+            vec_##name##_clear(h->v);                                                       \
+            return err;                                                                     \
+        }                                                                                   \
+        /* element src[i] gets handle i */                                                  \
+        for (size_t i = 0; i < n; ++i) {                                                    \
+            h->slot_handle[i] = i;                                                          \
+            h->handle_slot[i] = i;                                                          \
+        }                                                                                   \
+        h->handle_len = n;                                                                  \
+    }                                                                                       \
+    /* Floyd's bottom up construction, O(n) */                                              \
+    for (size_t i = n > 1 ? ((n - 2) >> h->shift) + 1 : 0; i > 0; --i) {                     \
+        heap_##name##_sift_down(h, i - 1);                                                  \
+    }                                                                                       \
+    return COL_OK;                                                                          \
+}                                                                                           \
+bool heap_##name##_contains(heap_##name h, size_t handle) {                                 \
+    return heap_##name##_indexed(h) && handle < h->handle_len                               \
+           && (h->handle_slot[handle] & ICE_HEAP_FREE) == 0;                                \
+}                                                                                           \
+col_error_t heap_##name##_get(heap_##name h, size_t handle, type* res) {                    \
+    if (!heap_##name##_contains(h, handle)) {                                               \
+        return COL_ERR_ILLEGAL_ARGUMENT;                                                    \
+    }                                                                                       \
+    *res = h->v->data[h->handle_slot[handle]];                                              \
+    return COL_OK;                                                                          \
+}                                                                                           \
+col_error_t heap_##name##_update(heap_##name h, size_t handle, type val) {                  \
+    if (!heap_##name##_contains(h, handle)) {                                               \
+        return COL_ERR_ILLEGAL_ARGUMENT;                                                    \
+    }                                                                                       \
+    const size_t i = h->handle_slot[handle];                                                \
+    const bool up = fnHigher(val, h->v->data[i]);                                           \
+    h->v->data[i] = val;                                                                    \
+    if (up) {                                                                               \
+        heap_##name##_sift_up(h, i);                                                        \
+    } else {                                                                                \
+        heap_##name##_sift_down(h, i);                                                      \
+    }                                                                                       \
+    return COL_OK;                                                                          \
+}                                                                                           \
+col_error_t heap_##name##_decrease_key(heap_##name h, size_t handle, type val) {            \
+    if (!heap_##name##_contains(h, handle)) {                                               \
+        return COL_ERR_ILLEGAL_ARGUMENT;                                                    \
+    }                                                                                       \
+    const size_t i = h->handle_slot[handle];                                                \
+    if (fnHigher(h->v->data[i], val)) {                                                     \
+        /* val would move the element away from the top */                                  \
+        return COL_ERR_ILLEGAL_ARGUMENT;                                                    \
+    }                                                                                       \
+    h->v->data[i] = val;                                                                    \
+    heap_##name##_sift_up(h, i);                                                            \
+    return COL_OK;                                                                          \
+}                                                                                           \
+col_error_t heap_##name##_remove(heap_##name h, size_t handle, type* res) {                 \
+    if (!heap_##name##_contains(h, handle)) {                                               \
+        return COL_ERR_ILLEGAL_ARGUMENT;                                                    \
+    }                                                                                       \
+    heap_##name##_remove_at(h, h->handle_slot[handle], res);                                \
+    return COL_OK;                                                                          \
+}                                                                                           \
+size_t heap_##name##_len(heap_##name h) {                                                   \
+    return h->v->len;                                                                       \
+}                                                                                           \
+int heap_##name##_empty(heap_##name h) {                                                    \
+    return h->v->len == 0;                                                                  \
+}                                                                                           \
+void heap_##name##_clear(heap_##name h) {                                                   \
+    vec_##name##_clear(h->v);                                                               \
+    if (heap_##name##_indexed(h)) {                                                         \
+        h->handle_len = 0;                                                                  \
+        h->free_handle = ICE_HEAP_NO_HANDLE;                                                \
+    }                                                                                       \
 }
 
 #ifdef __cplusplus
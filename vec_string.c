@@ -28,3 +28,194 @@
 #include "vec_string.h"
 
 makeVecOfTypeImpl(string, const char*)
+
+strvec strvec_new() {
+    strvec v = ice_malloc_ptr_aligned(sizeof(struct strvec_T));
+    if (v == NULL) {
+        return NULL;
+    }
+    v->bytes = NULL;
+    v->nbytes = 0;
+    v->bytes_cap = 0;
+    v->len = 0;
+    v->cap = 0;
+    // offsets[len] always exists
+    if ((v->offsets = ice_malloc_ptr_aligned(sizeof(size_t))) == NULL) {
+        ice_aligned_free(v);
+        return NULL;
+    }
+    v->offsets[0] = 0;
+    return v;
+}
+
+void strvec_free(strvec v) {
+    if (v != NULL) {
+        ice_aligned_free(v->bytes);
+        ice_aligned_free(v->offsets);
+        ice_aligned_free(v);
+    }
+}
+
+// Grow to exactly cap strings and bytes_cap bytes
+static col_error_t strvec_grow(strvec v, size_t cap, size_t bytes_cap) {
+    if (cap > v->cap) {
+        if (cap >= SIZE_MAX / sizeof(size_t)) {
+            return COL_ERR_BAD_ALLOC;
+        }
+        size_t * offsets = ice_aligned_realloc(v->offsets, PTR_ALIGN, (v->cap + 1) * sizeof(size_t),
+                                               (cap + 1) * sizeof(size_t));
+        if (offsets == NULL) {
+            return COL_ERR_BAD_ALLOC;
+        }
+        v->offsets = offsets;
+        v->cap = cap;
+    }
+    if (bytes_cap > v->bytes_cap) {
+        char * bytes = ice_aligned_realloc(v->bytes, PTR_ALIGN, v->bytes_cap, bytes_cap);
+        if (bytes == NULL) {
+            return COL_ERR_BAD_ALLOC;
+        }
+        v->bytes = bytes;
+        v->bytes_cap = bytes_cap;
+    }
+    return COL_OK;
+}
+
+col_error_t strvec_reserve(strvec v, size_t n, size_t nbytes) {
+    if (nbytes > SIZE_MAX - n) {
+        return COL_ERR_BAD_ALLOC;
+    }
+    return strvec_grow(v, n, nbytes + n);
+}
+
+col_error_t strvec_push_n(strvec v, const char * s, size_t nb) {
+    if (nb >= SIZE_MAX / 2 - v->nbytes) {
+        return COL_ERR_BAD_ALLOC;
+    }
+    const size_t nbytes = v->nbytes + nb + 1;
+    if (v->len == v->cap || nbytes > v->bytes_cap) {
+        // s may point into the arena which growing can move
+        const uintptr_t s_addr = (uintptr_t) s;
+        const uintptr_t bytes_addr = (uintptr_t) v->bytes;
+        const bool aliased = v->bytes != NULL && s_addr >= bytes_addr && s_addr < bytes_addr + v->nbytes;
+        col_error_t err;
+        const size_t cap = v->len == v->cap ? (size_t) ceil(VEC_GROWTH * (double) (v->len + 1)) : v->cap;
+        const size_t bytes_cap = nbytes > v->bytes_cap ? (size_t) ceil(VEC_GROWTH * (double) nbytes) : v->bytes_cap;
+        if ((err = strvec_grow(v, cap, bytes_cap)) != COL_OK) {
+            return err;
+        }
+        if (aliased) {
+            s = v->bytes + (s_addr - bytes_addr);
+        }
+    }
+    if (nb > 0) {
+        memcpy(v->bytes + v->nbytes, s, nb);
+    }
+    v->bytes[nbytes - 1] = '\0';
+    v->nbytes = nbytes;
+    v->offsets[++v->len] = nbytes;
+    return COL_OK;
+}
+
+col_error_t strvec_push(strvec v, const char * s) {
+    return strvec_push_n(v, s, s == NULL ? 0 : strlen(s));
+}
+
+col_error_t strvec_get(strvec v, size_t i, const char ** res) {
+    if (i >= v->len) {
+        return COL_ERR_ILLEGAL_ARGUMENT;
+    }
+    *res = strvec_at(v, i);
+    return COL_OK;
+}
+
+col_error_t strvec_get_view(strvec v, size_t i, ice_strview * res) {
+    if (i >= v->len) {
+        return COL_ERR_ILLEGAL_ARGUMENT;
+    }
+    *res = strvec_view_at(v, i);
+    return COL_OK;
+}
+
+size_t strvec_len(strvec v) {
+    return v->len;
+}
+
+void strvec_clear(strvec v) {
+    v->len = 0;
+    v->nbytes = 0;
+}
+
+// Sort key, the first 8 bytes big endian and zero padded decide most
+// comparisons without touching the arena.
+struct strvec_sort_key {
+    uint64_t prefix;
+    const char * ptr;
+    size_t nbytes;
+};
+
+static int strvec_sort_cmp(const void * a, const void * b) {
+    const struct strvec_sort_key * ka = a;
+    const struct strvec_sort_key * kb = b;
+    if (ka->prefix != kb->prefix) {
+        return ka->prefix < kb->prefix ? -1 : 1;
+    }
+    return strview_cmp(strview_of_n(ka->ptr, ka->nbytes), strview_of_n(kb->ptr, kb->nbytes));
+}
+
+col_error_t strvec_sort(strvec v) {
+    if (v->len < 2) {
+        return COL_OK;
+    }
+    struct strvec_sort_key * keys = ice_malloc_ptr_aligned(v->len * sizeof(struct strvec_sort_key));
+    char * bytes = ice_aligned_malloc(PTR_ALIGN, v->bytes_cap);
+    if (keys == NULL || bytes == NULL) {
+        ice_aligned_free(keys);
+        ice_aligned_free(bytes);
+        return COL_ERR_BAD_ALLOC;
+    }
+    for (size_t i = 0; i < v->len; ++i) {
+        const ice_strview s = strvec_view_at(v, i);
+        uint64_t prefix = 0;
+        for (size_t b = 0; b < 8; ++b) {
+            prefix = (prefix << 8) | (b < s.nbytes ? (unsigned char) s.ptr[b] : 0);
+        }
+        keys[i].prefix = prefix;
+        keys[i].ptr = s.ptr;
+        keys[i].nbytes = s.nbytes;
+    }
+    qsort(keys, v->len, sizeof(struct strvec_sort_key), strvec_sort_cmp);
+
+    size_t nbytes = 0;
+    for (size_t i = 0; i < v->len; ++i) {
+        memcpy(bytes + nbytes, keys[i].ptr, keys[i].nbytes + 1);
+        v->offsets[i] = nbytes;
+        nbytes += keys[i].nbytes + 1;
+    }
+    ice_aligned_free(keys);
+    ice_aligned_free(v->bytes);
+    v->bytes = bytes;
+    return COL_OK;
+}
+
+void strvec_dedupe(strvec v) {
+    if (v->len < 2) {
+        return;
+    }
+    // Compact in place, the write position never passes the read position
+    size_t len = 1;
+    size_t nbytes = v->offsets[1];
+    for (size_t i = 1; i < v->len; ++i) {
+        const ice_strview s = strvec_view_at(v, i);
+        const ice_strview last = strview_of_n(v->bytes + v->offsets[len - 1], nbytes - v->offsets[len - 1] - 1);
+        if (strview_eq(s, last)) {
+            continue;
+        }
+        memmove(v->bytes + nbytes, s.ptr, s.nbytes + 1);
+        v->offsets[len++] = nbytes;
+        nbytes += s.nbytes + 1;
+    }
+    v->len = len;
+    v->nbytes = nbytes;
+    v->offsets[len] = nbytes;
+}
@@ -32,12 +32,83 @@ extern "C" {
 #endif
 
 #include "vec_macros.h"
+#include "icestring.h"
 
 /**
  * Defines a vector of strings (char *).
  */
 makeVecOfTypeApi(string, const char*)
 
+/**
+ * An owning vector of strings. The bytes of all strings are packed into
+ * one growable arena, each string '\0' terminated, and an offsets array
+ * stores where string i starts. offsets[len] is the end of the last
+ * string. Pushing n strings needs a few reallocations of two blocks
+ * instead of n allocations, strvec_free releases everything at once.
+ *
+ * Pointers and views returned by the vector are valid until the next
+ * modification.
+ */
+typedef struct strvec_T {
+    char * bytes;
+    size_t nbytes;
+    size_t bytes_cap;
+    size_t * offsets;
+    size_t len;
+    size_t cap;
+} *strvec;
+
+strvec strvec_new();
+
+void strvec_free(strvec v);
+
+/**
+ * Reserve room for n strings with together nbytes bytes, not counting
+ * the '\0' bytes.
+ */
+col_error_t strvec_reserve(strvec v, size_t n, size_t nbytes);
+
+/**
+ * Append a copy of s. NULL is appended as empty string.
+ */
+col_error_t strvec_push(strvec v, const char * s);
+
+/**
+ * Append a copy of the first nb bytes of s.
+ */
+col_error_t strvec_push_n(strvec v, const char * s, size_t nb);
+
+col_error_t strvec_get(strvec v, size_t i, const char ** res);
+
+col_error_t strvec_get_view(strvec v, size_t i, ice_strview * res);
+
+size_t strvec_len(strvec v);
+
+void strvec_clear(strvec v);
+
+/**
+ * Sort the strings byte wise like strview_cmp and repack the arena in
+ * sorted order.
+ */
+col_error_t strvec_sort(strvec v);
+
+/**
+ * Remove consecutive equal strings, keeping the first one. Sort the
+ * vector first to remove all duplicates.
+ */
+void strvec_dedupe(strvec v);
+
+static inline const char * strvec_at(strvec v, size_t i) {
+    IVK_ASSERT(i < v->len, "index must be less than len")
+    return v->bytes + v->offsets[i];
+}
+
+static inline ice_strview strvec_view_at(strvec v, size_t i) {
+    IVK_ASSERT(i < v->len, "index must be less than len")
+    // Every string is followed by its '\0' byte
+    return strview_of_n(v->bytes + v->offsets[i], v->offsets[i + 1] - v->offsets[i] - 1);
+}
+
 #ifdef __cplusplus
 };
 #endif
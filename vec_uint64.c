@@ -26,5 +26,340 @@
  */
 
 #include "vec_uint64.h"
+#include "ice_cpu.h"
+#include "ice_sort.h"
 
 makeVecOfTypeImpl(uint64, uint64_t)
+makeVecSortedImpl(uint64, uint64_t, VEC_DEFAULT_LESS)
+makeHeapOfTypeImpl(uint64, uint64_t, VEC_DEFAULT_LESS)
+
+// --- Scalar kernels
+
+static size_t vec_uint64_find_scalar(const uint64_t * data, size_t n, uint64_t val) {
+    for (size_t i = 0; i < n; ++i) {
+        if (data[i] == val) {
+            return i;
+        }
+    }
+    return n;
+}
+
+static size_t vec_uint64_count_scalar(const uint64_t * data, size_t n, uint64_t val) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        count += (data[i] == val);
+    }
+    return count;
+}
+
+static uint64_t vec_uint64_min_scalar(const uint64_t * data, size_t n, uint64_t res) {
+    for (size_t i = 0; i < n; ++i) {
+        res = data[i] < res ? data[i] : res;
+    }
+    return res;
+}
+
+static uint64_t vec_uint64_max_scalar(const uint64_t * data, size_t n, uint64_t res) {
+    for (size_t i = 0; i < n; ++i) {
+        res = data[i] > res ? data[i] : res;
+    }
+    return res;
+}
+
+static uint64_t vec_uint64_sum_scalar(const uint64_t * data, size_t n) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += data[i];
+    }
+    return sum;
+}
+
+#if defined(ICE_SIMD_X86)
+
+// --- AVX2 kernels
+// There is no unsigned 64bit compare. Flipping the sign bit maps the
+// unsigned order onto the signed order used by cmpgt.
+
+ICE_TARGET_AVX2 static size_t vec_uint64_find_avx2(const uint64_t * data, size_t n, uint64_t val) {
+    const __m256i needle = _mm256_set1_epi64x((int64_t) val);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256i x = _mm256_loadu_si256((const __m256i *) (data + i));
+        const int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(x, needle)));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + vec_uint64_find_scalar(data + i, n - i, val);
+}
+
+ICE_TARGET_AVX2 static size_t vec_uint64_count_avx2(const uint64_t * data, size_t n, uint64_t val) {
+    const __m256i needle = _mm256_set1_epi64x((int64_t) val);
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256i x = _mm256_loadu_si256((const __m256i *) (data + i));
+        acc = _mm256_sub_epi64(acc, _mm256_cmpeq_epi64(x, needle));
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *) lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + vec_uint64_count_scalar(data + i, n - i, val);
+}
+
+ICE_TARGET_AVX2 static uint64_t vec_uint64_min_avx2(const uint64_t * data, size_t n) {
+    const __m256i bias = _mm256_set1_epi64x(INT64_MIN);
+    __m256i acc = _mm256_set1_epi64x((int64_t) data[0]);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256i x = _mm256_loadu_si256((const __m256i *) (data + i));
+        const __m256i gt = _mm256_cmpgt_epi64(_mm256_xor_si256(acc, bias), _mm256_xor_si256(x, bias));
+        acc = _mm256_blendv_epi8(acc, x, gt);
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *) lanes, acc);
+    return vec_uint64_min_scalar(data + i, n - i, vec_uint64_min_scalar(lanes, 4, lanes[0]));
+}
+
+ICE_TARGET_AVX2 static uint64_t vec_uint64_max_avx2(const uint64_t * data, size_t n) {
+    const __m256i bias = _mm256_set1_epi64x(INT64_MIN);
+    __m256i acc = _mm256_set1_epi64x((int64_t) data[0]);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256i x = _mm256_loadu_si256((const __m256i *) (data + i));
+        const __m256i gt = _mm256_cmpgt_epi64(_mm256_xor_si256(x, bias), _mm256_xor_si256(acc, bias));
+        acc = _mm256_blendv_epi8(acc, x, gt);
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *) lanes, acc);
+    return vec_uint64_max_scalar(data + i, n - i, vec_uint64_max_scalar(lanes, 4, lanes[0]));
+}
+
+ICE_TARGET_AVX2 static uint64_t vec_uint64_sum_avx2(const uint64_t * data, size_t n) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc = _mm256_add_epi64(acc, _mm256_loadu_si256((const __m256i *) (data + i)));
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *) lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + vec_uint64_sum_scalar(data + i, n - i);
+}
+
+// --- SSE4 kernels
+
+ICE_TARGET_SSE4 static size_t vec_uint64_find_sse4(const uint64_t * data, size_t n, uint64_t val) {
+    const __m128i needle = _mm_set1_epi64x((int64_t) val);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const __m128i x = _mm_loadu_si128((const __m128i *) (data + i));
+        const int mask = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(x, needle)));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + vec_uint64_find_scalar(data + i, n - i, val);
+}
+
+ICE_TARGET_SSE4 static size_t vec_uint64_count_sse4(const uint64_t * data, size_t n, uint64_t val) {
+    const __m128i needle = _mm_set1_epi64x((int64_t) val);
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const __m128i x = _mm_loadu_si128((const __m128i *) (data + i));
+        acc = _mm_sub_epi64(acc, _mm_cmpeq_epi64(x, needle));
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *) lanes, acc);
+    return lanes[0] + lanes[1] + vec_uint64_count_scalar(data + i, n - i, val);
+}
+
+ICE_TARGET_SSE4 static uint64_t vec_uint64_min_sse4(const uint64_t * data, size_t n) {
+    const __m128i bias = _mm_set1_epi64x(INT64_MIN);
+    __m128i acc = _mm_set1_epi64x((int64_t) data[0]);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const __m128i x = _mm_loadu_si128((const __m128i *) (data + i));
+        const __m128i gt = _mm_cmpgt_epi64(_mm_xor_si128(acc, bias), _mm_xor_si128(x, bias));
+        acc = _mm_blendv_epi8(acc, x, gt);
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *) lanes, acc);
+    return vec_uint64_min_scalar(data + i, n - i, vec_uint64_min_scalar(lanes, 2, lanes[0]));
+}
+
+ICE_TARGET_SSE4 static uint64_t vec_uint64_max_sse4(const uint64_t * data, size_t n) {
+    const __m128i bias = _mm_set1_epi64x(INT64_MIN);
+    __m128i acc = _mm_set1_epi64x((int64_t) data[0]);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const __m128i x = _mm_loadu_si128((const __m128i *) (data + i));
+        const __m128i gt = _mm_cmpgt_epi64(_mm_xor_si128(x, bias), _mm_xor_si128(acc, bias));
+        acc = _mm_blendv_epi8(acc, x, gt);
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *) lanes, acc);
+    return vec_uint64_max_scalar(data + i, n - i, vec_uint64_max_scalar(lanes, 2, lanes[0]));
+}
+
+ICE_TARGET_SSE4 static uint64_t vec_uint64_sum_sse4(const uint64_t * data, size_t n) {
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        acc = _mm_add_epi64(acc, _mm_loadu_si128((const __m128i *) (data + i)));
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *) lanes, acc);
+    return lanes[0] + lanes[1] + vec_uint64_sum_scalar(data + i, n - i);
+}
+
+#elif defined(ICE_SIMD_NEON)
+
+// --- NEON kernels
+
+static size_t vec_uint64_find_neon(const uint64_t * data, size_t n, uint64_t val) {
+    const uint64x2_t needle = vdupq_n_u64(val);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const uint64x2_t eq = vceqq_u64(vld1q_u64(data + i), needle);
+        if ((vgetq_lane_u64(eq, 0) | vgetq_lane_u64(eq, 1)) != 0) {
+            break;
+        }
+    }
+    return i + vec_uint64_find_scalar(data + i, n - i, val);
+}
+
+static size_t vec_uint64_count_neon(const uint64_t * data, size_t n, uint64_t val) {
+    const uint64x2_t needle = vdupq_n_u64(val);
+    uint64x2_t acc = vdupq_n_u64(0);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        acc = vsubq_u64(acc, vceqq_u64(vld1q_u64(data + i), needle));
+    }
+    return vaddvq_u64(acc) + vec_uint64_count_scalar(data + i, n - i, val);
+}
+
+static uint64_t vec_uint64_min_neon(const uint64_t * data, size_t n) {
+    uint64x2_t acc = vdupq_n_u64(data[0]);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const uint64x2_t x = vld1q_u64(data + i);
+        acc = vbslq_u64(vcgtq_u64(acc, x), x, acc);
+    }
+    uint64_t lanes[2];
+    vst1q_u64(lanes, acc);
+    return vec_uint64_min_scalar(data + i, n - i, vec_uint64_min_scalar(lanes, 2, lanes[0]));
+}
+
+static uint64_t vec_uint64_max_neon(const uint64_t * data, size_t n) {
+    uint64x2_t acc = vdupq_n_u64(data[0]);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const uint64x2_t x = vld1q_u64(data + i);
+        acc = vbslq_u64(vcgtq_u64(x, acc), x, acc);
+    }
+    uint64_t lanes[2];
+    vst1q_u64(lanes, acc);
+    return vec_uint64_max_scalar(data + i, n - i, vec_uint64_max_scalar(lanes, 2, lanes[0]));
+}
+
+static uint64_t vec_uint64_sum_neon(const uint64_t * data, size_t n) {
+    uint64x2_t acc = vdupq_n_u64(0);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        acc = vaddq_u64(acc, vld1q_u64(data + i));
+    }
+    return vaddvq_u64(acc) + vec_uint64_sum_scalar(data + i, n - i);
+}
+
+#endif
+
+// --- Dispatch
+
+size_t vec_uint64_find(vec_uint64 v, uint64_t val) {
+#if defined(ICE_SIMD_X86)
+    if (ice_cpu_has_avx2()) {
+        return vec_uint64_find_avx2(v->data, v->len, val);
+    } else if (ice_cpu_has_sse4()) {
+        return vec_uint64_find_sse4(v->data, v->len, val);
+    }
+#elif defined(ICE_SIMD_NEON)
+    return vec_uint64_find_neon(v->data, v->len, val);
+#endif
+    return vec_uint64_find_scalar(v->data, v->len, val);
+}
+
+size_t vec_uint64_count(vec_uint64 v, uint64_t val) {
+#if defined(ICE_SIMD_X86)
+    if (ice_cpu_has_avx2()) {
+        return vec_uint64_count_avx2(v->data, v->len, val);
+    } else if (ice_cpu_has_sse4()) {
+        return vec_uint64_count_sse4(v->data, v->len, val);
+    }
+#elif defined(ICE_SIMD_NEON)
+    return vec_uint64_count_neon(v->data, v->len, val);
+#endif
+    return vec_uint64_count_scalar(v->data, v->len, val);
+}
+
+col_error_t vec_uint64_min(vec_uint64 v, uint64_t * res) {
+    if (v->len <= 0) {
+        return COL_ERR_UNDERFLOW;
+    }
+#if defined(ICE_SIMD_X86)
+    if (ice_cpu_has_avx2()) {
+        *res = vec_uint64_min_avx2(v->data, v->len);
+        return COL_OK;
+    } else if (ice_cpu_has_sse4()) {
+        *res = vec_uint64_min_sse4(v->data, v->len);
+        return COL_OK;
+    }
+#elif defined(ICE_SIMD_NEON)
+    *res = vec_uint64_min_neon(v->data, v->len);
+    return COL_OK;
+#endif
+    *res = vec_uint64_min_scalar(v->data, v->len, v->data[0]);
+    return COL_OK;
+}
+
+col_error_t vec_uint64_max(vec_uint64 v, uint64_t * res) {
+    if (v->len <= 0) {
+        return COL_ERR_UNDERFLOW;
+    }
+#if defined(ICE_SIMD_X86)
+    if (ice_cpu_has_avx2()) {
+        *res = vec_uint64_max_avx2(v->data, v->len);
+        return COL_OK;
+    } else if (ice_cpu_has_sse4()) {
+        *res = vec_uint64_max_sse4(v->data, v->len);
+        return COL_OK;
+    }
+#elif defined(ICE_SIMD_NEON)
+    *res = vec_uint64_max_neon(v->data, v->len);
+    return COL_OK;
+#endif
+    *res = vec_uint64_max_scalar(v->data, v->len, v->data[0]);
+    return COL_OK;
+}
+
+uint64_t vec_uint64_sum(vec_uint64 v) {
+#if defined(ICE_SIMD_X86)
+    if (ice_cpu_has_avx2()) {
+        return vec_uint64_sum_avx2(v->data, v->len);
+    } else if (ice_cpu_has_sse4()) {
+        return vec_uint64_sum_sse4(v->data, v->len);
+    }
+#elif defined(ICE_SIMD_NEON)
+    return vec_uint64_sum_neon(v->data, v->len);
+#endif
+    return vec_uint64_sum_scalar(v->data, v->len);
+}
+
+// --- Sort
+
+col_error_t vec_uint64_sort(vec_uint64 v) {
+    return ice_radix_sort_u64(v->data, v->len, NULL, 0);
+}
+
+col_error_t vec_uint64_sort_kv(vec_uint64 v, void * payload, size_t payload_size) {
+    return ice_radix_sort_u64(v->data, v->len, payload, payload_size);
+}
@@ -34,6 +34,52 @@ extern "C" {
 #include "vec_macros.h"
 
 makeVecOfTypeApi(uint64, uint64_t)
+makeVecSortedApi(uint64, uint64_t)
+makeHeapOfTypeApi(uint64, uint64_t)
+
+/**
+ * The following functions are SIMD kernels selected by runtime CPU
+ * dispatch (AVX2, SSE4, NEON or a scalar fallback).
+ */
+
+/**
+ * Index of the first element equal to val or vec_uint64_len(v) if
+ * there is no such element.
+ */
+size_t vec_uint64_find(vec_uint64 v, uint64_t val);
+
+/**
+ * Number of elements equal to val.
+ */
+size_t vec_uint64_count(vec_uint64 v, uint64_t val);
+
+/**
+ * Smallest element of v. Returns COL_ERR_UNDERFLOW if v is empty.
+ */
+col_error_t vec_uint64_min(vec_uint64 v, uint64_t* res);
+
+/**
+ * Largest element of v. Returns COL_ERR_UNDERFLOW if v is empty.
+ */
+col_error_t vec_uint64_max(vec_uint64 v, uint64_t* res);
+
+/**
+ * Sum of all elements. The sum wraps around on overflow.
+ */
+uint64_t vec_uint64_sum(vec_uint64 v);
+
+/**
+ * Sort the vector ascending using a LSD radix sort. Large vectors are
+ * sorted by several threads, see ice_sort.h.
+ */
+col_error_t vec_uint64_sort(vec_uint64 v);
+
+/**
+ * Sort the vector ascending and permute a parallel payload the same way.
+ * payload points to vec_uint64_len(v) elements of payload_size bytes, e.g.
+ * vec_uintptr_data(values). Elements with equal keys keep their order.
+ */
+col_error_t vec_uint64_sort_kv(vec_uint64 v, void* payload, size_t payload_size);
 
 #ifdef __cplusplus
 };
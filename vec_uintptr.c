@@ -28,3 +28,4 @@
 #include "vec_uintptr.h"
 
 makeVecOfTypeImpl(uintptr, uintptr_t)
+makeDequeOfTypeImpl(uintptr, uintptr_t)
@@ -34,6 +34,7 @@ extern "C" {
 #include "vec_macros.h"
 
 makeVecOfTypeApi(uintptr, uintptr_t)
+makeDequeOfTypeApi(uintptr, uintptr_t)
 
 #ifdef __cplusplus
 };